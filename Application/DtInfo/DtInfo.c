@@ -13,6 +13,7 @@
 #include <Library/UefiApplicationEntryPoint.h>
 #include <Library/FbpAppUtilsLib.h>
 #include <Library/DebugLib.h>
+#include <Protocol/DtDmaStats.h>
 
 STATIC
 EFI_STATUS
@@ -20,7 +21,7 @@ Usage (
   IN CHAR16  *Name
   )
 {
-  Print (L"Usage: %s controller\n", Name);
+  Print (L"Usage: %s [-d] controller\n", Name);
   return EFI_INVALID_PARAMETER;
 }
 
@@ -150,6 +151,53 @@ DtInfo (
   return EFI_SUCCESS;
 }
 
+STATIC
+EFI_STATUS
+DtDmaInfo (
+  IN EFI_HANDLE  Handle
+  )
+{
+  EFI_STATUS                 Status;
+  EFI_DT_DMA_STATS_PROTOCOL  *DmaStatsProtocol;
+  EFI_DT_DMA_STATS           Stats;
+
+  Status = gBS->HandleProtocol (
+                  Handle,
+                  &gEfiDtDmaStatsProtocolGuid,
+                  (VOID **)&DmaStatsProtocol
+                  );
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Status = DmaStatsProtocol->GetStats (DmaStatsProtocol, &Stats);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  #define P(x, y)  Print (L"%18a: %lu\n", (x), (y))
+
+  P ("MapCalls", Stats.MapCalls);
+  P ("UnmapCalls", Stats.UnmapCalls);
+  P ("ZeroCopyMaps", Stats.ZeroCopyMaps);
+  P ("BouncedMaps", Stats.BouncedMaps);
+  P ("BouncedToDevice", Stats.BytesBouncedToDevice);
+  P ("BouncedFromDevice", Stats.BytesBouncedFromDevice);
+  P ("BounceCopyNs", Stats.BounceCopyNs);
+  P ("OutstandingMaps", Stats.OutstandingMaps);
+  P ("PeakMaps", Stats.PeakOutstandingMaps);
+  P ("AllocBufferCalls", Stats.AllocateBufferCalls);
+  P ("AllocBufferPages", Stats.AllocateBufferPages);
+  P ("OutstandingPages", Stats.OutstandingBufferPages);
+  P ("BounceCacheHits", Stats.BounceCacheHits);
+  P ("AllocPoolCalls", Stats.AllocatePoolBufferCalls);
+  P ("OutstandingPool", Stats.OutstandingPoolBuffers);
+
+  #undef P
+
+  return EFI_SUCCESS;
+}
+
 EFI_STATUS
 EFIAPI
 EntryPoint (
@@ -162,6 +210,8 @@ EntryPoint (
   EFI_STATUS          Status;
   GET_OPT_CONTEXT     GetOptContext;
   EFI_DT_IO_PROTOCOL  *DtIo;
+  EFI_HANDLE          Handle;
+  BOOLEAN             DmaStats;
 
   Status = GetShellArgcArgv (ImageHandle, &Argc, &Argv);
   if (EFI_ERROR (Status)) {
@@ -171,6 +221,7 @@ EntryPoint (
     return Status;
   }
 
+  DmaStats = FALSE;
   INIT_GET_OPT_CONTEXT (&GetOptContext);
   while ((Status = GetOpt (
                      Argc,
@@ -180,6 +231,9 @@ EntryPoint (
                      )) == EFI_SUCCESS)
   {
     switch (GetOptContext.Opt) {
+      case L'd':
+        DmaStats = TRUE;
+        break;
       default:
         Print (L"Unknown option '%c'\n", GetOptContext.Opt);
         return Usage (Argv[0]);
@@ -193,7 +247,7 @@ EntryPoint (
   Status = FbpAppLookup (
              Argv[GetOptContext.OptIndex],
              &DtIo,
-             NULL
+             &Handle
              );
   if (EFI_ERROR (Status)) {
     //
@@ -209,6 +263,18 @@ EntryPoint (
       Argv[GetOptContext.OptIndex],
       Status
       );
+    return Status;
+  }
+
+  if (DmaStats) {
+    Status = DtDmaInfo (Handle);
+    if (EFI_ERROR (Status)) {
+      Print (
+        L"Can't dump DMA stats on '%s': %r\n",
+        Argv[GetOptContext.OptIndex],
+        Status
+        );
+    }
   }
 
   return Status;
@@ -0,0 +1,220 @@
+/** @file
+
+    Copyright (c) 2024, Intel Corporation. All rights reserved.<BR>
+
+    SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Uefi.h>
+#include <Library/UefiLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/UefiApplicationEntryPoint.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/FbpAppUtilsLib.h>
+#include <Library/DebugLib.h>
+#include <Protocol/DtInterruptStats.h>
+
+STATIC
+EFI_STATUS
+Usage (
+  IN CHAR16  *Name
+  )
+{
+  Print (L"Usage: %s [-r] [interrupt controller]\n", Name);
+  return EFI_INVALID_PARAMETER;
+}
+
+STATIC
+EFI_STATUS
+DtIntInfo (
+  IN EFI_HANDLE  Handle,
+  IN BOOLEAN     Reset
+  )
+{
+  EFI_STATUS                       Status;
+  EFI_DT_INTERRUPT_STATS_PROTOCOL  *StatsProtocol;
+  EFI_DT_IO_PROTOCOL               *DtIo;
+  EFI_DT_INTERRUPT_STATS           *Stats;
+  EFI_DT_INTERRUPT_STATS           *Stat;
+  UINTN                            Count;
+  UINTN                            Index;
+  UINT64                           Unhandled;
+
+  Status = gBS->HandleProtocol (
+                  Handle,
+                  &gEfiDtInterruptStatsProtocolGuid,
+                  (VOID **)&StatsProtocol
+                  );
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Status = gBS->HandleProtocol (Handle, &gEfiDtIoProtocolGuid, (VOID **)&DtIo);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  //
+  // Handlers may be registered between the two calls.
+  //
+  Stats = NULL;
+  Count = 0;
+  do {
+    if (Stats != NULL) {
+      FreePool (Stats);
+    }
+
+    Stats = NULL;
+    if (Count != 0) {
+      Stats = AllocatePool (Count * sizeof (EFI_DT_INTERRUPT_STATS));
+      if (Stats == NULL) {
+        return EFI_OUT_OF_RESOURCES;
+      }
+    }
+
+    Status = StatsProtocol->GetStats (StatsProtocol, &Count, Stats, &Unhandled);
+  } while (Status == EFI_BUFFER_TOO_SMALL);
+
+  if (EFI_ERROR (Status)) {
+    goto out;
+  }
+
+  Print (L"%s: %lu unhandled\n", DtIo->ComponentName, Unhandled);
+  if (Count != 0) {
+    Print (
+      L"%6a %3a %12a %10a %10a %10a %10a %12a\n",
+      "Source",
+      "En",
+      "Interrupts",
+      "Spurious",
+      "MinNs",
+      "AvgNs",
+      "MaxNs",
+      "FirstIntNs"
+      );
+  }
+
+  for (Index = 0; Index < Count; Index++) {
+    Stat = &Stats[Index];
+    Print (
+      L"%6lu %3a %12lu %10lu %10lu %10lu %10lu %12lu\n",
+      Stat->Source,
+      Stat->Enabled ? "Y" : "N",
+      Stat->Interrupts,
+      Stat->SpuriousClaims,
+      Stat->HandlerMinNs,
+      Stat->Interrupts != 0 ? DivU64x64Remainder (Stat->HandlerTotalNs, Stat->Interrupts, NULL) : 0,
+      Stat->HandlerMaxNs,
+      Stat->FirstInterruptLatencyNs
+      );
+  }
+
+  if (Reset) {
+    Status = StatsProtocol->ResetStats (StatsProtocol);
+  }
+
+out:
+  if (Stats != NULL) {
+    FreePool (Stats);
+  }
+
+  return Status;
+}
+
+EFI_STATUS
+EFIAPI
+EntryPoint (
+  IN EFI_HANDLE        ImageHandle,
+  IN EFI_SYSTEM_TABLE  *SystemTable
+  )
+{
+  UINTN               Argc;
+  CHAR16              **Argv;
+  EFI_STATUS          Status;
+  GET_OPT_CONTEXT     GetOptContext;
+  EFI_DT_IO_PROTOCOL  *DtIo;
+  EFI_HANDLE          Handle;
+  EFI_HANDLE          *Handles;
+  UINTN               HandleCount;
+  UINTN               Index;
+  BOOLEAN             Reset;
+
+  Status = GetShellArgcArgv (ImageHandle, &Argc, &Argv);
+  if (EFI_ERROR (Status)) {
+    //
+    // Already logged error.
+    //
+    return Status;
+  }
+
+  Reset = FALSE;
+  INIT_GET_OPT_CONTEXT (&GetOptContext);
+  while ((Status = GetOpt (
+                     Argc,
+                     Argv,
+                     L"",
+                     &GetOptContext
+                     )) == EFI_SUCCESS)
+  {
+    switch (GetOptContext.Opt) {
+      case L'r':
+        Reset = TRUE;
+        break;
+      default:
+        Print (L"Unknown option '%c'\n", GetOptContext.Opt);
+        return Usage (Argv[0]);
+    }
+  }
+
+  if (Argc - GetOptContext.OptIndex > 1) {
+    return Usage (Argv[0]);
+  }
+
+  if (Argc - GetOptContext.OptIndex == 1) {
+    Status = FbpAppLookup (
+               Argv[GetOptContext.OptIndex],
+               &DtIo,
+               &Handle
+               );
+    if (EFI_ERROR (Status)) {
+      //
+      // Already logged the error in FbpAppLookup.
+      //
+      return Status;
+    }
+
+    Status = DtIntInfo (Handle, Reset);
+    if (EFI_ERROR (Status)) {
+      Print (
+        L"Can't dump interrupt stats on '%s': %r\n",
+        Argv[GetOptContext.OptIndex],
+        Status
+        );
+    }
+
+    return Status;
+  }
+
+  Status = gBS->LocateHandleBuffer (
+                  ByProtocol,
+                  &gEfiDtInterruptStatsProtocolGuid,
+                  NULL,
+                  &HandleCount,
+                  &Handles
+                  );
+  if (EFI_ERROR (Status)) {
+    Print (L"No interrupt controllers report statistics: %r\n", Status);
+    return Status;
+  }
+
+  for (Index = 0; Index < HandleCount; Index++) {
+    Status = DtIntInfo (Handles[Index], Reset);
+    if (EFI_ERROR (Status)) {
+      Print (L"Can't dump interrupt stats on handle %p: %r\n", Handles[Index], Status);
+    }
+  }
+
+  FreePool (Handles);
+  return EFI_SUCCESS;
+}
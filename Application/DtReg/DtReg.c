@@ -13,7 +13,10 @@
 #include <Library/UefiApplicationEntryPoint.h>
 #include <Library/MemoryAllocationLib.h>
 #include <Library/FbpAppUtilsLib.h>
+#include <Library/FbpUtilsLib.h>
 #include <Library/DebugLib.h>
+#include <Library/IoLib.h>
+#include <Library/TimerLib.h>
 
 STATIC
 EFI_STATUS
@@ -21,10 +24,91 @@ Usage (
   IN CHAR16  *Name
   )
 {
-  Print (L"Usage: %s [-i reg index|name] [-n count] [-w access width] controller offset [set value]\n", Name);
+  Print (L"Usage: %s [-b] [-i reg index|name] [-n count] [-w access width] controller offset [set value]\n", Name);
   return EFI_INVALID_PARAMETER;
 }
 
+/**
+  Compare the per-access cost of DtIo->ReadReg with a direct MMIO read
+  of the same register, e.g. to see what a driver gains by validating
+  the window once and bypassing DtIo.
+
+  @param DtIo         EFI_DT_IO_PROTOCOL *.
+  @param Reg          Register region.
+  @param Offset       Offset into Reg.
+  @param AccessWidth  1, 2, 4 or 8.
+  @param IoWidth      EFI_DT_IO_PROTOCOL_WIDTH matching AccessWidth.
+  @param Count        Number of reads to time.
+
+  @retval EFI_STATUS  EFI_SUCCESS or error.
+
+**/
+STATIC
+EFI_STATUS
+Benchmark (
+  IN  EFI_DT_IO_PROTOCOL        *DtIo,
+  IN  EFI_DT_REG                *Reg,
+  IN  UINTN                     Offset,
+  IN  UINTN                     AccessWidth,
+  IN  EFI_DT_IO_PROTOCOL_WIDTH  IoWidth,
+  IN  UINTN                     Count
+  )
+{
+  EFI_STATUS            Status;
+  EFI_PHYSICAL_ADDRESS  Address;
+  UINT64                Value;
+  UINT64                Start;
+  UINT64                ReadRegNs;
+  UINT64                DirectNs;
+  UINTN                 Index;
+
+  if (Count == 0) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Start = GetPerformanceCounter ();
+  for (Index = 0; Index < Count; Index++) {
+    Status = DtIo->ReadReg (DtIo, IoWidth, Reg, Offset, 1, &Value);
+    if (EFI_ERROR (Status)) {
+      Print (L"ReadReg at offset 0x%lx failed: %r\n", Offset, Status);
+      return Status;
+    }
+  }
+
+  ReadRegNs = GetTimeInNanoSecond (GetPerformanceCounter () - Start);
+  Print (L"ReadReg:     %lu ns/access\n", DivU64x64Remainder (ReadRegNs, Count, NULL));
+
+  Status = FbpRegToPhysicalAddress (Reg, &Address);
+  if (EFI_ERROR (Status)) {
+    Print (L"Direct MMIO: n/a, region is not CPU-addressable\n");
+    return EFI_SUCCESS;
+  }
+
+  Address += Offset;
+  Start    = GetPerformanceCounter ();
+  for (Index = 0; Index < Count; Index++) {
+    switch (AccessWidth) {
+      case 1:
+        MmioRead8 ((UINTN)Address);
+        break;
+      case 2:
+        MmioRead16 ((UINTN)Address);
+        break;
+      case 4:
+        MmioRead32 ((UINTN)Address);
+        break;
+      default:
+        MmioRead64 ((UINTN)Address);
+        break;
+    }
+  }
+
+  DirectNs = GetTimeInNanoSecond (GetPerformanceCounter () - Start);
+  Print (L"Direct MMIO: %lu ns/access\n", DivU64x64Remainder (DirectNs, Count, NULL));
+
+  return EFI_SUCCESS;
+}
+
 EFI_STATUS
 EFIAPI
 EntryPoint (
@@ -46,6 +130,7 @@ EntryPoint (
   UINTN                     Offset;
   BOOLEAN                   Set;
   UINTN                     SetValue;
+  BOOLEAN                   Bench;
 
   Status = GetShellArgcArgv (ImageHandle, &Argc, &Argv);
   if (EFI_ERROR (Status)) {
@@ -60,6 +145,7 @@ EntryPoint (
   RegIndex    = 0;
   RegName     = NULL;
   Set         = FALSE;
+  Bench       = FALSE;
   INIT_GET_OPT_CONTEXT (&GetOptContext);
   while ((Status = GetOpt (
                      Argc,
@@ -69,6 +155,9 @@ EntryPoint (
                      )) == EFI_SUCCESS)
   {
     switch (GetOptContext.Opt) {
+      case L'b':
+        Bench = TRUE;
+        break;
       case L'i':
         if (GetOptContext.OptArg == NULL) {
           return Usage (Argv[0]);
@@ -115,6 +204,13 @@ EntryPoint (
   }
 
   if (Argc - GetOptContext.OptIndex == 3) {
+    if (Bench) {
+      //
+      // Only reads are timed, writes may well have side effects.
+      //
+      return Usage (Argv[0]);
+    }
+
     Set      = TRUE;
     SetValue = StrHexOrDecToUintn (Argv[GetOptContext.OptIndex + 2]);
   }
@@ -160,6 +256,18 @@ EntryPoint (
     FreePool (RegName);
   }
 
+  if (Bench) {
+    Print (
+      L"Timing %lu reads of %lu bytes at offset 0x%lx of reg ",
+      Count,
+      AccessWidth,
+      Offset
+      );
+    PrintDtReg (&Reg, FALSE);
+    Print (L":\n");
+    return Benchmark (DtIo, &Reg, Offset, AccessWidth, IoWidth, Count);
+  }
+
   if (!Set) {
     Print (
       L"Dumping %lu bytes at offset 0x%lx of reg ",
@@ -0,0 +1,524 @@
+/** @file
+
+    Copyright (c) 2024, Intel Corporation. All rights reserved.<BR>
+
+    SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Uefi.h>
+#include <Library/UefiLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/UefiApplicationEntryPoint.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/FbpAppUtilsLib.h>
+#include <Library/DebugLib.h>
+#include <Library/TimerLib.h>
+#include <Protocol/SerialIo.h>
+
+#define MAX_CONFIGS  8
+
+typedef struct {
+  UINT64    WriteBytesPerSec;
+  UINT64    WriteMinNs;
+  UINT64    WriteAvgNs;
+  UINT64    WriteMaxNs;
+  UINT64    ReadBytesPerSec;
+  UINTN     ReadErrors;
+} BENCH_RESULT;
+
+STATIC
+EFI_STATUS
+Usage (
+  IN CHAR16  *Name
+  )
+{
+  Print (L"Usage: %s [-b baud]... [-f fifo depth]... [-s size] [-c chunk] [-r|-l] controller\n", Name);
+  return EFI_INVALID_PARAMETER;
+}
+
+/**
+  Find the EFI_SERIAL_IO_PROTOCOL for a DT controller, which is either
+  on the controller handle itself or on a child handle (PciSioSerialDxe).
+
+  @param[in]  Handle    DT controller handle.
+  @param[out] SerialIo  EFI_SERIAL_IO_PROTOCOL *.
+
+  @retval EFI_STATUS    EFI_SUCCESS or error.
+
+**/
+STATIC
+EFI_STATUS
+FindSerialIo (
+  IN  EFI_HANDLE              Handle,
+  OUT EFI_SERIAL_IO_PROTOCOL  **SerialIo
+  )
+{
+  EFI_STATUS                           Status;
+  EFI_OPEN_PROTOCOL_INFORMATION_ENTRY  *Info;
+  UINTN                                Count;
+  UINTN                                Index;
+
+  Status = gBS->HandleProtocol (Handle, &gEfiSerialIoProtocolGuid, (VOID **)SerialIo);
+  if (!EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Status = gBS->OpenProtocolInformation (Handle, &gEfiDtIoProtocolGuid, &Info, &Count);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Status = EFI_NOT_FOUND;
+  for (Index = 0; Index < Count; Index++) {
+    if ((Info[Index].Attributes & EFI_OPEN_PROTOCOL_BY_CHILD_CONTROLLER) == 0) {
+      continue;
+    }
+
+    Status = gBS->HandleProtocol (
+                    Info[Index].ControllerHandle,
+                    &gEfiSerialIoProtocolGuid,
+                    (VOID **)SerialIo
+                    );
+    if (!EFI_ERROR (Status)) {
+      break;
+    }
+  }
+
+  FreePool (Info);
+  return Status;
+}
+
+/**
+  Measure sustained write throughput and per-call latency.
+
+  @param[in]  SerialIo  EFI_SERIAL_IO_PROTOCOL *.
+  @param[in]  Buffer    Data to write.
+  @param[in]  Size      Total bytes to write.
+  @param[in]  Chunk     Bytes per Write() call.
+  @param[out] Result    Results.
+
+  @retval EFI_STATUS    EFI_SUCCESS or error.
+
+**/
+STATIC
+EFI_STATUS
+MeasureWrite (
+  IN  EFI_SERIAL_IO_PROTOCOL  *SerialIo,
+  IN  UINT8                   *Buffer,
+  IN  UINTN                   Size,
+  IN  UINTN                   Chunk,
+  OUT BENCH_RESULT            *Result
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       Offset;
+  UINTN       Length;
+  UINTN       Calls;
+  UINT64      Start;
+  UINT64      Ns;
+  UINT64      TotalNs;
+
+  Result->WriteMinNs = MAX_UINT64;
+  Result->WriteMaxNs = 0;
+  TotalNs            = 0;
+  Calls              = 0;
+
+  for (Offset = 0; Offset < Size; Offset += Length) {
+    Length = MIN (Chunk, Size - Offset);
+    Start  = GetPerformanceCounter ();
+    Status = SerialIo->Write (SerialIo, &Length, Buffer + Offset);
+    Ns     = GetTimeInNanoSecond (GetPerformanceCounter () - Start);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    Result->WriteMinNs = MIN (Result->WriteMinNs, Ns);
+    Result->WriteMaxNs = MAX (Result->WriteMaxNs, Ns);
+    TotalNs           += Ns;
+    Calls++;
+  }
+
+  Result->WriteAvgNs       = DivU64x64Remainder (TotalNs, Calls, NULL);
+  Result->WriteBytesPerSec = TotalNs != 0 ? DivU64x64Remainder ((UINT64)Size * 1000000000, TotalNs, NULL) : 0;
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Measure read throughput, by writing data that comes back either via
+  the UART's loopback mode or via a peer echoing everything back.
+
+  Data is written and read back one chunk at a time, so nothing is lost
+  to receive FIFO overruns.
+
+  @param[in]  SerialIo  EFI_SERIAL_IO_PROTOCOL *.
+  @param[in]  Buffer    Data to write.
+  @param[in]  Readback  Buffer of Size bytes to read into.
+  @param[in]  Size      Total bytes to transfer.
+  @param[in]  Chunk     Bytes per Write() and Read() call.
+  @param[out] Result    Results.
+
+  @retval EFI_STATUS    EFI_SUCCESS or error.
+
+**/
+STATIC
+EFI_STATUS
+MeasureRead (
+  IN  EFI_SERIAL_IO_PROTOCOL  *SerialIo,
+  IN  UINT8                   *Buffer,
+  IN  UINT8                   *Readback,
+  IN  UINTN                   Size,
+  IN  UINTN                   Chunk,
+  OUT BENCH_RESULT            *Result
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       Offset;
+  UINTN       Length;
+  UINTN       Index;
+  UINT64      Start;
+  UINT64      TotalNs;
+
+  Result->ReadErrors = 0;
+  SetMem (Readback, Size, 0);
+
+  Start = GetPerformanceCounter ();
+  for (Offset = 0; Offset < Size; Offset += Chunk) {
+    Length = MIN (Chunk, Size - Offset);
+    Status = SerialIo->Write (SerialIo, &Length, Buffer + Offset);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    Length = MIN (Chunk, Size - Offset);
+    Status = SerialIo->Read (SerialIo, &Length, Readback + Offset);
+    if (EFI_ERROR (Status) && (Status != EFI_TIMEOUT)) {
+      return Status;
+    }
+
+    //
+    // A short read counts the missing bytes as errors.
+    //
+    Result->ReadErrors += MIN (Chunk, Size - Offset) - Length;
+  }
+
+  TotalNs = GetTimeInNanoSecond (GetPerformanceCounter () - Start);
+
+  for (Index = 0; Index < Size; Index++) {
+    if (Readback[Index] != Buffer[Index]) {
+      Result->ReadErrors++;
+    }
+  }
+
+  Result->ReadBytesPerSec = TotalNs != 0 ? DivU64x64Remainder ((UINT64)Size * 1000000000, TotalNs, NULL) : 0;
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Run the benchmark for one baud rate and FIFO depth.
+
+  @param[in]  SerialIo  EFI_SERIAL_IO_PROTOCOL *.
+  @param[in]  BaudRate  Baud rate.
+  @param[in]  FifoDepth Receive FIFO depth.
+  @param[in]  Buffer    Data to write.
+  @param[in]  Readback  Buffer to read into, NULL to skip the read test.
+  @param[in]  Size      Total bytes to transfer.
+  @param[in]  Chunk     Bytes per Write() and Read() call.
+  @param[in]  Loopback  Use hardware loopback for the read test.
+  @param[in]  Control   Control bits to restore after the read test.
+
+  @retval EFI_STATUS    EFI_SUCCESS or error.
+
+**/
+STATIC
+EFI_STATUS
+RunConfig (
+  IN  EFI_SERIAL_IO_PROTOCOL  *SerialIo,
+  IN  UINT64                  BaudRate,
+  IN  UINT32                  FifoDepth,
+  IN  UINT8                   *Buffer,
+  IN  UINT8                   *Readback OPTIONAL,
+  IN  UINTN                   Size,
+  IN  UINTN                   Chunk,
+  IN  BOOLEAN                 Loopback,
+  IN  UINT32                  Control
+  )
+{
+  EFI_STATUS    Status;
+  BENCH_RESULT  Result;
+
+  ZeroMem (&Result, sizeof (Result));
+
+  Status = SerialIo->SetAttributes (
+                       SerialIo,
+                       BaudRate,
+                       FifoDepth,
+                       SerialIo->Mode->Timeout,
+                       (EFI_PARITY_TYPE)SerialIo->Mode->Parity,
+                       (UINT8)SerialIo->Mode->DataBits,
+                       (EFI_STOP_BITS_TYPE)SerialIo->Mode->StopBits
+                       );
+  if (EFI_ERROR (Status)) {
+    Print (L"SetAttributes(%lu, %u): %r\n", BaudRate, FifoDepth, Status);
+    return Status;
+  }
+
+  Status = MeasureWrite (SerialIo, Buffer, Size, Chunk, &Result);
+  if (EFI_ERROR (Status)) {
+    Print (L"Write at %lu baud: %r\n", BaudRate, Status);
+    return Status;
+  }
+
+  if (Readback != NULL) {
+    if (Loopback) {
+      Status = SerialIo->SetControl (SerialIo, Control | EFI_SERIAL_HARDWARE_LOOPBACK_ENABLE);
+      if (EFI_ERROR (Status)) {
+        Print (L"SetControl(loopback): %r\n", Status);
+        return Status;
+      }
+    }
+
+    Status = MeasureRead (SerialIo, Buffer, Readback, Size, Chunk, &Result);
+
+    if (Loopback) {
+      SerialIo->SetControl (SerialIo, Control);
+    }
+
+    if (EFI_ERROR (Status)) {
+      Print (L"Read at %lu baud: %r\n", BaudRate, Status);
+      return Status;
+    }
+  }
+
+  Print (
+    L"%8lu %4u %10lu %10lu %10lu %10lu",
+    BaudRate,
+    SerialIo->Mode->ReceiveFifoDepth,
+    Result.WriteBytesPerSec,
+    Result.WriteMinNs,
+    Result.WriteAvgNs,
+    Result.WriteMaxNs
+    );
+  if (Readback != NULL) {
+    Print (L" %10lu %8u\n", Result.ReadBytesPerSec, Result.ReadErrors);
+  } else {
+    Print (L" %10a %8a\n", "-", "-");
+  }
+
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+EFIAPI
+EntryPoint (
+  IN EFI_HANDLE        ImageHandle,
+  IN EFI_SYSTEM_TABLE  *SystemTable
+  )
+{
+  UINTN                   Argc;
+  CHAR16                  **Argv;
+  EFI_STATUS              Status;
+  GET_OPT_CONTEXT         GetOptContext;
+  EFI_DT_IO_PROTOCOL      *DtIo;
+  EFI_HANDLE              Handle;
+  EFI_SERIAL_IO_PROTOCOL  *SerialIo;
+  EFI_SERIAL_IO_MODE      SavedMode;
+  UINT32                  SavedControl;
+  UINT64                  BaudRates[MAX_CONFIGS];
+  UINTN                   BaudRateCount;
+  UINT32                  FifoDepths[MAX_CONFIGS];
+  UINTN                   FifoDepthCount;
+  UINTN                   Size;
+  UINTN                   Chunk;
+  BOOLEAN                 Read;
+  BOOLEAN                 Loopback;
+  UINT8                   *Buffer;
+  UINT8                   *Readback;
+  UINTN                   Index;
+  UINTN                   BaudIndex;
+  UINTN                   FifoIndex;
+
+  Status = GetShellArgcArgv (ImageHandle, &Argc, &Argv);
+  if (EFI_ERROR (Status)) {
+    //
+    // Already logged error.
+    //
+    return Status;
+  }
+
+  BaudRateCount  = 0;
+  FifoDepthCount = 0;
+  Size           = SIZE_4KB;
+  Chunk          = 64;
+  Read           = FALSE;
+  Loopback       = FALSE;
+  INIT_GET_OPT_CONTEXT (&GetOptContext);
+  while ((Status = GetOpt (
+                     Argc,
+                     Argv,
+                     L"bfsc",
+                     &GetOptContext
+                     )) == EFI_SUCCESS)
+  {
+    switch (GetOptContext.Opt) {
+      case L'b':
+        if ((GetOptContext.OptArg == NULL) || (BaudRateCount == MAX_CONFIGS)) {
+          return Usage (Argv[0]);
+        }
+
+        BaudRates[BaudRateCount++] = StrHexOrDecToUintn (GetOptContext.OptArg);
+        break;
+      case L'f':
+        if ((GetOptContext.OptArg == NULL) || (FifoDepthCount == MAX_CONFIGS)) {
+          return Usage (Argv[0]);
+        }
+
+        FifoDepths[FifoDepthCount++] = (UINT32)StrHexOrDecToUintn (GetOptContext.OptArg);
+        break;
+      case L's':
+        if (GetOptContext.OptArg == NULL) {
+          return Usage (Argv[0]);
+        }
+
+        Size = StrHexOrDecToUintn (GetOptContext.OptArg);
+        break;
+      case L'c':
+        if (GetOptContext.OptArg == NULL) {
+          return Usage (Argv[0]);
+        }
+
+        Chunk = StrHexOrDecToUintn (GetOptContext.OptArg);
+        break;
+      case L'r':
+        Read = TRUE;
+        break;
+      case L'l':
+        Read     = TRUE;
+        Loopback = TRUE;
+        break;
+      default:
+        Print (L"Unknown option '%c'\n", GetOptContext.Opt);
+        return Usage (Argv[0]);
+    }
+  }
+
+  if ((Argc - GetOptContext.OptIndex != 1) || (Size == 0) || (Chunk == 0)) {
+    return Usage (Argv[0]);
+  }
+
+  Status = FbpAppLookup (
+             Argv[GetOptContext.OptIndex],
+             &DtIo,
+             &Handle
+             );
+  if (EFI_ERROR (Status)) {
+    //
+    // Already logged the error in FbpAppLookup.
+    //
+    return Status;
+  }
+
+  Status = FindSerialIo (Handle, &SerialIo);
+  if (EFI_ERROR (Status)) {
+    Print (L"No EFI_SERIAL_IO_PROTOCOL for '%s': %r\n", Argv[GetOptContext.OptIndex], Status);
+    return Status;
+  }
+
+  CopyMem (&SavedMode, SerialIo->Mode, sizeof (SavedMode));
+  Status = SerialIo->GetControl (SerialIo, &SavedControl);
+  if (EFI_ERROR (Status)) {
+    Print (L"GetControl: %r\n", Status);
+    return Status;
+  }
+
+  //
+  // Only the bits SetControl takes.
+  //
+  SavedControl &= EFI_SERIAL_REQUEST_TO_SEND | EFI_SERIAL_DATA_TERMINAL_READY |
+                  EFI_SERIAL_HARDWARE_LOOPBACK_ENABLE | EFI_SERIAL_SOFTWARE_LOOPBACK_ENABLE |
+                  EFI_SERIAL_HARDWARE_FLOW_CONTROL_ENABLE;
+
+  if (BaudRateCount == 0) {
+    BaudRates[BaudRateCount++] = SavedMode.BaudRate;
+  }
+
+  if (FifoDepthCount == 0) {
+    FifoDepths[FifoDepthCount++] = SavedMode.ReceiveFifoDepth;
+  }
+
+  Buffer   = AllocatePool (Size);
+  Readback = Read ? AllocatePool (Size) : NULL;
+  if ((Buffer == NULL) || (Read && (Readback == NULL))) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto out;
+  }
+
+  //
+  // Printable, so the write test doesn't upset a terminal on the other end.
+  //
+  for (Index = 0; Index < Size; Index++) {
+    Buffer[Index] = (UINT8)(' ' + Index % ('~' - ' ' + 1));
+  }
+
+  Print (
+    L"%s: %lu bytes, %lu bytes per call%s\n",
+    Argv[GetOptContext.OptIndex],
+    Size,
+    Chunk,
+    Loopback ? L", hardware loopback" : (Read ? L", peer echo" : L"")
+    );
+  Print (
+    L"%8a %4a %10a %10a %10a %10a %10a %8a\n",
+    "Baud",
+    "Fifo",
+    "WrBytes/s",
+    "WrMinNs",
+    "WrAvgNs",
+    "WrMaxNs",
+    "RdBytes/s",
+    "RdErrors"
+    );
+
+  for (BaudIndex = 0; BaudIndex < BaudRateCount; BaudIndex++) {
+    for (FifoIndex = 0; FifoIndex < FifoDepthCount; FifoIndex++) {
+      Status = RunConfig (
+                 SerialIo,
+                 BaudRates[BaudIndex],
+                 FifoDepths[FifoIndex],
+                 Buffer,
+                 Readback,
+                 Size,
+                 Chunk,
+                 Loopback,
+                 SavedControl
+                 );
+      if (EFI_ERROR (Status)) {
+        goto out;
+      }
+    }
+  }
+
+out:
+  SerialIo->SetAttributes (
+              SerialIo,
+              SavedMode.BaudRate,
+              SavedMode.ReceiveFifoDepth,
+              SavedMode.Timeout,
+              (EFI_PARITY_TYPE)SavedMode.Parity,
+              (UINT8)SavedMode.DataBits,
+              (EFI_STOP_BITS_TYPE)SavedMode.StopBits
+              );
+
+  if (Buffer != NULL) {
+    FreePool (Buffer);
+  }
+
+  if (Readback != NULL) {
+    FreePool (Readback);
+  }
+
+  return Status;
+}
@@ -119,6 +119,15 @@ DriverSupported (
     // CPUs container.
     //
     Status = EFI_SUCCESS;
+  } else if ((DtIo->DeviceType != NULL) &&
+             (AsciiStrCmp (DtIo->DeviceType, "cpu") == 0) &&
+             (AsciiStrCmp (DtDevice->Parent->DtIo.Name, "cpus") == 0))
+  {
+    //
+    // CPU node. Its children include the per-hart interrupt controller,
+    // referenced by external interrupt controller nodes.
+    //
+    Status = EFI_SUCCESS;
   } else if ((DtDevice->Flags & DT_DEVICE_TEST_UNIT) != 0) {
     //
     // Test device.
@@ -42,6 +42,8 @@ DtDeviceCreateDmaInit (
     return Status;
   }
 
+  DtDevice->DmaRegion = DmaRegionFromDevice (DtDevice);
+
   //
   // DT_DEVICE_NON_IDENTITY_DMA is "sticky", being inherited. This allows
   // optimizing for the common scenario of non-crazy hardware (which don't
@@ -305,10 +307,15 @@ DtDeviceCreate (
   //
   // DMA operations.
   //
-  DtDevice->DtIo.Map            = DtIoMap;
-  DtDevice->DtIo.Unmap          = DtIoUnmap;
-  DtDevice->DtIo.AllocateBuffer = DtIoAllocateBuffer;
-  DtDevice->DtIo.FreeBuffer     = DtIoFreeBuffer;
+  DtDevice->DtIo.Map                = DtIoMap;
+  DtDevice->DtIo.Unmap              = DtIoUnmap;
+  DtDevice->DtIo.AllocateBuffer     = DtIoAllocateBuffer;
+  DtDevice->DtIo.FreeBuffer         = DtIoFreeBuffer;
+  DtDevice->DtIo.AllocatePoolBuffer = DtIoAllocatePoolBuffer;
+  DtDevice->DtIo.FreePoolBuffer     = DtIoFreePoolBuffer;
+
+  DtDevice->DmaStatsProtocol.GetStats   = DtDmaStatsGet;
+  DtDevice->DmaStatsProtocol.ResetStats = DtDmaStatsReset;
 
   *Out = DtDevice;
   return EFI_SUCCESS;
@@ -335,6 +342,7 @@ DtDeviceCleanup (
     RemoveEntryList (&DtDevice->Link);
   }
 
+  DtDmaBounceCacheFlush (DtDevice);
   FreePool (DtDevice->DtIo.ComponentName);
   FreePool (DtDevice->DevicePath);
   FreePool (DtDevice);
@@ -380,6 +388,8 @@ DtDeviceUnregister (
                   DtDevice->DevicePath,
                   &gEfiDtIoProtocolGuid,
                   &DtDevice->DtIo,
+                  &gEfiDtDmaStatsProtocolGuid,
+                  &DtDevice->DmaStatsProtocol,
                   NULL
                   );
 
@@ -525,7 +535,8 @@ DtDeviceRegister (
                   DtDevice->DevicePath,
                   &gEfiDtIoProtocolGuid,
                   &DtDevice->DtIo,
-                  NULL,
+                  &gEfiDtDmaStatsProtocolGuid,
+                  &DtDevice->DmaStatsProtocol,
                   NULL
                   );
   if (EFI_ERROR (Status)) {
@@ -554,6 +565,8 @@ DtDeviceRegister (
            DtDevice->DevicePath,
            &gEfiDtIoProtocolGuid,
            &DtDevice->DtIo,
+           &gEfiDtDmaStatsProtocolGuid,
+           &DtDevice->DmaStatsProtocol,
            NULL
            );
   }
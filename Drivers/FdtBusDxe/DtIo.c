@@ -28,6 +28,11 @@ STATIC_ASSERT (_ (FillUint64));
 STATIC_ASSERT (_ (Maximum));
 #undef _
 
+//
+// Smallest DtIoCopyReg worth checking for the direct memory copy path.
+//
+#define DT_IO_COPY_DIRECT_MIN  64
+
 /**
   Looks up an EFI_DT_IO_PROTOCOL handle given a DT path or alias, optionally
   connecting any missing drivers along the way.
@@ -551,6 +556,44 @@ DtIoReadReg (
                         );
 }
 
+/**
+  Returns whether a CPU-addressable range is backed by cacheable, memory-like
+  GCD space, i.e. whether it can be accessed with arbitrarily-sized loads and
+  stores rather than with exact-width MMIO accesses.
+
+  @param  Address               Start of the range.
+  @param  Length                Length of the range.
+
+  @retval TRUE                  Range is memory-like.
+  @retval FALSE                 Range is (or may be) device memory.
+
+**/
+STATIC
+BOOLEAN
+DtIoIsMemoryLike (
+  IN  EFI_PHYSICAL_ADDRESS  Address,
+  IN  UINTN                 Length
+  )
+{
+  EFI_STATUS                       Status;
+  EFI_GCD_MEMORY_SPACE_DESCRIPTOR  GcdDescriptor;
+
+  Status = gDS->GetMemorySpaceDescriptor (Address, &GcdDescriptor);
+  if (EFI_ERROR (Status)) {
+    return FALSE;
+  }
+
+  if ((GcdDescriptor.GcdMemoryType == EfiGcdMemoryTypeNonExistent) ||
+      (GcdDescriptor.GcdMemoryType == EfiGcdMemoryTypeMemoryMappedIo) ||
+      ((GcdDescriptor.Attributes & EFI_MEMORY_UC) != 0) ||
+      ((GcdDescriptor.Attributes & (EFI_MEMORY_WB | EFI_MEMORY_WT | EFI_MEMORY_WC)) == 0))
+  {
+    return FALSE;
+  }
+
+  return (Address + Length) <= (GcdDescriptor.BaseAddress + GcdDescriptor.Length);
+}
+
 /**
   Enables a driver to copy one region of device register space to another region of device
   register space.
@@ -600,6 +643,32 @@ DtIoCopyReg (
   }
 
   BufferSize = DT_IO_PROTOCOL_WIDTH (Width) * Count;
+
+  //
+  // Copies between plain memory (e.g. buffers in reserved memory or
+  // RAM exposed as a device) don't need to go through exact-width
+  // accesses and a temporary buffer.
+  //
+  if ((BufferSize >= DT_IO_COPY_DIRECT_MIN) &&
+      (Width <= EfiDtIoWidthUint64) &&
+      (DestReg->BusDtIo == NULL) && (SrcReg->BusDtIo == NULL) &&
+      (DestOffset + BufferSize <= DestReg->Length) &&
+      (SrcOffset + BufferSize <= SrcReg->Length))
+  {
+    EFI_PHYSICAL_ADDRESS  DestAddress;
+    EFI_PHYSICAL_ADDRESS  SrcAddress;
+
+    DestAddress = DestReg->TranslatedBase + DestOffset;
+    SrcAddress  = SrcReg->TranslatedBase + SrcOffset;
+    if ((((DestAddress | SrcAddress) & (DT_IO_PROTOCOL_WIDTH (Width) - 1)) == 0) &&
+        DtIoIsMemoryLike (DestAddress, BufferSize) &&
+        DtIoIsMemoryLike (SrcAddress, BufferSize))
+    {
+      FbpCopyMem ((VOID *)DestAddress, (VOID *)SrcAddress, BufferSize);
+      return EFI_SUCCESS;
+    }
+  }
+
   if (BufferSize == 0) {
     //
     // We don't want to return EFI_SUCCESS on Count == 0, but
@@ -610,12 +679,6 @@ DtIoCopyReg (
     BufferSize++;
   }
 
-  /*
-   * Consider an implementation that doesn't use a temporary buffer.
-   * Of course, it will have to deal with potentially overlapping
-   * source/destination regions if DestReg == SrcReg.
-   */
-
   Buffer = AllocateZeroPool (BufferSize);
   if (Buffer == NULL) {
     return EFI_OUT_OF_RESOURCES;
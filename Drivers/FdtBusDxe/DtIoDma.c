@@ -10,6 +10,422 @@
 
 #define KNOWN_CONSTRAINTS  (EFI_DT_IO_DMA_WITH_MAX_ADDRESS | EFI_DT_IO_DMA_NON_COHERENT)
 
+//
+// DMA statistics and the list of bounced mappings are updated at
+// TPL_NOTIFY, as the DMA operations may be used from event
+// notification functions.
+//
+
+/**
+  Account for a successful Map().
+
+  @param  DtDevice              DT_DEVICE *.
+  @param  Bounced               TRUE if a bounce buffer was used.
+
+**/
+STATIC
+VOID
+DtDmaStatsMapped (
+  IN  DT_DEVICE  *DtDevice,
+  IN  BOOLEAN    Bounced
+  )
+{
+  EFI_DT_DMA_STATS  *Stats;
+  EFI_TPL           Tpl;
+
+  Stats = &DtDevice->DmaStats;
+  Tpl   = gBS->RaiseTPL (TPL_NOTIFY);
+  Stats->MapCalls++;
+  if (Bounced) {
+    Stats->BouncedMaps++;
+  } else {
+    Stats->ZeroCopyMaps++;
+  }
+
+  Stats->OutstandingMaps++;
+  if (Stats->OutstandingMaps > Stats->PeakOutstandingMaps) {
+    Stats->PeakOutstandingMaps = Stats->OutstandingMaps;
+  }
+
+  gBS->RestoreTPL (Tpl);
+}
+
+/**
+  Account for a successful Unmap().
+
+  @param  DtDevice              DT_DEVICE *.
+
+**/
+STATIC
+VOID
+DtDmaStatsUnmapped (
+  IN  DT_DEVICE  *DtDevice
+  )
+{
+  EFI_TPL  Tpl;
+
+  Tpl = gBS->RaiseTPL (TPL_NOTIFY);
+  DtDevice->DmaStats.UnmapCalls++;
+  if (DtDevice->DmaStats.OutstandingMaps != 0) {
+    DtDevice->DmaStats.OutstandingMaps--;
+  }
+
+  gBS->RestoreTPL (Tpl);
+}
+
+/**
+  Account for a bounce copy.
+
+  @param  DtDevice              DT_DEVICE *.
+  @param  StartTick             Performance counter value at start of copy.
+  @param  BytesToDevice         Bytes copied into the bounce buffer.
+  @param  BytesFromDevice       Bytes copied out of the bounce buffer.
+
+**/
+STATIC
+VOID
+DtDmaStatsBounced (
+  IN  DT_DEVICE  *DtDevice,
+  IN  UINT64     StartTick,
+  IN  UINTN      BytesToDevice,
+  IN  UINTN      BytesFromDevice
+  )
+{
+  UINT64   PerfStart;
+  UINT64   PerfEnd;
+  UINT64   Ticks;
+  EFI_TPL  Tpl;
+
+  GetPerformanceCounterProperties (&PerfStart, &PerfEnd);
+  Ticks = GetElapsedTick (&StartTick, PerfStart, PerfEnd);
+
+  Tpl                                        = gBS->RaiseTPL (TPL_NOTIFY);
+  DtDevice->BounceCopyTicks                 += Ticks;
+  DtDevice->DmaStats.BytesBouncedToDevice   += BytesToDevice;
+  DtDevice->DmaStats.BytesBouncedFromDevice += BytesFromDevice;
+  gBS->RestoreTPL (Tpl);
+}
+
+/**
+  Account for a successful AllocateBuffer() or FreeBuffer().
+
+  @param  DtDevice              DT_DEVICE *.
+  @param  Pages                 Pages allocated or freed.
+  @param  Allocated             TRUE for AllocateBuffer().
+
+**/
+STATIC
+VOID
+DtDmaStatsBuffer (
+  IN  DT_DEVICE  *DtDevice,
+  IN  UINTN      Pages,
+  IN  BOOLEAN    Allocated
+  )
+{
+  EFI_DT_DMA_STATS  *Stats;
+  EFI_TPL           Tpl;
+
+  Stats = &DtDevice->DmaStats;
+  Tpl   = gBS->RaiseTPL (TPL_NOTIFY);
+  if (Allocated) {
+    Stats->AllocateBufferCalls++;
+    Stats->AllocateBufferPages    += Pages;
+    Stats->OutstandingBufferPages += Pages;
+  } else if (Stats->OutstandingBufferPages >= Pages) {
+    Stats->OutstandingBufferPages -= Pages;
+  } else {
+    Stats->OutstandingBufferPages = 0;
+  }
+
+  gBS->RestoreTPL (Tpl);
+}
+
+/**
+  Account for a successful AllocatePoolBuffer() or FreePoolBuffer().
+
+  @param  DtDevice              DT_DEVICE *.
+  @param  Allocated             TRUE for AllocatePoolBuffer().
+
+**/
+VOID
+DtDmaStatsPoolBuffer (
+  IN  DT_DEVICE  *DtDevice,
+  IN  BOOLEAN    Allocated
+  )
+{
+  EFI_DT_DMA_STATS  *Stats;
+  EFI_TPL           Tpl;
+
+  Stats = &DtDevice->DmaStats;
+  Tpl   = gBS->RaiseTPL (TPL_NOTIFY);
+  if (Allocated) {
+    Stats->AllocatePoolBufferCalls++;
+    Stats->OutstandingPoolBuffers++;
+  } else if (Stats->OutstandingPoolBuffers != 0) {
+    Stats->OutstandingPoolBuffers--;
+  }
+
+  gBS->RestoreTPL (Tpl);
+}
+
+/**
+  Combine the DMA constraints of a DT_DEVICE with the optional extra
+  constraints passed by a caller of the DMA operations.
+
+  @param  DtDevice              DT_DEVICE *.
+  @param  ExtraConstraints      Additional optional DMA constraints.
+  @param  MaxAddress            Maximum CPU address usable for DMA.
+  @param  IsCoherent            TRUE if DMA is cache coherent.
+
+  @retval EFI_SUCCESS           Success.
+  @retval EFI_INVALID_PARAMETER Unknown constraint flags.
+
+**/
+EFI_STATUS
+DtDeviceGetDmaConstraints (
+  IN  DT_DEVICE                     *DtDevice,
+  IN  EFI_DT_IO_PROTOCOL_DMA_EXTRA  *ExtraConstraints OPTIONAL,
+  OUT EFI_PHYSICAL_ADDRESS          *MaxAddress,
+  OUT BOOLEAN                       *IsCoherent
+  )
+{
+  *MaxAddress = DtDevice->MaxCpuDmaAddress;
+  *IsCoherent = DtDevice->DtIo.IsDmaCoherent;
+  if (ExtraConstraints != NULL) {
+    if ((ExtraConstraints->Flags & ~KNOWN_CONSTRAINTS) != 0) {
+      return EFI_INVALID_PARAMETER;
+    }
+
+    if ((ExtraConstraints->Flags & EFI_DT_IO_DMA_WITH_MAX_ADDRESS) != 0) {
+      *MaxAddress = MIN (*MaxAddress, ExtraConstraints->MaxAddress);
+    }
+
+    if ((ExtraConstraints->Flags & EFI_DT_IO_DMA_NON_COHERENT) != 0) {
+      *IsCoherent = FALSE;
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Allocate pages for DMA, preferring the shared-dma-pool region
+  the device references (if any). Only EfiBootServicesData requests
+  are served out of the region, as its memory type is fixed when the
+  region is claimed.
+
+  @param  Region                DMA_REGION * or NULL.
+  @param  MemoryType            The type of memory to allocate.
+  @param  Pages                 The number of pages to allocate.
+  @param  MaxAddress            Maximum CPU address usable for DMA.
+  @param  Address               Allocated address.
+
+  @retval EFI_SUCCESS           Success.
+  @retval Others                Errors.
+
+**/
+EFI_STATUS
+DtDmaAllocatePages (
+  IN  DMA_REGION            *Region OPTIONAL,
+  IN  EFI_MEMORY_TYPE       MemoryType,
+  IN  UINTN                 Pages,
+  IN  EFI_PHYSICAL_ADDRESS  MaxAddress,
+  OUT EFI_PHYSICAL_ADDRESS  *Address
+  )
+{
+  if ((Region != NULL) && (MemoryType == EfiBootServicesData)) {
+    if (!EFI_ERROR (DmaRegionAllocatePages (Region, Pages, MaxAddress, Address))) {
+      return EFI_SUCCESS;
+    }
+
+    DEBUG ((DEBUG_WARN, "%a: DMA pool exhausted, falling back\n", __func__));
+  }
+
+  *Address = MaxAddress;
+  return gBS->AllocatePages (
+                AllocateMaxAddress,
+                MemoryType,
+                Pages,
+                Address
+                );
+}
+
+/**
+  Free pages allocated with DtDmaAllocatePages.
+
+  @param  Region                DMA_REGION * or NULL.
+  @param  Address               Address.
+  @param  Pages                 The number of pages to free.
+
+  @retval EFI_SUCCESS           Success.
+  @retval EFI_NOT_FOUND         The range was not allocated.
+
+**/
+EFI_STATUS
+DtDmaFreePages (
+  IN  DMA_REGION            *Region OPTIONAL,
+  IN  EFI_PHYSICAL_ADDRESS  Address,
+  IN  UINTN                 Pages
+  )
+{
+  if ((Region != NULL) && DmaRegionContains (Region, Address)) {
+    return DmaRegionFreePages (Region, Address, Pages);
+  }
+
+  return gBS->FreePages (Address, Pages);
+}
+
+/**
+  Return the bounce cache size class for a page count.
+
+  @param  Pages                 The number of pages.
+
+  @retval DT_BOUNCE_CACHE_CLASSES  Too large to be cached.
+  @retval Others                   Class, holding 1 << Class pages.
+
+**/
+STATIC
+UINTN
+DtDmaBounceClass (
+  IN  UINTN  Pages
+  )
+{
+  UINTN  Class;
+
+  for (Class = 0; Class < DT_BOUNCE_CACHE_CLASSES; Class++) {
+    if (Pages <= (1U << Class)) {
+      break;
+    }
+  }
+
+  return Class;
+}
+
+/**
+  Allocate bounce pages for a Map(), reusing cached pages when possible.
+
+  Pages are only cached for devices without a shared-dma-pool region,
+  as the region is already a cheap allocator and its pages are a scarce
+  resource. For the rest, gBS->AllocatePages with AllocateMaxAddress
+  walks the memory map on every call, which dominates small I/Os.
+
+  @param  DtDevice              DT_DEVICE *.
+  @param  MaxAddress            Maximum CPU address usable for DMA.
+  @param  Pages                 On input the number of pages needed. On output
+                                the number of pages allocated.
+  @param  Address               Allocated address.
+
+  @retval EFI_SUCCESS           Success.
+  @retval Others                Errors.
+
+**/
+STATIC
+EFI_STATUS
+DtDmaBounceAllocate (
+  IN      DT_DEVICE             *DtDevice,
+  IN      EFI_PHYSICAL_ADDRESS  MaxAddress,
+  IN  OUT UINTN                 *Pages,
+  OUT     EFI_PHYSICAL_ADDRESS  *Address
+  )
+{
+  UINTN                 Class;
+  EFI_PHYSICAL_ADDRESS  Head;
+  EFI_TPL               Tpl;
+
+  Class = DtDmaBounceClass (*Pages);
+  if ((DtDevice->DmaRegion == NULL) && (Class < DT_BOUNCE_CACHE_CLASSES)) {
+    *Pages = 1U << Class;
+
+    Tpl  = gBS->RaiseTPL (TPL_NOTIFY);
+    Head = DtDevice->BounceCache[Class];
+    if ((Head != 0) && ((Head + EFI_PAGES_TO_SIZE (*Pages) - 1) <= MaxAddress)) {
+      DtDevice->BounceCache[Class]  = *(EFI_PHYSICAL_ADDRESS *)(UINTN)Head;
+      DtDevice->BounceCachePages   -= *Pages;
+      DtDevice->DmaStats.BounceCacheHits++;
+      gBS->RestoreTPL (Tpl);
+
+      *Address = Head;
+      return EFI_SUCCESS;
+    }
+
+    gBS->RestoreTPL (Tpl);
+  }
+
+  return DtDmaAllocatePages (
+           DtDevice->DmaRegion,
+           EfiBootServicesData,
+           *Pages,
+           MaxAddress,
+           Address
+           );
+}
+
+/**
+  Release bounce pages allocated with DtDmaBounceAllocate, caching
+  them for reuse unless that would exceed PcdDmaBounceCachePages.
+
+  @param  DtDevice              DT_DEVICE *.
+  @param  Address               Address.
+  @param  Pages                 The number of pages.
+
+**/
+STATIC
+VOID
+DtDmaBounceFree (
+  IN  DT_DEVICE             *DtDevice,
+  IN  EFI_PHYSICAL_ADDRESS  Address,
+  IN  UINTN                 Pages
+  )
+{
+  UINTN    Class;
+  EFI_TPL  Tpl;
+
+  Class = DtDmaBounceClass (Pages);
+  if ((DtDevice->DmaRegion == NULL) &&
+      (Class < DT_BOUNCE_CACHE_CLASSES) &&
+      (Pages == (1U << Class)) &&
+      (Address != 0))
+  {
+    Tpl = gBS->RaiseTPL (TPL_NOTIFY);
+    if ((DtDevice->BounceCachePages + Pages) <= PcdGet32 (PcdDmaBounceCachePages)) {
+      *(EFI_PHYSICAL_ADDRESS *)(UINTN)Address = DtDevice->BounceCache[Class];
+      DtDevice->BounceCache[Class]            = Address;
+      DtDevice->BounceCachePages             += Pages;
+      gBS->RestoreTPL (Tpl);
+      return;
+    }
+
+    gBS->RestoreTPL (Tpl);
+  }
+
+  DtDmaFreePages (DtDevice->DmaRegion, Address, Pages);
+}
+
+/**
+  Free all cached bounce pages of a device.
+
+  @param  DtDevice              DT_DEVICE *.
+
+**/
+VOID
+DtDmaBounceCacheFlush (
+  IN  DT_DEVICE  *DtDevice
+  )
+{
+  UINTN                 Class;
+  EFI_PHYSICAL_ADDRESS  Address;
+
+  for (Class = 0; Class < DT_BOUNCE_CACHE_CLASSES; Class++) {
+    while (DtDevice->BounceCache[Class] != 0) {
+      Address                      = DtDevice->BounceCache[Class];
+      DtDevice->BounceCache[Class] = *(EFI_PHYSICAL_ADDRESS *)(UINTN)Address;
+      gBS->FreePages (Address, 1U << Class);
+    }
+  }
+
+  DtDevice->BounceCachePages = 0;
+}
+
 /**
   Provides the device-specific addresses needed to access system memory.
 
@@ -48,6 +464,9 @@ DtIoMap (
   MAP_INFO              *MapInfo;
   DT_DEVICE             *DtDevice;
   BOOLEAN               IsCoherent;
+  UINTN                 ZeroStart;
+  UINT64                Tick;
+  EFI_TPL               Tpl;
 
   if ((This == NULL) ||
       (Operation >= EfiDtIoDmaOperationMaximum) ||
@@ -66,20 +485,9 @@ DtIoMap (
     return EFI_UNSUPPORTED;
   }
 
-  MaxAddress = DtDevice->MaxCpuDmaAddress;
-  IsCoherent = This->IsDmaCoherent;
-  if (ExtraConstraints != NULL) {
-    if ((ExtraConstraints->Flags & ~KNOWN_CONSTRAINTS) != 0) {
-      return EFI_INVALID_PARAMETER;
-    }
-
-    if ((ExtraConstraints->Flags & EFI_DT_IO_DMA_WITH_MAX_ADDRESS) != 0) {
-      MaxAddress = MIN (MaxAddress, ExtraConstraints->MaxAddress);
-    }
-
-    if ((ExtraConstraints->Flags & EFI_DT_IO_DMA_NON_COHERENT) != 0) {
-      IsCoherent = FALSE;
-    }
+  Status = DtDeviceGetDmaConstraints (DtDevice, ExtraConstraints, &MaxAddress, &IsCoherent);
+  if (EFI_ERROR (Status)) {
+    return Status;
   }
 
   if (!IsCoherent) {
@@ -106,7 +514,7 @@ DtIoMap (
     MapInfo = AllocatePool (sizeof (MAP_INFO));
     if (MapInfo == NULL) {
       Status = EFI_OUT_OF_RESOURCES;
-      DEBUG ((DEBUG_ERROR, "%a: MAP_INFO: %r\n", Status));
+      DEBUG ((DEBUG_ERROR, "%a: MAP_INFO: %r\n", __func__, Status));
       return Status;
     }
 
@@ -115,34 +523,44 @@ DtIoMap (
     MapInfo->NumberOfBytes     = *NumberOfBytes;
     MapInfo->NumberOfPages     = EFI_SIZE_TO_PAGES (*NumberOfBytes);
     MapInfo->HostAddress       = PhysicalAddress;
-    MapInfo->MappedHostAddress = MaxAddress;
-
-    Status = gBS->AllocatePages (
-                    AllocateMaxAddress,
-                    EfiBootServicesData,
-                    MapInfo->NumberOfPages,
-                    &MapInfo->MappedHostAddress
-                    );
+
+    Status = DtDmaBounceAllocate (
+               DtDevice,
+               MaxAddress,
+               &MapInfo->NumberOfPages,
+               &MapInfo->MappedHostAddress
+               );
     if (EFI_ERROR (Status)) {
       FreePool (MapInfo);
-      DEBUG ((DEBUG_ERROR, "%a: AllocatePages: %r\n", Status));
+      DEBUG ((DEBUG_ERROR, "%a: DtDmaBounceAllocate: %r\n", __func__, Status));
       return Status;
     }
 
-    ZeroMem (
-      (VOID *)MapInfo->MappedHostAddress,
-      EFI_PAGES_TO_SIZE (MapInfo->NumberOfPages)
-      );
-
+    //
+    // Only the part of the bounce pages not overwritten with the
+    // caller's data needs zeroing.
+    //
+    Tick      = GetPerformanceCounter ();
+    ZeroStart = 0;
     if (Operation == EfiDtIoDmaOperationBusMasterRead) {
-      CopyMem (
+      FbpCopyMem (
         (VOID *)MapInfo->MappedHostAddress,
         (VOID *)MapInfo->HostAddress,
         MapInfo->NumberOfBytes
         );
+      ZeroStart = MapInfo->NumberOfBytes;
     }
 
+    FbpZeroMem (
+      (VOID *)(MapInfo->MappedHostAddress + ZeroStart),
+      EFI_PAGES_TO_SIZE (MapInfo->NumberOfPages) - ZeroStart
+      );
+    DtDmaStatsBounced (DtDevice, Tick, ZeroStart, 0);
+
+    Tpl = gBS->RaiseTPL (TPL_NOTIFY);
     InsertTailList (&DtDevice->Maps, &MapInfo->Link);
+    DtDmaStatsMapped (DtDevice, TRUE);
+    gBS->RestoreTPL (Tpl);
 
     *DeviceAddress = MapInfo->MappedHostAddress;
     *Mapping       = MapInfo;
@@ -151,6 +569,7 @@ DtIoMap (
 
   *DeviceAddress = PhysicalAddress;
   *Mapping       = NO_MAPPING;
+  DtDmaStatsMapped (DtDevice, FALSE);
 
   return EFI_SUCCESS;
 }
@@ -175,6 +594,8 @@ DtIoUnmap (
   MAP_INFO    *MapInfo;
   LIST_ENTRY  *Link;
   DT_DEVICE   *DtDevice;
+  UINT64      Tick;
+  EFI_TPL     Tpl;
 
   if ((This == NULL) || (Mapping == NULL)) {
     return EFI_INVALID_PARAMETER;
@@ -183,10 +604,12 @@ DtIoUnmap (
   DtDevice = DT_DEV_FROM_THIS (This);
 
   if (Mapping == NO_MAPPING) {
+    DtDmaStatsUnmapped (DtDevice);
     return EFI_SUCCESS;
   }
 
   MapInfo = NO_MAPPING;
+  Tpl     = gBS->RaiseTPL (TPL_NOTIFY);
   for (Link = GetFirstNode (&DtDevice->Maps)
        ; !IsNull (&DtDevice->Maps, Link)
        ; Link = GetNextNode (&DtDevice->Maps, Link)
@@ -202,10 +625,13 @@ DtIoUnmap (
   // Mapping is not a valid value returned by Map().
   //
   if (MapInfo != Mapping) {
+    gBS->RestoreTPL (Tpl);
     return EFI_INVALID_PARAMETER;
   }
 
   RemoveEntryList (&MapInfo->Link);
+  DtDmaStatsUnmapped (DtDevice);
+  gBS->RestoreTPL (Tpl);
 
   //
   // If this is a write operation from the Bus Master's point of view,
@@ -213,17 +639,19 @@ DtIoUnmap (
   // so the processor can read the contents of the real buffer.
   //
   if (MapInfo->Operation == EfiDtIoDmaOperationBusMasterWrite) {
-    CopyMem (
+    Tick = GetPerformanceCounter ();
+    FbpCopyMem (
       (VOID *)MapInfo->HostAddress,
       (VOID *)MapInfo->MappedHostAddress,
       MapInfo->NumberOfBytes
       );
+    DtDmaStatsBounced (DtDevice, Tick, 0, MapInfo->NumberOfBytes);
   }
 
   //
   // Free the mapped buffer and the MAP_INFO structure.
   //
-  gBS->FreePages (MapInfo->MappedHostAddress, MapInfo->NumberOfPages);
+  DtDmaBounceFree (DtDevice, MapInfo->MappedHostAddress, MapInfo->NumberOfPages);
   FreePool (Mapping);
 
   return EFI_SUCCESS;
@@ -258,6 +686,7 @@ DtIoAllocateBuffer (
 {
   EFI_STATUS            Status;
   EFI_PHYSICAL_ADDRESS  Address;
+  EFI_PHYSICAL_ADDRESS  MaxAddress;
   BOOLEAN               IsCoherent;
   DT_DEVICE             *DtDevice;
 
@@ -278,20 +707,9 @@ DtIoAllocateBuffer (
     return EFI_INVALID_PARAMETER;
   }
 
-  Address    = DtDevice->MaxCpuDmaAddress;
-  IsCoherent = This->IsDmaCoherent;
-  if (ExtraConstraints != NULL) {
-    if ((ExtraConstraints->Flags & ~KNOWN_CONSTRAINTS) != 0) {
-      return EFI_INVALID_PARAMETER;
-    }
-
-    if ((ExtraConstraints->Flags & EFI_DT_IO_DMA_WITH_MAX_ADDRESS) != 0) {
-      Address = MIN (Address, ExtraConstraints->MaxAddress);
-    }
-
-    if ((ExtraConstraints->Flags & EFI_DT_IO_DMA_NON_COHERENT) != 0) {
-      IsCoherent = FALSE;
-    }
+  Status = DtDeviceGetDmaConstraints (DtDevice, ExtraConstraints, &MaxAddress, &IsCoherent);
+  if (EFI_ERROR (Status)) {
+    return Status;
   }
 
   if (!IsCoherent) {
@@ -299,18 +717,20 @@ DtIoAllocateBuffer (
     return EFI_UNSUPPORTED;
   }
 
-  Status = gBS->AllocatePages (
-                  AllocateMaxAddress,
-                  MemoryType,
-                  Pages,
-                  &Address
-                  );
+  Status = DtDmaAllocatePages (
+             DtDevice->DmaRegion,
+             MemoryType,
+             Pages,
+             MaxAddress,
+             &Address
+             );
   if (!EFI_ERROR (Status)) {
-    ZeroMem (
+    FbpZeroMem (
       (VOID *)Address,
       EFI_PAGES_TO_SIZE (Pages)
       );
 
+    DtDmaStatsBuffer (DtDevice, Pages, TRUE);
     *HostAddress = (VOID *)Address;
   }
 
@@ -338,9 +758,97 @@ DtIoFreeBuffer (
   IN  VOID                *HostAddress
   )
 {
+  EFI_STATUS  Status;
+  DT_DEVICE   *DtDevice;
+
   if ((This == NULL) || (Pages == 0)) {
     return EFI_INVALID_PARAMETER;
   }
 
-  return gBS->FreePages ((EFI_PHYSICAL_ADDRESS)HostAddress, Pages);
+  DtDevice = DT_DEV_FROM_THIS (This);
+
+  Status = DtDmaFreePages (DtDevice->DmaRegion, (EFI_PHYSICAL_ADDRESS)HostAddress, Pages);
+  if (!EFI_ERROR (Status)) {
+    DtDmaStatsBuffer (DtDevice, Pages, FALSE);
+  }
+
+  return Status;
+}
+
+/**
+  Get DMA statistics for the device.
+
+  @param This            Instance pointer for this protocol.
+  @param Stats           Where to return the statistics.
+
+  @retval EFI_SUCCESS            Success.
+  @retval EFI_INVALID_PARAMETER  Bad parameter.
+
+**/
+EFI_STATUS
+EFIAPI
+DtDmaStatsGet (
+  IN  EFI_DT_DMA_STATS_PROTOCOL  *This,
+  OUT EFI_DT_DMA_STATS           *Stats
+  )
+{
+  DT_DEVICE  *DtDevice;
+  UINT64     BounceCopyTicks;
+  EFI_TPL    Tpl;
+
+  if ((This == NULL) || (Stats == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  DtDevice = DT_DEV_FROM_DMA_STATS (This);
+
+  Tpl = gBS->RaiseTPL (TPL_NOTIFY);
+  CopyMem (Stats, &DtDevice->DmaStats, sizeof (EFI_DT_DMA_STATS));
+  BounceCopyTicks = DtDevice->BounceCopyTicks;
+  gBS->RestoreTPL (Tpl);
+
+  Stats->BounceCopyNs = GetTimeInNanoSecond (BounceCopyTicks);
+  return EFI_SUCCESS;
+}
+
+/**
+  Reset DMA statistics for the device. Outstanding mapping, page and
+  pool buffer counts reflect live state and are not reset.
+
+  @param This            Instance pointer for this protocol.
+
+  @retval EFI_SUCCESS            Success.
+  @retval EFI_INVALID_PARAMETER  Bad parameter.
+
+**/
+EFI_STATUS
+EFIAPI
+DtDmaStatsReset (
+  IN  EFI_DT_DMA_STATS_PROTOCOL  *This
+  )
+{
+  DT_DEVICE  *DtDevice;
+  UINT64     OutstandingMaps;
+  UINT64     OutstandingBufferPages;
+  UINT64     OutstandingPoolBuffers;
+  EFI_TPL    Tpl;
+
+  if (This == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  DtDevice = DT_DEV_FROM_DMA_STATS (This);
+
+  Tpl                    = gBS->RaiseTPL (TPL_NOTIFY);
+  OutstandingMaps        = DtDevice->DmaStats.OutstandingMaps;
+  OutstandingBufferPages = DtDevice->DmaStats.OutstandingBufferPages;
+  OutstandingPoolBuffers = DtDevice->DmaStats.OutstandingPoolBuffers;
+  ZeroMem (&DtDevice->DmaStats, sizeof (EFI_DT_DMA_STATS));
+  DtDevice->DmaStats.OutstandingMaps        = OutstandingMaps;
+  DtDevice->DmaStats.PeakOutstandingMaps    = OutstandingMaps;
+  DtDevice->DmaStats.OutstandingBufferPages = OutstandingBufferPages;
+  DtDevice->DmaStats.OutstandingPoolBuffers = OutstandingPoolBuffers;
+  DtDevice->BounceCopyTicks                 = 0;
+  gBS->RestoreTPL (Tpl);
+  return EFI_SUCCESS;
 }
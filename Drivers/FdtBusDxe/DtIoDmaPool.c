@@ -0,0 +1,502 @@
+/** @file
+
+    Sub-page DMA buffer allocator.
+
+    Small common buffer allocations (descriptors, completion entries,
+    command blocks) are carved out of page-sized slabs. Slabs are
+    shared by all devices with the same DMA constraints (maximum
+    CPU DMA address, memory type and shared-dma-pool region), and
+    each slab only hands out chunks of a single power-of-two size
+    class. Chunks are thus naturally aligned to their size. One empty
+    slab is kept per size class, so a buffer allocated and freed over
+    and over doesn't cost a page allocation each time.
+
+    Copyright (c) 2024, Intel Corporation. All rights reserved.<BR>
+
+    SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "FdtBusDxe.h"
+
+#define DMA_POOL_MIN_SHIFT   4
+#define DMA_POOL_MAX_SHIFT   (EFI_PAGE_SHIFT - 1)
+#define DMA_POOL_CLASSES     (DMA_POOL_MAX_SHIFT - DMA_POOL_MIN_SHIFT + 1)
+#define DMA_POOL_MAX_CHUNK   (1U << DMA_POOL_MAX_SHIFT)
+#define DMA_POOL_MAP_WORDS   ((EFI_PAGE_SIZE >> DMA_POOL_MIN_SHIFT) / 64)
+
+typedef struct {
+  UINT32                  Signature;
+  LIST_ENTRY              Link;
+  EFI_PHYSICAL_ADDRESS    Base;
+  UINTN                   Shift;
+  UINTN                   FreeChunks;
+  //
+  // Bit set == chunk in use. Bits beyond the number of chunks
+  // in the slab are always set.
+  //
+  UINT64                  InUse[DMA_POOL_MAP_WORDS];
+} DMA_POOL_SLAB;
+
+#define DMA_POOL_SLAB_SIGNATURE  SIGNATURE_32 ('d', 'p', 's', 'l')
+#define DMA_POOL_SLAB_FROM_LINK(a)  CR (a, DMA_POOL_SLAB, Link, DMA_POOL_SLAB_SIGNATURE)
+
+typedef struct {
+  UINT32                  Signature;
+  LIST_ENTRY              Link;
+  EFI_MEMORY_TYPE         MemoryType;
+  EFI_PHYSICAL_ADDRESS    MaxAddress;
+  DMA_REGION              *Region;
+  //
+  // Per size class. Slabs with free chunks are kept at the head.
+  //
+  LIST_ENTRY              Slabs[DMA_POOL_CLASSES];
+  UINTN                   EmptySlabs[DMA_POOL_CLASSES];
+} DMA_POOL_DOMAIN;
+
+#define DMA_POOL_DOMAIN_SIGNATURE  SIGNATURE_32 ('d', 'p', 'd', 'm')
+#define DMA_POOL_DOMAIN_FROM_LINK(a)  CR (a, DMA_POOL_DOMAIN, Link, DMA_POOL_DOMAIN_SIGNATURE)
+
+STATIC LIST_ENTRY  mDmaPoolDomains = INITIALIZE_LIST_HEAD_VARIABLE (mDmaPoolDomains);
+
+/**
+  Find or create the slab domain for a set of DMA constraints.
+
+  @param[in]  MemoryType        EFI_MEMORY_TYPE.
+  @param[in]  MaxAddress        Maximum CPU address usable for DMA.
+  @param[in]  Region            DMA_REGION * or NULL.
+
+  @retval NULL                  Out of resources.
+  @retval Others                DMA_POOL_DOMAIN *.
+
+**/
+STATIC
+DMA_POOL_DOMAIN *
+DmaPoolGetDomain (
+  IN  EFI_MEMORY_TYPE       MemoryType,
+  IN  EFI_PHYSICAL_ADDRESS  MaxAddress,
+  IN  DMA_REGION            *Region OPTIONAL
+  )
+{
+  LIST_ENTRY       *Link;
+  DMA_POOL_DOMAIN  *Domain;
+  UINTN            Index;
+
+  for (Link = GetFirstNode (&mDmaPoolDomains)
+       ; !IsNull (&mDmaPoolDomains, Link)
+       ; Link = GetNextNode (&mDmaPoolDomains, Link)
+       )
+  {
+    Domain = DMA_POOL_DOMAIN_FROM_LINK (Link);
+    if ((Domain->MemoryType == MemoryType) &&
+        (Domain->MaxAddress == MaxAddress) &&
+        (Domain->Region == Region))
+    {
+      return Domain;
+    }
+  }
+
+  Domain = AllocateZeroPool (sizeof (DMA_POOL_DOMAIN));
+  if (Domain == NULL) {
+    return NULL;
+  }
+
+  Domain->Signature  = DMA_POOL_DOMAIN_SIGNATURE;
+  Domain->MemoryType = MemoryType;
+  Domain->MaxAddress = MaxAddress;
+  Domain->Region     = Region;
+  for (Index = 0; Index < DMA_POOL_CLASSES; Index++) {
+    InitializeListHead (&Domain->Slabs[Index]);
+  }
+
+  InsertTailList (&mDmaPoolDomains, &Domain->Link);
+  return Domain;
+}
+
+/**
+  Allocate a new slab for a size class in a domain.
+
+  @param[in]  Domain            DMA_POOL_DOMAIN *.
+  @param[in]  Shift             Size class (log2 of chunk size).
+
+  @retval NULL                  Out of resources.
+  @retval Others                DMA_POOL_SLAB *.
+
+**/
+STATIC
+DMA_POOL_SLAB *
+DmaPoolNewSlab (
+  IN  DMA_POOL_DOMAIN  *Domain,
+  IN  UINTN            Shift
+  )
+{
+  EFI_STATUS     Status;
+  DMA_POOL_SLAB  *Slab;
+  UINTN          Chunks;
+  UINTN          Index;
+
+  Slab = AllocateZeroPool (sizeof (DMA_POOL_SLAB));
+  if (Slab == NULL) {
+    return NULL;
+  }
+
+  Status = DtDmaAllocatePages (
+             Domain->Region,
+             Domain->MemoryType,
+             1,
+             Domain->MaxAddress,
+             &Slab->Base
+             );
+  if (EFI_ERROR (Status)) {
+    FreePool (Slab);
+    return NULL;
+  }
+
+  Chunks = EFI_PAGE_SIZE >> Shift;
+  for (Index = Chunks; Index < (DMA_POOL_MAP_WORDS * 64); Index++) {
+    Slab->InUse[Index / 64] |= LShiftU64 (1, Index % 64);
+  }
+
+  Slab->Signature  = DMA_POOL_SLAB_SIGNATURE;
+  Slab->Shift      = Shift;
+  Slab->FreeChunks = Chunks;
+  InsertHeadList (&Domain->Slabs[Shift - DMA_POOL_MIN_SHIFT], &Slab->Link);
+  Domain->EmptySlabs[Shift - DMA_POOL_MIN_SHIFT]++;
+  return Slab;
+}
+
+/**
+  Look up the slab a pool buffer was carved out of.
+
+  @param[in]  Address           Buffer address.
+  @param[in]  MinShift          Smallest size class the buffer could be in.
+  @param[out] OutDomain         Domain owning the slab.
+
+  @retval NULL                  Not found.
+  @retval Others                DMA_POOL_SLAB *.
+
+**/
+STATIC
+DMA_POOL_SLAB *
+DmaPoolFindSlab (
+  IN  EFI_PHYSICAL_ADDRESS  Address,
+  IN  UINTN                 MinShift,
+  OUT DMA_POOL_DOMAIN       **OutDomain
+  )
+{
+  LIST_ENTRY            *DomainLink;
+  LIST_ENTRY            *SlabLink;
+  LIST_ENTRY            *Slabs;
+  DMA_POOL_DOMAIN       *Domain;
+  DMA_POOL_SLAB         *Slab;
+  EFI_PHYSICAL_ADDRESS  Base;
+  UINTN                 Shift;
+
+  Base = ROUND_DOWN (Address, EFI_PAGE_SIZE);
+  for (DomainLink = GetFirstNode (&mDmaPoolDomains)
+       ; !IsNull (&mDmaPoolDomains, DomainLink)
+       ; DomainLink = GetNextNode (&mDmaPoolDomains, DomainLink)
+       )
+  {
+    Domain = DMA_POOL_DOMAIN_FROM_LINK (DomainLink);
+    for (Shift = MinShift; Shift <= DMA_POOL_MAX_SHIFT; Shift++) {
+      Slabs = &Domain->Slabs[Shift - DMA_POOL_MIN_SHIFT];
+      for (SlabLink = GetFirstNode (Slabs)
+           ; !IsNull (Slabs, SlabLink)
+           ; SlabLink = GetNextNode (Slabs, SlabLink)
+           )
+      {
+        Slab = DMA_POOL_SLAB_FROM_LINK (SlabLink);
+        if (Slab->Base == Base) {
+          *OutDomain = Domain;
+          return Slab;
+        }
+      }
+    }
+  }
+
+  return NULL;
+}
+
+/**
+  Return the size class (log2 of chunk size) for a pool allocation.
+
+  @param[in]  Size              Requested size.
+  @param[in]  Alignment         Requested alignment or 0.
+
+  @retval UINTN                 Size class.
+
+**/
+STATIC
+UINTN
+DmaPoolSizeToShift (
+  IN  UINTN  Size,
+  IN  UINTN  Alignment
+  )
+{
+  UINTN  Needed;
+
+  Needed = MAX (Size, Alignment);
+  if (Needed <= (1U << DMA_POOL_MIN_SHIFT)) {
+    return DMA_POOL_MIN_SHIFT;
+  }
+
+  return (UINTN)HighBitSet64 (Needed - 1) + 1;
+}
+
+/**
+  Allocates a buffer smaller than a page that is suitable for an
+  EfiDtIoDmaOperationBusMasterCommonBuffer mapping.
+
+  @param  This                  A pointer to the EFI_DT_IO_PROTOCOL instance.
+  @param  MemoryType            The type of memory to allocate, EfiBootServicesData or
+                                EfiRuntimeServicesData.
+  @param  Size                  The number of bytes to allocate (> 0).
+  @param  Alignment             Required alignment (power of 2 <= EFI_PAGE_SIZE, or 0).
+  @param  ExtraConstraints      Additional optional DMA constraints.
+  @param  HostAddress           A pointer to store the base system memory address of the
+                                allocated buffer.
+
+  @retval EFI_SUCCESS           The requested buffer was allocated.
+  @retval EFI_INVALID_PARAMETER One or more parameters are invalid.
+  @retval EFI_UNSUPPORTED       DMA constraints are not supported.
+  @retval EFI_OUT_OF_RESOURCES  The buffer could not be allocated.
+
+**/
+EFI_STATUS
+EFIAPI
+DtIoAllocatePoolBuffer (
+  IN  EFI_DT_IO_PROTOCOL            *This,
+  IN  EFI_MEMORY_TYPE               MemoryType,
+  IN  UINTN                         Size,
+  IN  UINTN                         Alignment,
+  IN  EFI_DT_IO_PROTOCOL_DMA_EXTRA  *ExtraConstraints OPTIONAL,
+  OUT VOID                          **HostAddress
+  )
+{
+  EFI_STATUS            Status;
+  EFI_PHYSICAL_ADDRESS  MaxAddress;
+  BOOLEAN               IsCoherent;
+  DT_DEVICE             *DtDevice;
+  DMA_POOL_DOMAIN       *Domain;
+  DMA_POOL_SLAB         *Slab;
+  LIST_ENTRY            *Slabs;
+  EFI_TPL               OldTpl;
+  UINTN                 Shift;
+  UINTN                 Word;
+  UINTN                 Bit;
+  VOID                  *Chunk;
+
+  if ((This == NULL) || (Size == 0) || (HostAddress == NULL) ||
+      (Alignment > EFI_PAGE_SIZE) || ((Alignment & (Alignment - 1)) != 0))
+  {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (MAX (Size, Alignment) > DMA_POOL_MAX_CHUNK) {
+    //
+    // Nothing to be gained from sub-page allocation. This includes
+    // small but page-aligned requests, which FreePoolBuffer recognizes
+    // by not being part of any slab.
+    //
+    Status = DtIoAllocateBuffer (
+               This,
+               MemoryType,
+               EFI_SIZE_TO_PAGES (Size),
+               ExtraConstraints,
+               HostAddress
+               );
+    if (!EFI_ERROR (Status)) {
+      DtDmaStatsPoolBuffer (DT_DEV_FROM_THIS (This), TRUE);
+    }
+
+    return Status;
+  }
+
+  DtDevice = DT_DEV_FROM_THIS (This);
+
+  if ((DtDevice->Flags & DT_DEVICE_NON_IDENTITY_DMA) != 0) {
+    DEBUG ((DEBUG_ERROR, "%s: non-identity DMA AllocatePoolBuffer is unsupported\n", This->ComponentName));
+    return EFI_UNSUPPORTED;
+  }
+
+  if ((MemoryType != EfiBootServicesData) &&
+      (MemoryType != EfiRuntimeServicesData))
+  {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Status = DtDeviceGetDmaConstraints (DtDevice, ExtraConstraints, &MaxAddress, &IsCoherent);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  if (!IsCoherent) {
+    DEBUG ((DEBUG_ERROR, "%s: non-coherent DMA AllocatePoolBuffer is unsupported\n", This->ComponentName));
+    return EFI_UNSUPPORTED;
+  }
+
+  Shift  = DmaPoolSizeToShift (Size, Alignment);
+  Chunk  = NULL;
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+
+  Domain = DmaPoolGetDomain (MemoryType, MaxAddress, DtDevice->DmaRegion);
+  if (Domain == NULL) {
+    goto Out;
+  }
+
+  Slabs = &Domain->Slabs[Shift - DMA_POOL_MIN_SHIFT];
+  Slab  = NULL;
+  if (!IsListEmpty (Slabs)) {
+    Slab = DMA_POOL_SLAB_FROM_LINK (GetFirstNode (Slabs));
+    if (Slab->FreeChunks == 0) {
+      Slab = NULL;
+    }
+  }
+
+  if (Slab == NULL) {
+    Slab = DmaPoolNewSlab (Domain, Shift);
+    if (Slab == NULL) {
+      goto Out;
+    }
+  }
+
+  for (Word = 0; Word < DMA_POOL_MAP_WORDS; Word++) {
+    if (Slab->InUse[Word] != MAX_UINT64) {
+      break;
+    }
+  }
+
+  ASSERT (Word < DMA_POOL_MAP_WORDS);
+  if (Slab->FreeChunks == (EFI_PAGE_SIZE >> Shift)) {
+    Domain->EmptySlabs[Shift - DMA_POOL_MIN_SHIFT]--;
+  }
+
+  Bit                = (UINTN)LowBitSet64 (~Slab->InUse[Word]);
+  Slab->InUse[Word] |= LShiftU64 (1, Bit);
+  Slab->FreeChunks--;
+  if (Slab->FreeChunks == 0) {
+    //
+    // Keep slabs with free chunks at the head.
+    //
+    RemoveEntryList (&Slab->Link);
+    InsertTailList (Slabs, &Slab->Link);
+  }
+
+  Chunk = (VOID *)(UINTN)(Slab->Base + (((Word * 64) + Bit) << Shift));
+
+Out:
+  gBS->RestoreTPL (OldTpl);
+
+  if (Chunk == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  ZeroMem (Chunk, Size);
+  DtDmaStatsPoolBuffer (DtDevice, TRUE);
+  *HostAddress = Chunk;
+  return EFI_SUCCESS;
+}
+
+/**
+  Frees memory that was allocated with AllocatePoolBuffer().
+
+  @param  This                  A pointer to the EFI_DT_IO_PROTOCOL instance.
+  @param  Size                  The number of bytes passed to AllocatePoolBuffer().
+  @param  HostAddress           The base system memory address of the allocated buffer.
+
+  @retval EFI_SUCCESS           The requested buffer was freed.
+  @retval EFI_INVALID_PARAMETER One or more parameters are invalid.
+  @retval EFI_NOT_FOUND         The buffer specified by HostAddress and Size
+                                was not allocated with AllocatePoolBuffer().
+
+**/
+EFI_STATUS
+EFIAPI
+DtIoFreePoolBuffer (
+  IN  EFI_DT_IO_PROTOCOL  *This,
+  IN  UINTN               Size,
+  IN  VOID                *HostAddress
+  )
+{
+  EFI_STATUS            Status;
+  EFI_PHYSICAL_ADDRESS  Address;
+  DMA_POOL_DOMAIN       *Domain;
+  DMA_POOL_SLAB         *Slab;
+  LIST_ENTRY            *Slabs;
+  EFI_TPL               OldTpl;
+  UINTN                 Chunk;
+  UINT64                Mask;
+  UINTN                 Pages;
+
+  if ((This == NULL) || (Size == 0)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Address = (EFI_PHYSICAL_ADDRESS)(UINTN)HostAddress;
+  Status  = EFI_NOT_FOUND;
+  Pages   = 0;
+  OldTpl  = gBS->RaiseTPL (TPL_NOTIFY);
+
+  if (Size > DMA_POOL_MAX_CHUNK) {
+    Pages = EFI_SIZE_TO_PAGES (Size);
+    goto Out;
+  }
+
+  Slab = DmaPoolFindSlab (Address, DmaPoolSizeToShift (Size, 0), &Domain);
+  if (Slab == NULL) {
+    if ((Address & EFI_PAGE_MASK) == 0) {
+      //
+      // A page-aligned request satisfied by AllocateBuffer.
+      //
+      Pages = 1;
+    }
+
+    goto Out;
+  }
+
+  if ((Address & ((1U << Slab->Shift) - 1)) != 0) {
+    goto Out;
+  }
+
+  Chunk = (UINTN)(Address - Slab->Base) >> Slab->Shift;
+  Mask  = LShiftU64 (1, Chunk % 64);
+  if ((Slab->InUse[Chunk / 64] & Mask) == 0) {
+    DEBUG ((DEBUG_ERROR, "%s: double free of DMA pool buffer %p\n", This->ComponentName, HostAddress));
+    goto Out;
+  }
+
+  Slab->InUse[Chunk / 64] &= ~Mask;
+  Slab->FreeChunks++;
+  Status = EFI_SUCCESS;
+
+  RemoveEntryList (&Slab->Link);
+  if (Slab->FreeChunks == (EFI_PAGE_SIZE >> Slab->Shift)) {
+    //
+    // Keep one empty slab around, release any further ones.
+    //
+    if (Domain->EmptySlabs[Slab->Shift - DMA_POOL_MIN_SHIFT] != 0) {
+      DtDmaFreePages (Domain->Region, Slab->Base, 1);
+      FreePool (Slab);
+      goto Out;
+    }
+
+    Domain->EmptySlabs[Slab->Shift - DMA_POOL_MIN_SHIFT]++;
+  }
+
+  Slabs = &Domain->Slabs[Slab->Shift - DMA_POOL_MIN_SHIFT];
+  InsertHeadList (Slabs, &Slab->Link);
+
+Out:
+  gBS->RestoreTPL (OldTpl);
+
+  if (Pages != 0) {
+    Status = DtIoFreeBuffer (This, Pages, HostAddress);
+  }
+
+  if (!EFI_ERROR (Status)) {
+    DtDmaStatsPoolBuffer (DT_DEV_FROM_THIS (This), FALSE);
+  }
+
+  return Status;
+}
@@ -452,9 +452,18 @@ EntryPoint (
     return EFI_NOT_FOUND;
   }
 
+  if (gDeviceTreeBase != NULL) {
+    ReservedMemoryInit (gDeviceTreeBase);
+  }
+
+  if (gTestTreeBase != NULL) {
+    ReservedMemoryInit (gTestTreeBase);
+  }
+
   Status = RegisterDtNotification ();
   if (EFI_ERROR (Status)) {
     DEBUG ((DEBUG_ERROR, "%a: RegisterDtNotification: %r\n", __func__, Status));
+    ReservedMemoryCleanup ();
     TestsCleanup ();
     return Status;
   }
@@ -463,6 +472,7 @@ EntryPoint (
   if (EFI_ERROR (Status)) {
     DEBUG ((DEBUG_ERROR, "%a: RegisterEndOfDxeNotification: %r\n", __func__, Status));
     UnregisterDtNotification ();
+    ReservedMemoryCleanup ();
     TestsCleanup ();
     return Status;
   }
@@ -472,6 +482,7 @@ EntryPoint (
     DEBUG ((DEBUG_ERROR, "%a: RegisterBusDriver: %r\n", __func__, Status));
     UnregisterEndOfDxeNotification ();
     UnregisterDtNotification ();
+    ReservedMemoryCleanup ();
     TestsCleanup ();
     return Status;
   }
@@ -13,6 +13,7 @@
 #include <PiDxe.h>
 #include <Protocol/CpuIo2.h>
 #include <Protocol/DtIo.h>
+#include <Protocol/DtDmaStats.h>
 #include <Library/BaseLib.h>
 #include <Library/BaseMemoryLib.h>
 #include <Library/DebugLib.h>
@@ -23,14 +24,17 @@
 #include <Library/UefiDriverEntryPoint.h>
 #include <Library/DevicePathLib.h>
 #include <Library/TimerLib.h>
+#include <Library/PcdLib.h>
 #include <Library/FbpUtilsLib.h>
+#include <Library/FbpCopyLib.h>
 #include <Library/FbpPlatformDtLib.h>
 #include <libfdt.h>
 
 #define ROUND_UP(x, n)    (((x) + n - 1) & ~(n - 1))
 #define ROUND_DOWN(x, n)  ((x) & ~(n - 1))
 
-typedef struct _DT_DEVICE DT_DEVICE;
+typedef struct _DT_DEVICE   DT_DEVICE;
+typedef struct _DMA_REGION  DMA_REGION;
 
 extern EFI_CPU_IO2_PROTOCOL  *gCpuIo2;
 extern VOID                  *gDeviceTreeBase;
@@ -67,6 +71,11 @@ extern LIST_ENTRY                    gCriticalDevices;
   #warning Define DMA_DEFAULT_IS_COHERENT for your architecture. Assuming coherence!
 #endif
 
+//
+// Bounce buffer cache size classes: 1, 2, 4, 8 and 16 pages.
+//
+#define DT_BOUNCE_CACHE_CLASSES  5
+
 struct _DT_DEVICE {
   UINTN                      Signature;
   EFI_HANDLE                 Handle;
@@ -89,11 +98,29 @@ struct _DT_DEVICE {
   //
   LIST_ENTRY                 Maps;
   EFI_PHYSICAL_ADDRESS       MaxCpuDmaAddress;
+  //
+  // shared-dma-pool referenced via memory-region, if any.
+  //
+  DMA_REGION                 *DmaRegion;
+  //
+  // DMA statistics, reported via DmaStatsProtocol.
+  //
+  EFI_DT_DMA_STATS_PROTOCOL  DmaStatsProtocol;
+  EFI_DT_DMA_STATS           DmaStats;
+  UINT64                     BounceCopyTicks;
+  //
+  // Unmapped bounce pages kept for reuse, one list per size
+  // class. The link to the next entry is stored in the first
+  // 8 bytes of the cached pages themselves.
+  //
+  EFI_PHYSICAL_ADDRESS       BounceCache[DT_BOUNCE_CACHE_CLASSES];
+  UINTN                      BounceCachePages;
 };
 
 #define DT_DEV_SIGNATURE  SIGNATURE_32 ('d', 't', 'i', 'o')
 #define DT_DEV_FROM_THIS(a)  CR(a, DT_DEVICE, DtIo, DT_DEV_SIGNATURE)
 #define DT_DEV_FROM_LINK(a)  CR(a, DT_DEVICE, Link, DT_DEV_SIGNATURE)
+#define DT_DEV_FROM_DMA_STATS(a)  CR(a, DT_DEVICE, DmaStatsProtocol, DT_DEV_SIGNATURE)
 
 typedef struct {
   UINT32                              Signature;
@@ -109,6 +136,27 @@ typedef struct {
 #define MAP_INFO_FROM_LINK(a)  CR (a, MAP_INFO, Link, MAP_INFO_SIGNATURE)
 #define NO_MAPPING  (VOID *) (UINTN) -1
 
+struct _DMA_REGION {
+  UINT32                  Signature;
+  LIST_ENTRY              Link;
+  VOID                    *TreeBase;
+  INTN                    FdtNode;
+  EFI_PHYSICAL_ADDRESS    Base;
+  UINTN                   Pages;
+  UINTN                   FreePages;
+  //
+  // TRUE if claimed via AllocatePages (and thus released on cleanup).
+  //
+  BOOLEAN                 Allocated;
+  //
+  // One bit per page, set == in use.
+  //
+  UINT8                   *InUse;
+};
+
+#define DMA_REGION_SIGNATURE  SIGNATURE_32 ('d', 'm', 'r', 'g')
+#define DMA_REGION_FROM_LINK(a)  CR (a, DMA_REGION, Link, DMA_REGION_SIGNATURE)
+
 VOID *
 GetTreeBaseFromDeviceFlags (
   IN  UINTN  DeviceFlags
@@ -443,6 +491,109 @@ DtIoFreeBuffer (
   IN  VOID                *HostAddress
   );
 
+EFI_STATUS
+EFIAPI
+DtIoAllocatePoolBuffer (
+  IN  EFI_DT_IO_PROTOCOL            *This,
+  IN  EFI_MEMORY_TYPE               MemoryType,
+  IN  UINTN                         Size,
+  IN  UINTN                         Alignment,
+  IN  EFI_DT_IO_PROTOCOL_DMA_EXTRA  *ExtraConstraints OPTIONAL,
+  OUT VOID                          **HostAddress
+  );
+
+EFI_STATUS
+EFIAPI
+DtIoFreePoolBuffer (
+  IN  EFI_DT_IO_PROTOCOL  *This,
+  IN  UINTN               Size,
+  IN  VOID                *HostAddress
+  );
+
+EFI_STATUS
+DtDeviceGetDmaConstraints (
+  IN  DT_DEVICE                     *DtDevice,
+  IN  EFI_DT_IO_PROTOCOL_DMA_EXTRA  *ExtraConstraints OPTIONAL,
+  OUT EFI_PHYSICAL_ADDRESS          *MaxAddress,
+  OUT BOOLEAN                       *IsCoherent
+  );
+
+EFI_STATUS
+DtDmaAllocatePages (
+  IN  DMA_REGION            *Region OPTIONAL,
+  IN  EFI_MEMORY_TYPE       MemoryType,
+  IN  UINTN                 Pages,
+  IN  EFI_PHYSICAL_ADDRESS  MaxAddress,
+  OUT EFI_PHYSICAL_ADDRESS  *Address
+  );
+
+EFI_STATUS
+DtDmaFreePages (
+  IN  DMA_REGION            *Region OPTIONAL,
+  IN  EFI_PHYSICAL_ADDRESS  Address,
+  IN  UINTN                 Pages
+  );
+
+VOID
+DtDmaBounceCacheFlush (
+  IN  DT_DEVICE  *DtDevice
+  );
+
+VOID
+DtDmaStatsPoolBuffer (
+  IN  DT_DEVICE  *DtDevice,
+  IN  BOOLEAN    Allocated
+  );
+
+EFI_STATUS
+EFIAPI
+DtDmaStatsGet (
+  IN  EFI_DT_DMA_STATS_PROTOCOL  *This,
+  OUT EFI_DT_DMA_STATS           *Stats
+  );
+
+EFI_STATUS
+EFIAPI
+DtDmaStatsReset (
+  IN  EFI_DT_DMA_STATS_PROTOCOL  *This
+  );
+
+VOID
+ReservedMemoryInit (
+  IN  VOID  *TreeBase
+  );
+
+VOID
+ReservedMemoryCleanup (
+  VOID
+  );
+
+DMA_REGION *
+DmaRegionFromDevice (
+  IN  DT_DEVICE  *DtDevice
+  );
+
+BOOLEAN
+DmaRegionContains (
+  IN  DMA_REGION            *Region,
+  IN  EFI_PHYSICAL_ADDRESS  Address
+  );
+
+EFI_STATUS
+DmaRegionAllocatePages (
+  IN  DMA_REGION            *Region,
+  IN  UINTN                 Pages,
+  IN  EFI_PHYSICAL_ADDRESS  MaxAddress,
+  OUT EFI_PHYSICAL_ADDRESS  *Address
+  );
+
+EFI_STATUS
+DmaRegionFreePages (
+  IN  DMA_REGION            *Region,
+  IN  EFI_PHYSICAL_ADDRESS  Address,
+  IN  UINTN                 Pages
+  );
+
 EFI_STATUS
 EFIAPI
 DtIoSetCallbacks (
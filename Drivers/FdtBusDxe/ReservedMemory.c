@@ -0,0 +1,602 @@
+/** @file
+
+    Support for /reserved-memory shared-dma-pool regions.
+
+    Each shared-dma-pool region is claimed from the UEFI memory map
+    on entry and then handed out page-by-page to the DT controllers
+    that reference it via the memory-region property, backing both
+    AllocateBuffer() and Map() bounce buffers.
+
+    Copyright (c) 2024, Intel Corporation. All rights reserved.<BR>
+
+    SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "FdtBusDxe.h"
+
+STATIC LIST_ENTRY  mDmaRegions = INITIALIZE_LIST_HEAD_VARIABLE (mDmaRegions);
+
+/**
+  Read a (up to) 2-cell value.
+
+  @param[in]    Buf              Cells.
+  @param[in]    Cells            Number of cells.
+
+  @retval UINT64                 Value.
+
+**/
+STATIC
+UINT64
+ReadCells (
+  IN  CONST EFI_DT_CELL  *Buf,
+  IN  UINT8              Cells
+  )
+{
+  UINT64  Value;
+
+  ASSERT (Cells <= 2);
+
+  Value = 0;
+  while (Cells-- != 0) {
+    Value = LShiftU64 (Value, 32) | fdt32_to_cpu (*Buf++);
+  }
+
+  return Value;
+}
+
+/**
+  Read the first (address, size) pair of a reg or alloc-ranges
+  property.
+
+  @param[in]    TreeBase         Devicetree blob base
+  @param[in]    FdtNode          INTN
+  @param[in]    Name             Property name.
+  @param[in]    AddressCells     #address-cells.
+  @param[in]    SizeCells        #size-cells.
+  @param[out]   Address          Address.
+  @param[out]   Size             Size.
+
+  @retval EFI_SUCCESS            Success.
+  @retval EFI_NOT_FOUND          No such property.
+  @retval EFI_DEVICE_ERROR       Malformed property.
+
+**/
+STATIC
+EFI_STATUS
+ReadRange (
+  IN  VOID                  *TreeBase,
+  IN  INTN                  FdtNode,
+  IN  CONST CHAR8           *Name,
+  IN  UINT8                 AddressCells,
+  IN  UINT8                 SizeCells,
+  OUT EFI_PHYSICAL_ADDRESS  *Address,
+  OUT UINT64                *Size
+  )
+{
+  INT32              Len;
+  CONST EFI_DT_CELL  *Buf;
+
+  Buf = fdt_getprop (TreeBase, FdtNode, Name, &Len);
+  if (Buf == NULL) {
+    return EFI_NOT_FOUND;
+  }
+
+  if ((Len < (INT32)((AddressCells + SizeCells) * sizeof (EFI_DT_CELL))) ||
+      (AddressCells > 2) || (SizeCells > 2))
+  {
+    return EFI_DEVICE_ERROR;
+  }
+
+  *Address = ReadCells (Buf, AddressCells);
+  *Size    = ReadCells (Buf + AddressCells, SizeCells);
+  return EFI_SUCCESS;
+}
+
+/**
+  Claim a statically-placed (reg) region.
+
+  Regions that are ordinary free memory get allocated out of
+  the memory map. Regions that aren't (e.g. no-map regions the
+  platform has already carved out) must be reserved or absent
+  in the GCD, and are made accessible as write-back reserved
+  memory.
+
+  @param[in]    Region           DMA_REGION *.
+  @param[in]    MemoryType       Memory type for the allocation.
+
+  @retval EFI_SUCCESS            Success.
+  @retval Others                 Errors.
+
+**/
+STATIC
+EFI_STATUS
+ReserveStaticRegion (
+  IN  DMA_REGION       *Region,
+  IN  EFI_MEMORY_TYPE  MemoryType
+  )
+{
+  EFI_STATUS            Status;
+  EFI_PHYSICAL_ADDRESS  Address;
+
+  Address = Region->Base;
+  Status  = gBS->AllocatePages (
+                   AllocateAddress,
+                   MemoryType,
+                   Region->Pages,
+                   &Address
+                   );
+  if (!EFI_ERROR (Status)) {
+    Region->Allocated = TRUE;
+    return EFI_SUCCESS;
+  }
+
+  return ApplyGcdTypeAndAttrs (
+           Region->Base,
+           EFI_PAGES_TO_SIZE (Region->Pages),
+           EfiGcdMemoryTypeReserved,
+           EFI_MEMORY_WB,
+           NULL,
+           NULL,
+           FALSE
+           );
+}
+
+/**
+  Allocate a dynamically-placed (size) region, honoring the
+  optional alignment and alloc-ranges properties. Only the first
+  alloc-ranges entry is considered, and only as an upper bound.
+
+  @param[in]    Region           DMA_REGION *.
+  @param[in]    Alignment        Required alignment.
+  @param[in]    MaxAddress       Maximum address.
+
+  @retval EFI_SUCCESS            Success.
+  @retval Others                 Errors.
+
+**/
+STATIC
+EFI_STATUS
+ReserveDynamicRegion (
+  IN  DMA_REGION            *Region,
+  IN  UINT64                Alignment,
+  IN  EFI_PHYSICAL_ADDRESS  MaxAddress
+  )
+{
+  EFI_STATUS            Status;
+  EFI_PHYSICAL_ADDRESS  Address;
+  EFI_PHYSICAL_ADDRESS  AlignedAddress;
+  UINTN                 SlackPages;
+  UINTN                 HeadPages;
+
+  SlackPages = 0;
+  if (Alignment > EFI_PAGE_SIZE) {
+    if ((Alignment & (Alignment - 1)) != 0) {
+      return EFI_DEVICE_ERROR;
+    }
+
+    SlackPages = EFI_SIZE_TO_PAGES ((UINTN)Alignment) - 1;
+  }
+
+  Address = MaxAddress;
+  Status  = gBS->AllocatePages (
+                   AllocateMaxAddress,
+                   EfiBootServicesData,
+                   Region->Pages + SlackPages,
+                   &Address
+                   );
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  AlignedAddress = Address;
+  if (SlackPages != 0) {
+    AlignedAddress = ALIGN_VALUE (Address, Alignment);
+    HeadPages      = EFI_SIZE_TO_PAGES ((UINTN)(AlignedAddress - Address));
+    if (HeadPages != 0) {
+      gBS->FreePages (Address, HeadPages);
+    }
+
+    if (SlackPages > HeadPages) {
+      gBS->FreePages (
+             AlignedAddress + EFI_PAGES_TO_SIZE (Region->Pages),
+             SlackPages - HeadPages
+             );
+    }
+  }
+
+  Region->Base      = AlignedAddress;
+  Region->Allocated = TRUE;
+  return EFI_SUCCESS;
+}
+
+/**
+  Parse and claim a single shared-dma-pool region.
+
+  @param[in]    TreeBase         Devicetree blob base
+  @param[in]    FdtNode          INTN
+  @param[in]    AddressCells     #address-cells of /reserved-memory.
+  @param[in]    SizeCells        #size-cells of /reserved-memory.
+
+  @retval EFI_SUCCESS            Success.
+  @retval Others                 Errors.
+
+**/
+STATIC
+EFI_STATUS
+ReserveRegion (
+  IN  VOID   *TreeBase,
+  IN  INTN   FdtNode,
+  IN  UINT8  AddressCells,
+  IN  UINT8  SizeCells
+  )
+{
+  EFI_STATUS            Status;
+  DMA_REGION            *Region;
+  EFI_PHYSICAL_ADDRESS  Base;
+  EFI_PHYSICAL_ADDRESS  End;
+  EFI_PHYSICAL_ADDRESS  MaxAddress;
+  UINT64                Size;
+  UINT64                Alignment;
+  BOOLEAN               IsStatic;
+
+  Status = ReadRange (TreeBase, FdtNode, "reg", AddressCells, SizeCells, &Base, &Size);
+  if (Status == EFI_NOT_FOUND) {
+    IsStatic = FALSE;
+    Base     = 0;
+    Status   = ReadRange (TreeBase, FdtNode, "size", 0, SizeCells, &End, &Size);
+  } else {
+    IsStatic = TRUE;
+  }
+
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  if (IsStatic) {
+    //
+    // Only use the page-aligned part of the region.
+    //
+    End  = ROUND_DOWN (Base + Size, EFI_PAGE_SIZE);
+    Base = ROUND_UP (Base, EFI_PAGE_SIZE);
+    Size = End > Base ? End - Base : 0;
+  }
+
+  if (EFI_SIZE_TO_PAGES ((UINTN)Size) == 0) {
+    return EFI_DEVICE_ERROR;
+  }
+
+  Region = AllocateZeroPool (sizeof (DMA_REGION));
+  if (Region == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Region->Signature = DMA_REGION_SIGNATURE;
+  Region->TreeBase  = TreeBase;
+  Region->FdtNode   = FdtNode;
+  Region->Base      = Base;
+  Region->Pages     = EFI_SIZE_TO_PAGES ((UINTN)Size);
+  Region->FreePages = Region->Pages;
+  Region->InUse     = AllocateZeroPool ((Region->Pages + 7) / 8);
+  if (Region->InUse == NULL) {
+    FreePool (Region);
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  if (IsStatic) {
+    //
+    // Reusable regions can be reclaimed by the OS.
+    //
+    Status = ReserveStaticRegion (
+               Region,
+               fdt_getprop (TreeBase, FdtNode, "reusable", NULL) != NULL ?
+               EfiBootServicesData : EfiReservedMemoryType
+               );
+  } else {
+    Alignment = 0;
+    ReadRange (TreeBase, FdtNode, "alignment", 0, SizeCells, &End, &Alignment);
+
+    MaxAddress = MAX_ADDRESS;
+    if (!EFI_ERROR (ReadRange (TreeBase, FdtNode, "alloc-ranges", AddressCells, SizeCells, &Base, &Size)) &&
+        (Size != 0))
+    {
+      MaxAddress = Base + Size - 1;
+    }
+
+    Status = ReserveDynamicRegion (Region, Alignment, MaxAddress);
+  }
+
+  if (EFI_ERROR (Status)) {
+    FreePool (Region->InUse);
+    FreePool (Region);
+    return Status;
+  }
+
+  DEBUG ((
+    DEBUG_INFO,
+    "%a: %a DMA pool at 0x%lx-0x%lx\n",
+    __func__,
+    fdt_get_name (TreeBase, FdtNode, NULL),
+    Region->Base,
+    Region->Base + EFI_PAGES_TO_SIZE (Region->Pages) - 1
+    ));
+
+  InsertTailList (&mDmaRegions, &Region->Link);
+  return EFI_SUCCESS;
+}
+
+/**
+  Parse and claim all shared-dma-pool regions under /reserved-memory.
+  Failures are not fatal: devices referencing a missing region
+  simply use regular DMA allocations.
+
+  @param[in]    TreeBase         Devicetree blob base
+
+  @retval None
+
+**/
+VOID
+ReservedMemoryInit (
+  IN  VOID  *TreeBase
+  )
+{
+  EFI_STATUS  Status;
+  INTN        ParentNode;
+  INTN        Node;
+  UINT8       AddressCells;
+  UINT8       SizeCells;
+
+  ParentNode = fdt_path_offset (TreeBase, "/reserved-memory");
+  if (ParentNode < 0) {
+    return;
+  }
+
+  Status = FdtGetAddressCells (TreeBase, ParentNode, &AddressCells);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "%a: FdtGetAddressCells: %r\n", __func__, Status));
+    return;
+  }
+
+  Status = FdtGetSizeCells (TreeBase, ParentNode, &SizeCells);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "%a: FdtGetSizeCells: %r\n", __func__, Status));
+    return;
+  }
+
+  fdt_for_each_subnode (Node, TreeBase, ParentNode) {
+    if ((FdtGetStatus (TreeBase, Node) != EFI_DT_STATUS_OKAY) ||
+        (fdt_node_check_compatible (TreeBase, Node, "shared-dma-pool") != 0))
+    {
+      continue;
+    }
+
+    Status = ReserveRegion (TreeBase, Node, AddressCells, SizeCells);
+    if (EFI_ERROR (Status)) {
+      DEBUG ((
+        DEBUG_ERROR,
+        "%a: %a: %r\n",
+        __func__,
+        fdt_get_name (TreeBase, Node, NULL),
+        Status
+        ));
+    }
+  }
+}
+
+/**
+  Release all claimed shared-dma-pool regions.
+
+  @retval None
+
+**/
+VOID
+ReservedMemoryCleanup (
+  VOID
+  )
+{
+  DMA_REGION  *Region;
+
+  while (!IsListEmpty (&mDmaRegions)) {
+    Region = DMA_REGION_FROM_LINK (GetFirstNode (&mDmaRegions));
+    RemoveEntryList (&Region->Link);
+
+    if (Region->Allocated) {
+      gBS->FreePages (Region->Base, Region->Pages);
+    }
+
+    FreePool (Region->InUse);
+    FreePool (Region);
+  }
+}
+
+/**
+  Return the shared-dma-pool region referenced by a DT_DEVICE's
+  memory-region property, if any.
+
+  @param[in]    DtDevice         DT_DEVICE *.
+
+  @retval NULL                   No region.
+  @retval Others                 DMA_REGION *.
+
+**/
+DMA_REGION *
+DmaRegionFromDevice (
+  IN  DT_DEVICE  *DtDevice
+  )
+{
+  EFI_STATUS  Status;
+  LIST_ENTRY  *Link;
+  DMA_REGION  *Region;
+  VOID        *TreeBase;
+  INTN        Node;
+  UINT32      Phandle;
+  UINTN       Index;
+
+  if (IsListEmpty (&mDmaRegions)) {
+    return NULL;
+  }
+
+  TreeBase = GetTreeBaseFromDeviceFlags (DtDevice->Flags);
+  for (Index = 0; ; Index++) {
+    Status = DtIoGetU32 (&DtDevice->DtIo, "memory-region", Index, &Phandle);
+    if (EFI_ERROR (Status)) {
+      return NULL;
+    }
+
+    Node = fdt_node_offset_by_phandle (TreeBase, Phandle);
+    if (Node < 0) {
+      continue;
+    }
+
+    for (Link = GetFirstNode (&mDmaRegions)
+         ; !IsNull (&mDmaRegions, Link)
+         ; Link = GetNextNode (&mDmaRegions, Link)
+         )
+    {
+      Region = DMA_REGION_FROM_LINK (Link);
+      if ((Region->TreeBase == TreeBase) && (Region->FdtNode == Node)) {
+        return Region;
+      }
+    }
+  }
+}
+
+/**
+  Return whether an address lies within a region.
+
+  @param[in]    Region           DMA_REGION *.
+  @param[in]    Address          Address.
+
+  @retval TRUE                   Address is in the region.
+  @retval FALSE                  Address is not in the region.
+
+**/
+BOOLEAN
+DmaRegionContains (
+  IN  DMA_REGION            *Region,
+  IN  EFI_PHYSICAL_ADDRESS  Address
+  )
+{
+  return (Address >= Region->Base) &&
+         (Address - Region->Base < EFI_PAGES_TO_SIZE ((UINT64)Region->Pages));
+}
+
+/**
+  Allocate pages from a region (first fit).
+
+  @param[in]    Region           DMA_REGION *.
+  @param[in]    Pages            Number of pages.
+  @param[in]    MaxAddress       Maximum address of the allocation.
+  @param[out]   Address          Allocated address.
+
+  @retval EFI_SUCCESS            Success.
+  @retval EFI_OUT_OF_RESOURCES   No suitable free range in region.
+
+**/
+EFI_STATUS
+DmaRegionAllocatePages (
+  IN  DMA_REGION            *Region,
+  IN  UINTN                 Pages,
+  IN  EFI_PHYSICAL_ADDRESS  MaxAddress,
+  OUT EFI_PHYSICAL_ADDRESS  *Address
+  )
+{
+  EFI_STATUS  Status;
+  EFI_TPL     OldTpl;
+  UINTN       Limit;
+  UINTN       Index;
+  UINTN       Run;
+
+  if (MaxAddress < Region->Base) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Limit = Region->Pages;
+  if (MaxAddress - Region->Base < EFI_PAGES_TO_SIZE ((UINT64)Limit) - 1) {
+    Limit = (UINTN)RShiftU64 (MaxAddress - Region->Base + 1, EFI_PAGE_SHIFT);
+  }
+
+  Status = EFI_OUT_OF_RESOURCES;
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+
+  if (Pages > Region->FreePages) {
+    goto Out;
+  }
+
+  for (Index = 0, Run = 0; Index < Limit; Index++) {
+    if ((Region->InUse[Index / 8] & (1U << (Index % 8))) != 0) {
+      Run = 0;
+      continue;
+    }
+
+    if (++Run == Pages) {
+      for (Index = Index + 1 - Pages, Run = 0; Run < Pages; Index++, Run++) {
+        Region->InUse[Index / 8] |= (UINT8)(1U << (Index % 8));
+      }
+
+      Region->FreePages -= Pages;
+      *Address           = Region->Base + EFI_PAGES_TO_SIZE ((UINT64)(Index - Pages));
+      Status             = EFI_SUCCESS;
+      break;
+    }
+  }
+
+Out:
+  gBS->RestoreTPL (OldTpl);
+  return Status;
+}
+
+/**
+  Free pages allocated with DmaRegionAllocatePages.
+
+  @param[in]    Region           DMA_REGION *.
+  @param[in]    Address          Address.
+  @param[in]    Pages            Number of pages.
+
+  @retval EFI_SUCCESS            Success.
+  @retval EFI_NOT_FOUND          Range was not allocated from the region.
+
+**/
+EFI_STATUS
+DmaRegionFreePages (
+  IN  DMA_REGION            *Region,
+  IN  EFI_PHYSICAL_ADDRESS  Address,
+  IN  UINTN                 Pages
+  )
+{
+  EFI_STATUS  Status;
+  EFI_TPL     OldTpl;
+  UINTN       First;
+  UINTN       Index;
+
+  if (!DmaRegionContains (Region, Address) ||
+      ((Address & EFI_PAGE_MASK) != 0))
+  {
+    return EFI_NOT_FOUND;
+  }
+
+  First = (UINTN)RShiftU64 (Address - Region->Base, EFI_PAGE_SHIFT);
+  if (Pages > Region->Pages - First) {
+    return EFI_NOT_FOUND;
+  }
+
+  Status = EFI_SUCCESS;
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+
+  for (Index = First; Index < First + Pages; Index++) {
+    if ((Region->InUse[Index / 8] & (1U << (Index % 8))) == 0) {
+      Status = EFI_NOT_FOUND;
+      goto Out;
+    }
+  }
+
+  for (Index = First; Index < First + Pages; Index++) {
+    Region->InUse[Index / 8] &= (UINT8) ~(1U << (Index % 8));
+  }
+
+  Region->FreePages += Pages;
+
+Out:
+  gBS->RestoreTPL (OldTpl);
+  return Status;
+}
@@ -488,6 +488,8 @@ TEST_DEF (G5P3) {
   EFI_DT_REG  Reg00;
   EFI_DT_REG  Reg11;
   UINT8       Array2[32];
+  UINT8       *CopyBuffer;
+  UINTN       Index;
 
   TestRegionSize = sizeof (Dt_DeviceRegs_TestTemplate00);
   TempMemBuffer  = AllocateZeroPool (TestRegionSize);
@@ -505,6 +507,54 @@ TEST_DEF (G5P3) {
   ASSERT (CompareMem ((UINT8 *)(UINTN)Reg00.TranslatedBase, (UINT8 *)(UINTN)Reg11.TranslatedBase, 32) == 0);
 
   FreePool (TempMemBuffer);
+
+  //
+  // Overlapping copies within the same region, large enough for the
+  // direct memory copy path.
+  //
+  TempMemBuffer = AllocatePool (1024);
+  ASSERT (TempMemBuffer != NULL);
+  CopyBuffer = AllocatePool (1024);
+  ASSERT (CopyBuffer != NULL);
+
+  for (Index = 0; Index < 1024; Index++) {
+    TempMemBuffer[Index] = (UINT8)(Index * 7);
+  }
+
+  CopyMem (CopyBuffer, TempMemBuffer, 1024);
+  ZeroMem (&Reg00, sizeof (EFI_DT_REG));
+  Reg00.TranslatedBase = (EFI_PHYSICAL_ADDRESS)TempMemBuffer;
+  Reg00.Length         = 1024;
+  ASSERT (DtIo->CopyReg (DtIo, EfiDtIoWidthUint64, &Reg00, 8, &Reg00, 0, 100) == EFI_SUCCESS);
+  CopyMem (CopyBuffer + 8, CopyBuffer, 800);
+  ASSERT (CompareMem (TempMemBuffer, CopyBuffer, 1024) == 0);
+  ASSERT (DtIo->CopyReg (DtIo, EfiDtIoWidthUint32, &Reg00, 0, &Reg00, 12, 200) == EFI_SUCCESS);
+  CopyMem (CopyBuffer, CopyBuffer + 12, 800);
+  ASSERT (CompareMem (TempMemBuffer, CopyBuffer, 1024) == 0);
+  ASSERT (DtIo->CopyReg (DtIo, EfiDtIoWidthUint64, &Reg00, 0, &Reg00, 1000, 4) == EFI_INVALID_PARAMETER);
+
+  //
+  // FbpCopyMem/FbpZeroMem at odd alignments and lengths, covering
+  // both the scalar and vector kernels.
+  //
+  for (Index = 0; Index < 8; Index++) {
+    UINTN  Length;
+
+    Length = 509 - Index * 61;
+    SetMem (CopyBuffer, 1024, 0xAA);
+    FbpCopyMem (CopyBuffer + Index, TempMemBuffer + 3, Length);
+    ASSERT (CompareMem (CopyBuffer + Index, TempMemBuffer + 3, Length) == 0);
+    ASSERT (CopyBuffer[Index + Length] == 0xAA);
+    ASSERT ((Index == 0) || (CopyBuffer[Index - 1] == 0xAA));
+
+    FbpZeroMem (CopyBuffer + Index + 1, Length);
+    ASSERT (IsZeroBuffer (CopyBuffer + Index + 1, Length));
+    ASSERT (CopyBuffer[Index] == TempMemBuffer[3]);
+    ASSERT (CopyBuffer[Index + 1 + Length] == 0xAA);
+  }
+
+  FreePool (CopyBuffer);
+  FreePool (TempMemBuffer);
 }
 
 //
@@ -614,9 +664,11 @@ TEST_DEF (Dma1) {
   VOID                          *TestAddress;
   VOID                          *TestAddress2;
   EFI_DT_BUS_ADDRESS            BusAddress;
+  EFI_DT_BUS_ADDRESS            BusAddress2;
   VOID                          *Mapping;
   UINTN                         NumberOfBytes;
   EFI_DT_IO_PROTOCOL_DMA_EXTRA  Constraints;
+  UINT64                        CacheHits;
 
   ASSERT (DtIo->IsDmaCoherent);
 
@@ -821,6 +873,11 @@ TEST_DEF (Dma1) {
   ASSERT (BusAddress < Constraints.MaxAddress);
   ASSERT (CompareMem (TestAddress, (VOID *)(UINTN)BusAddress, NumberOfBytes) == 0);
   ASSERT (DtIo->Unmap (DtIo, Mapping) == EFI_SUCCESS);
+  //
+  // The bounce pages just unmapped get reused.
+  //
+  CacheHits   = DtDevice->DmaStats.BounceCacheHits;
+  BusAddress2 = BusAddress;
   ASSERT (
     DtIo->Map (
             DtIo,
@@ -834,6 +891,11 @@ TEST_DEF (Dma1) {
     );
   ASSERT (Mapping != NO_MAPPING);
   ASSERT (BusAddress < Constraints.MaxAddress);
+  if (PcdGet32 (PcdDmaBounceCachePages) != 0) {
+    ASSERT (DtDevice->DmaStats.BounceCacheHits == CacheHits + 1);
+    ASSERT (BusAddress == BusAddress2);
+  }
+
   SetMem ((VOID *)(UINTN)BusAddress, NumberOfBytes, 0xBB);
   ASSERT (DtIo->Unmap (DtIo, Mapping) == EFI_SUCCESS);
   for (Index = 0; Index < EFI_PAGE_SIZE; Index++) {
@@ -874,6 +936,54 @@ TEST_DEF (Dma1) {
   ASSERT (TestAddress2 < TestAddress);
   ASSERT (DtIo->FreeBuffer (DtIo, 1, TestAddress) == EFI_SUCCESS);
   ASSERT (DtIo->FreeBuffer (DtIo, 1, TestAddress2) == EFI_SUCCESS);
+
+  //
+  // Test for AllocatePoolBuffer.
+  //
+  ASSERT (DtIo->AllocatePoolBuffer (NULL, EfiBootServicesData, 16, 0, NULL, &TestAddress) == EFI_INVALID_PARAMETER);
+  ASSERT (DtIo->AllocatePoolBuffer (DtIo, EfiMaxMemoryType, 16, 0, NULL, &TestAddress) == EFI_INVALID_PARAMETER);
+  ASSERT (DtIo->AllocatePoolBuffer (DtIo, EfiBootServicesData, 0, 0, NULL, &TestAddress) == EFI_INVALID_PARAMETER);
+  ASSERT (DtIo->AllocatePoolBuffer (DtIo, EfiBootServicesData, 16, 3, NULL, &TestAddress) == EFI_INVALID_PARAMETER);
+  ASSERT (DtIo->AllocatePoolBuffer (DtIo, EfiBootServicesData, 16, EFI_PAGE_SIZE * 2, NULL, &TestAddress) == EFI_INVALID_PARAMETER);
+  ASSERT (DtIo->AllocatePoolBuffer (DtIo, EfiBootServicesData, 16, 0, NULL, NULL) == EFI_INVALID_PARAMETER);
+
+  ASSERT (DtIo->AllocatePoolBuffer (DtIo, EfiBootServicesData, 64, 0, NULL, &TestAddress) == EFI_SUCCESS);
+  ASSERT (((UINTN)TestAddress & 63) == 0);
+  ASSERT (DtIo->AllocatePoolBuffer (DtIo, EfiBootServicesData, 64, 0, NULL, &TestAddress2) == EFI_SUCCESS);
+  ASSERT (((UINTN)TestAddress2 & 63) == 0);
+  ASSERT (TestAddress != TestAddress2);
+  //
+  // Chunks of the same class share a page.
+  //
+  ASSERT (((UINTN)TestAddress & ~(EFI_PAGE_SIZE - 1)) == ((UINTN)TestAddress2 & ~(EFI_PAGE_SIZE - 1)));
+  for (Index = 0; Index < 64; Index++) {
+    ASSERT (*((UINT8 *)TestAddress2 + Index) == 0);
+  }
+
+  ASSERT (DtIo->FreePoolBuffer (NULL, 64, TestAddress) == EFI_INVALID_PARAMETER);
+  ASSERT (DtIo->FreePoolBuffer (DtIo, 0, TestAddress) == EFI_INVALID_PARAMETER);
+  ASSERT (DtIo->FreePoolBuffer (DtIo, 64, (UINT8 *)TestAddress + 1) == EFI_NOT_FOUND);
+  ASSERT (DtIo->FreePoolBuffer (DtIo, 64, TestAddress) == EFI_SUCCESS);
+  ASSERT (DtIo->FreePoolBuffer (DtIo, 64, TestAddress) == EFI_NOT_FOUND);
+  ASSERT (DtIo->FreePoolBuffer (DtIo, 64, TestAddress2) == EFI_SUCCESS);
+
+  ASSERT (DtIo->AllocatePoolBuffer (DtIo, EfiBootServicesData, 16, 256, NULL, &TestAddress) == EFI_SUCCESS);
+  ASSERT (((UINTN)TestAddress & 255) == 0);
+  ASSERT (DtIo->FreePoolBuffer (DtIo, 16, TestAddress) == EFI_SUCCESS);
+
+  ASSERT (DtIo->AllocatePoolBuffer (DtIo, EfiBootServicesData, EFI_PAGE_SIZE, 0, NULL, &TestAddress) == EFI_SUCCESS);
+  ASSERT (((UINTN)TestAddress & (EFI_PAGE_SIZE - 1)) == 0);
+  ASSERT (DtIo->FreePoolBuffer (DtIo, EFI_PAGE_SIZE, TestAddress) == EFI_SUCCESS);
+
+  ASSERT (DtIo->AllocatePoolBuffer (DtIo, EfiBootServicesData, 16, EFI_PAGE_SIZE, NULL, &TestAddress) == EFI_SUCCESS);
+  ASSERT (((UINTN)TestAddress & (EFI_PAGE_SIZE - 1)) == 0);
+  ASSERT (DtIo->FreePoolBuffer (DtIo, 16, TestAddress) == EFI_SUCCESS);
+
+  Constraints.Flags      = EFI_DT_IO_DMA_WITH_MAX_ADDRESS;
+  Constraints.MaxAddress = (EFI_PHYSICAL_ADDRESS)TestAddress2;
+  ASSERT (DtIo->AllocatePoolBuffer (DtIo, EfiBootServicesData, 32, 0, &Constraints, &TestAddress) == EFI_SUCCESS);
+  ASSERT ((EFI_PHYSICAL_ADDRESS)TestAddress + 32 - 1 <= Constraints.MaxAddress);
+  ASSERT (DtIo->FreePoolBuffer (DtIo, 32, TestAddress) == EFI_SUCCESS);
 }
 
 TEST_DEF (Dma2) {
@@ -889,6 +999,117 @@ TEST_DEF (Dma4) {
   ASSERT ((DtDevice->Flags & DT_DEVICE_NON_IDENTITY_DMA) != 0);
 }
 
+TEST_DEF (Dma5) {
+  DMA_REGION                    *Region;
+  VOID                          *TestAddress;
+  VOID                          *TestAddress2;
+  EFI_DT_BUS_ADDRESS            BusAddress;
+  VOID                          *Mapping;
+  UINTN                         NumberOfBytes;
+  EFI_DT_IO_PROTOCOL_DMA_EXTRA  Constraints;
+  EFI_DT_DMA_STATS_PROTOCOL     *DmaStatsProtocol;
+  EFI_DT_DMA_STATS              Stats;
+
+  Region = DtDevice->DmaRegion;
+  ASSERT (Region != NULL);
+  ASSERT (Region->Pages == 4);
+  ASSERT ((Region->Base & (SIZE_64KB - 1)) == 0);
+
+  ASSERT (gBS->HandleProtocol (DtDevice->Handle, &gEfiDtDmaStatsProtocolGuid, (VOID **)&DmaStatsProtocol) == EFI_SUCCESS);
+  ASSERT (DmaStatsProtocol->ResetStats (NULL) == EFI_INVALID_PARAMETER);
+  ASSERT (DmaStatsProtocol->GetStats (DmaStatsProtocol, NULL) == EFI_INVALID_PARAMETER);
+  ASSERT (DmaStatsProtocol->ResetStats (DmaStatsProtocol) == EFI_SUCCESS);
+
+  //
+  // AllocateBuffer is served from the shared-dma-pool.
+  //
+  ASSERT (DtIo->AllocateBuffer (DtIo, EfiBootServicesData, 2, NULL, &TestAddress) == EFI_SUCCESS);
+  ASSERT ((EFI_PHYSICAL_ADDRESS)TestAddress == Region->Base);
+  ASSERT (DtIo->AllocateBuffer (DtIo, EfiBootServicesData, 2, NULL, &TestAddress2) == EFI_SUCCESS);
+  ASSERT (DmaRegionContains (Region, (EFI_PHYSICAL_ADDRESS)TestAddress2));
+  ASSERT (Region->FreePages == 0);
+
+  //
+  // ...but not runtime allocations.
+  //
+  ASSERT (DtIo->AllocateBuffer (DtIo, EfiRuntimeServicesData, 1, NULL, &Mapping) == EFI_SUCCESS);
+  ASSERT (!DmaRegionContains (Region, (EFI_PHYSICAL_ADDRESS)Mapping));
+  ASSERT (DtIo->FreeBuffer (DtIo, 1, Mapping) == EFI_SUCCESS);
+
+  ASSERT (DtIo->FreeBuffer (DtIo, 2, TestAddress) == EFI_SUCCESS);
+  ASSERT (DtIo->FreeBuffer (DtIo, 2, TestAddress) == EFI_NOT_FOUND);
+  ASSERT (Region->FreePages == 2);
+
+  //
+  // Bounce buffers come from the shared-dma-pool as well.
+  //
+  TestAddress = (UINT8 *)TestAddress2 + EFI_PAGE_SIZE;
+  SetMem (TestAddress, EFI_PAGE_SIZE, 0xAA);
+  NumberOfBytes          = EFI_PAGE_SIZE;
+  Constraints.Flags      = EFI_DT_IO_DMA_WITH_MAX_ADDRESS;
+  Constraints.MaxAddress = Region->Base + EFI_PAGES_TO_SIZE (2) - 1;
+  ASSERT (
+    DtIo->Map (
+            DtIo,
+            EfiDtIoDmaOperationBusMasterRead,
+            TestAddress,
+            &Constraints,
+            &NumberOfBytes,
+            &BusAddress,
+            &Mapping
+            ) == EFI_SUCCESS
+    );
+  ASSERT (Mapping != NO_MAPPING);
+  ASSERT (BusAddress <= Constraints.MaxAddress);
+  ASSERT (DmaRegionContains (Region, BusAddress));
+  ASSERT (CompareMem (TestAddress, (VOID *)(UINTN)BusAddress, NumberOfBytes) == 0);
+  ASSERT (Region->FreePages == 1);
+  ASSERT (DtIo->Unmap (DtIo, Mapping) == EFI_SUCCESS);
+
+  //
+  // Three AllocateBuffer calls (5 pages) with 2 pages still held, and
+  // one bounced BusMasterRead mapping.
+  //
+  ASSERT (DmaStatsProtocol->GetStats (DmaStatsProtocol, &Stats) == EFI_SUCCESS);
+  ASSERT (Stats.AllocateBufferCalls == 3);
+  ASSERT (Stats.AllocateBufferPages == 5);
+  ASSERT (Stats.OutstandingBufferPages == 2);
+  ASSERT (Stats.MapCalls == 1);
+  ASSERT (Stats.UnmapCalls == 1);
+  ASSERT (Stats.BouncedMaps == 1);
+  ASSERT (Stats.ZeroCopyMaps == 0);
+  ASSERT (Stats.BytesBouncedToDevice == EFI_PAGE_SIZE);
+  ASSERT (Stats.BytesBouncedFromDevice == 0);
+  ASSERT (Stats.OutstandingMaps == 0);
+  ASSERT (Stats.PeakOutstandingMaps == 1);
+
+  ASSERT (DtIo->FreeBuffer (DtIo, 2, TestAddress2) == EFI_SUCCESS);
+  ASSERT (Region->FreePages == Region->Pages);
+  ASSERT (DmaStatsProtocol->GetStats (DmaStatsProtocol, &Stats) == EFI_SUCCESS);
+  ASSERT (Stats.OutstandingBufferPages == 0);
+
+  //
+  // And so do pool buffer slabs.
+  //
+  ASSERT (DtIo->AllocatePoolBuffer (DtIo, EfiBootServicesData, 64, 0, NULL, &TestAddress) == EFI_SUCCESS);
+  ASSERT (DmaRegionContains (Region, (EFI_PHYSICAL_ADDRESS)TestAddress));
+  ASSERT (DmaStatsProtocol->GetStats (DmaStatsProtocol, &Stats) == EFI_SUCCESS);
+  ASSERT (Stats.AllocatePoolBufferCalls == 1);
+  ASSERT (Stats.OutstandingPoolBuffers == 1);
+  ASSERT (DtIo->FreePoolBuffer (DtIo, 64, TestAddress) == EFI_SUCCESS);
+  ASSERT (DmaStatsProtocol->GetStats (DmaStatsProtocol, &Stats) == EFI_SUCCESS);
+  ASSERT (Stats.OutstandingPoolBuffers == 0);
+
+  //
+  // The now empty slab is kept and reused.
+  //
+  ASSERT (Region->FreePages == Region->Pages - 1);
+  ASSERT (DtIo->AllocatePoolBuffer (DtIo, EfiBootServicesData, 64, 0, NULL, &TestAddress2) == EFI_SUCCESS);
+  ASSERT (ROUND_DOWN ((UINTN)TestAddress2, EFI_PAGE_SIZE) == ROUND_DOWN ((UINTN)TestAddress, EFI_PAGE_SIZE));
+  ASSERT (Region->FreePages == Region->Pages - 1);
+  ASSERT (DtIo->FreePoolBuffer (DtIo, 64, TestAddress2) == EFI_SUCCESS);
+}
+
 TEST_DEF (LookupTest) {
   EFI_HANDLE          Handle;
   EFI_DT_IO_PROTOCOL  *FoundDtIo;
@@ -900,12 +1121,30 @@ TEST_DEF (LookupTest) {
   ASSERT (AsciiStrCmp (String, "NodeToLookup") == 0);
 }
 
+STATIC UINTN  mDeferredRuns;
+STATIC UINTN  mDeferredCount;
+
+STATIC
+VOID
+EFIAPI
+DeferredWorkTestFn (
+  IN  VOID   *Context,
+  IN  UINTN  Count
+  )
+{
+  ASSERT (Context == &mDeferredRuns);
+  mDeferredRuns++;
+  mDeferredCount += Count;
+}
+
 TEST_DEF (DevWithInterrupt) {
   EFI_DT_PROPERTY     Interrupt;
   EFI_HANDLE          InterruptParent;
   EFI_DT_IO_PROTOCOL  *FoundDtIo;
   CONST CHAR8         *String;
   UINT32              Value;
+  FBP_DEFERRED_WORK   *Work;
+  EFI_TPL             OldTpl;
 
   ASSERT (FbpInterruptGet (DtIo, 0, &InterruptParent, &Interrupt) == EFI_SUCCESS);
   ASSERT (gBS->HandleProtocol (InterruptParent, &gEfiDtIoProtocolGuid, (VOID **)&FoundDtIo) == EFI_SUCCESS);
@@ -917,6 +1156,45 @@ TEST_DEF (DevWithInterrupt) {
   ASSERT (Value == 8);
 
   ASSERT (FbpInterruptGet (DtIo, 3, &InterruptParent, &Interrupt) == EFI_NOT_FOUND);
+
+  //
+  // An "interrupt storm" queuing the same work three times
+  // results in a single run.
+  //
+  ASSERT (FbpDeferredWorkCreate (DeferredWorkTestFn, &mDeferredRuns, &Work) == EFI_SUCCESS);
+  OldTpl = gBS->RaiseTPL (TPL_HIGH_LEVEL);
+  FbpDeferredWorkQueue (Work);
+  FbpDeferredWorkQueue (Work);
+  FbpDeferredWorkQueue (Work);
+  gBS->RestoreTPL (OldTpl);
+  if (OldTpl < TPL_CALLBACK) {
+    ASSERT (mDeferredRuns == 1);
+    ASSERT (mDeferredCount == 3);
+  }
+
+  FbpDeferredWorkDestroy (Work);
+}
+
+TEST_DEF (DevWithInterruptsExtended) {
+  EFI_DT_PROPERTY     Interrupt;
+  EFI_HANDLE          InterruptParent;
+  EFI_DT_IO_PROTOCOL  *FoundDtIo;
+  CONST CHAR8         *String;
+  UINT32              Value;
+  UINTN               Index;
+
+  for (Index = 0; Index < 2; Index++) {
+    ASSERT (FbpInterruptGet (DtIo, Index, &InterruptParent, &Interrupt) == EFI_SUCCESS);
+    ASSERT (gBS->HandleProtocol (InterruptParent, &gEfiDtIoProtocolGuid, (VOID **)&FoundDtIo) == EFI_SUCCESS);
+    ASSERT (FoundDtIo->GetString (FoundDtIo, "test", 0, &String) == EFI_SUCCESS);
+    ASSERT (AsciiStrCmp (String, "TestPic") == 0);
+    ASSERT (FoundDtIo->ParseProp (FoundDtIo, &Interrupt, EFI_DT_VALUE_U32, 0, &Value) == EFI_SUCCESS);
+    ASSERT (Value == 5 + Index);
+    ASSERT (FoundDtIo->ParseProp (FoundDtIo, &Interrupt, EFI_DT_VALUE_U32, 0, &Value) == EFI_SUCCESS);
+    ASSERT (Value == (Index == 0 ? 1 : 4));
+  }
+
+  ASSERT (FbpInterruptGet (DtIo, 2, &InterruptParent, &Interrupt) == EFI_NOT_FOUND);
 }
 
 TEST_DEF (DevWithInterruptUnderNexus) {
@@ -958,6 +1236,17 @@ TEST_DEF (DevWithInterruptUnderNexus) {
   //
   ASSERT (FbpInterruptGet (DtIo, 3, &InterruptParent, &Interrupt) == EFI_DEVICE_ERROR);
   ASSERT (FbpInterruptGet (DtIo, 4, &InterruptParent, &Interrupt) == EFI_NOT_FOUND);
+
+  //
+  // Repeat lookups go through the decoded interrupt-map.
+  //
+  ASSERT (FbpInterruptGet (DtIo, 1, &InterruptParent, &Interrupt) == EFI_SUCCESS);
+  ASSERT (gBS->HandleProtocol (InterruptParent, &gEfiDtIoProtocolGuid, (VOID **)&FoundDtIo) == EFI_SUCCESS);
+  ASSERT (FoundDtIo->ParseProp (FoundDtIo, &Interrupt, EFI_DT_VALUE_U32, 0, &Value) == EFI_SUCCESS);
+  ASSERT (Value == 0xee);
+  ASSERT (FoundDtIo->ParseProp (FoundDtIo, &Interrupt, EFI_DT_VALUE_U32, 0, &Value) == EFI_SUCCESS);
+  ASSERT (Value == 2);
+  ASSERT (FbpInterruptGet (DtIo, 3, &InterruptParent, &Interrupt) == EFI_DEVICE_ERROR);
 }
 
 STATIC TestDesc  TestDescs[] = {
@@ -988,8 +1277,10 @@ STATIC TestDesc  TestDescs[] = {
   TEST_DECL (Dma2),
   TEST_DECL (Dma3),
   TEST_DECL (Dma4),
+  TEST_DECL (Dma5),
   TEST_DECL (LookupTest),
   TEST_DECL (DevWithInterrupt),
+  TEST_DECL (DevWithInterruptsExtended),
   TEST_DECL (DevWithInterruptUnderNexus)
 };
 
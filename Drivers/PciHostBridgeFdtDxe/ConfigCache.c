@@ -0,0 +1,499 @@
+/** @file
+    Read cache for read-only PCI configuration space fields.
+
+    PciBusDxe reads the same read-only registers (IDs, class code, header
+    type, capability pointers and capability list headers) many times over
+    during enumeration. On ECAM implementations where configuration
+    accesses trap to a hypervisor or firmware, that adds up quickly.
+
+    With PcdPciConfigReadCache, these bytes of the standard configuration
+    header are cached per function, keyed by ECAM offset. Any write to a
+    function drops its cached data, but not its header type. Writes that
+    may change bus routing below a bridge (bus numbers, bridge control)
+    drop the whole cache, unless the function is known not to be a bridge.
+    The cache is freed at EndOfDxe, after which every access goes to the
+    hardware.
+
+    Copyright (c) 2024, Intel Corporation. All rights reserved.<BR>
+
+    SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "Driver.h"
+
+#define PCI_CONFIG_CACHE_SHIFT     7
+#define PCI_CONFIG_CACHE_ENTRIES   (1 << PCI_CONFIG_CACHE_SHIFT)
+#define PCI_CONFIG_CACHE_SIZE      0x100
+#define PCI_CONFIG_CACHE_NO_ENTRY  MAX_UINT32
+
+//
+// Multiplicative hashing, so that functions on consecutive buses
+// don't all land in the same slots.
+//
+#define PCI_CONFIG_CACHE_SLOT(Function)     ((UINT32)((Function) * 0x9E3779B1U) >> (32 - PCI_CONFIG_CACHE_SHIFT))
+#define PCI_CONFIG_CACHE_TEST(Map, Offset)  (((Map)[(Offset) / 8] & (1 << ((Offset) % 8))) != 0)
+#define PCI_CONFIG_CACHE_SET(Map, Offset)   ((Map)[(Offset) / 8] |= (1 << ((Offset) % 8)))
+
+typedef struct {
+  //
+  // ECAM offset of the function >> 12, or PCI_CONFIG_CACHE_NO_ENTRY.
+  //
+  UINT32     Function;
+  //
+  // Kept when a write drops the cached data, so that writes to type 0
+  // functions that overlap bridge registers (e.g. sizing BAR2 at 18h)
+  // don't flush the whole cache.
+  //
+  BOOLEAN    HeaderTypeKnown;
+  UINT8      HeaderType;
+  //
+  // Bytes known to be read-only, bytes that are cached, and bytes
+  // holding a capability pointer.
+  //
+  UINT8      Cacheable[PCI_CONFIG_CACHE_SIZE / 8];
+  UINT8      Valid[PCI_CONFIG_CACHE_SIZE / 8];
+  UINT8      CapPointer[PCI_CONFIG_CACHE_SIZE / 8];
+  UINT8      Data[PCI_CONFIG_CACHE_SIZE];
+} PCI_CONFIG_CACHE_ENTRY;
+
+struct _PCI_CONFIG_CACHE {
+  UINT64                    Hits;
+  UINT64                    Accesses;
+  PCI_CONFIG_CACHE_ENTRY    Entries[PCI_CONFIG_CACHE_ENTRIES];
+};
+
+/**
+  Compute the configuration space byte range touched by an access.
+
+  @param Width        Signifies the width of the access.
+  @param EcamOffset   ECAM offset of the first register.
+  @param Count        The number of operations.
+  @param Function     Function part of EcamOffset.
+  @param Offset       Register part of EcamOffset.
+  @param Length       Number of bytes touched.
+
+**/
+STATIC
+VOID
+ConfigCacheRange (
+  IN  EFI_PCI_ROOT_BRIDGE_IO_PROTOCOL_WIDTH  Width,
+  IN  UINTN                                  EcamOffset,
+  IN  UINTN                                  Count,
+  OUT UINT32                                 *Function,
+  OUT UINTN                                  *Offset,
+  OUT UINTN                                  *Length
+  )
+{
+  if ((Width >= EfiPciWidthFifoUint8) && (Width <= EfiPciWidthFifoUint64)) {
+    Count = 1;
+  }
+
+  *Function = (UINT32)(EcamOffset >> 12);
+  *Offset   = EcamOffset & 0xFFF;
+  *Length   = Count << (Width & 0x03);
+}
+
+/**
+  Look up the cache entry for a function.
+
+  @param Cache      PCI_CONFIG_CACHE *.
+  @param Function   ECAM offset of the function >> 12.
+
+  @return PCI_CONFIG_CACHE_ENTRY * or NULL.
+
+**/
+STATIC
+PCI_CONFIG_CACHE_ENTRY *
+ConfigCacheFind (
+  IN  PCI_CONFIG_CACHE  *Cache,
+  IN  UINT32            Function
+  )
+{
+  PCI_CONFIG_CACHE_ENTRY  *Entry;
+
+  Entry = &Cache->Entries[PCI_CONFIG_CACHE_SLOT (Function)];
+  if (Entry->Function != Function) {
+    return NULL;
+  }
+
+  return Entry;
+}
+
+/**
+  Drop every cache entry.
+
+  @param Cache      PCI_CONFIG_CACHE *.
+
+**/
+STATIC
+VOID
+ConfigCacheFlush (
+  IN  PCI_CONFIG_CACHE  *Cache
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; Index < PCI_CONFIG_CACHE_ENTRIES; Index++) {
+    Cache->Entries[Index].Function = PCI_CONFIG_CACHE_NO_ENTRY;
+  }
+}
+
+/**
+  Drop the cached data of a function, keeping the entry itself
+  and the header type.
+
+  @param Entry      PCI_CONFIG_CACHE_ENTRY *.
+
+**/
+STATIC
+VOID
+ConfigCacheInvalidate (
+  IN  PCI_CONFIG_CACHE_ENTRY  *Entry
+  )
+{
+  UINTN  Offset;
+
+  ZeroMem (Entry->Cacheable, sizeof (Entry->Cacheable));
+  ZeroMem (Entry->Valid, sizeof (Entry->Valid));
+  ZeroMem (Entry->CapPointer, sizeof (Entry->CapPointer));
+
+  for (Offset = PCI_VENDOR_ID_OFFSET; Offset < PCI_COMMAND_OFFSET; Offset++) {
+    PCI_CONFIG_CACHE_SET (Entry->Cacheable, Offset);
+  }
+
+  for (Offset = PCI_REVISION_ID_OFFSET; Offset < PCI_CLASSCODE_OFFSET + 3; Offset++) {
+    PCI_CONFIG_CACHE_SET (Entry->Cacheable, Offset);
+  }
+
+  PCI_CONFIG_CACHE_SET (Entry->Cacheable, PCI_HEADER_TYPE_OFFSET);
+  PCI_CONFIG_CACHE_SET (Entry->Cacheable, PCI_CAPBILITY_POINTER_OFFSET);
+  PCI_CONFIG_CACHE_SET (Entry->CapPointer, PCI_CAPBILITY_POINTER_OFFSET);
+}
+
+/**
+  Start caching a function, evicting whatever shares its slot.
+
+  @param Cache      PCI_CONFIG_CACHE *.
+  @param Function   ECAM offset of the function >> 12.
+
+  @return PCI_CONFIG_CACHE_ENTRY *.
+
+**/
+STATIC
+PCI_CONFIG_CACHE_ENTRY *
+ConfigCacheAdd (
+  IN  PCI_CONFIG_CACHE  *Cache,
+  IN  UINT32            Function
+  )
+{
+  PCI_CONFIG_CACHE_ENTRY  *Entry;
+
+  Entry = &Cache->Entries[PCI_CONFIG_CACHE_SLOT (Function)];
+  ZeroMem (Entry, sizeof (*Entry));
+  Entry->Function = Function;
+  ConfigCacheInvalidate (Entry);
+
+  return Entry;
+}
+
+/**
+  Serve a configuration space read from the cache, if possible.
+
+  Must be called at TPL_NOTIFY.
+
+  @param RootBridge   PCI_ROOT_BRIDGE_INSTANCE *.
+  @param Width        Signifies the width of the read.
+  @param EcamOffset   ECAM offset of the first register.
+  @param Count        The number of reads.
+  @param Buffer       The destination buffer.
+
+  @retval TRUE        Buffer was filled from the cache.
+  @retval FALSE       The hardware needs to be accessed.
+
+**/
+BOOLEAN
+ConfigCacheLookup (
+  IN  PCI_ROOT_BRIDGE_INSTANCE               *RootBridge,
+  IN  EFI_PCI_ROOT_BRIDGE_IO_PROTOCOL_WIDTH  Width,
+  IN  UINTN                                  EcamOffset,
+  IN  UINTN                                  Count,
+  OUT VOID                                   *Buffer
+  )
+{
+  PCI_CONFIG_CACHE        *Cache;
+  PCI_CONFIG_CACHE_ENTRY  *Entry;
+  UINT32                  Function;
+  UINTN                   Offset;
+  UINTN                   Length;
+  UINTN                   Index;
+
+  Cache = RootBridge->ConfigCache;
+  if ((Cache == NULL) || (Width >= EfiPciWidthFifoUint8)) {
+    return FALSE;
+  }
+
+  ConfigCacheRange (Width, EcamOffset, Count, &Function, &Offset, &Length);
+  if (Offset + Length > PCI_CONFIG_CACHE_SIZE) {
+    return FALSE;
+  }
+
+  Entry = ConfigCacheFind (Cache, Function);
+  if (Entry == NULL) {
+    return FALSE;
+  }
+
+  for (Index = Offset; Index < Offset + Length; Index++) {
+    if (!PCI_CONFIG_CACHE_TEST (Entry->Valid, Index)) {
+      return FALSE;
+    }
+  }
+
+  CopyMem (Buffer, &Entry->Data[Offset], Length);
+  Cache->Hits++;
+  return TRUE;
+}
+
+/**
+  Update the cache after a configuration space access went to the
+  hardware.
+
+  Must be called at TPL_NOTIFY.
+
+  @param RootBridge   PCI_ROOT_BRIDGE_INSTANCE *.
+  @param Read         TRUE for a completed read, FALSE for a write.
+  @param Width        Signifies the width of the access.
+  @param EcamOffset   ECAM offset of the first register.
+  @param Count        The number of operations.
+  @param Buffer       The data read or written.
+
+**/
+VOID
+ConfigCacheUpdate (
+  IN  PCI_ROOT_BRIDGE_INSTANCE               *RootBridge,
+  IN  BOOLEAN                                Read,
+  IN  EFI_PCI_ROOT_BRIDGE_IO_PROTOCOL_WIDTH  Width,
+  IN  UINTN                                  EcamOffset,
+  IN  UINTN                                  Count,
+  IN  CONST VOID                             *Buffer
+  )
+{
+  PCI_CONFIG_CACHE        *Cache;
+  PCI_CONFIG_CACHE_ENTRY  *Entry;
+  CONST UINT8             *Data;
+  UINT32                  Function;
+  UINTN                   Offset;
+  UINTN                   Length;
+  UINTN                   Index;
+  UINT8                   Pointer;
+  UINT16                  VendorId;
+
+  Cache = RootBridge->ConfigCache;
+  if (Cache == NULL) {
+    return;
+  }
+
+  Cache->Accesses++;
+
+  ConfigCacheRange (Width, EcamOffset, Count, &Function, &Offset, &Length);
+  Entry = ConfigCacheFind (Cache, Function);
+
+  if (!Read) {
+    //
+    // Bus numbers and bridge control (e.g. secondary bus reset) on a
+    // bridge affect every function below it, which the cache can't
+    // tell apart from the rest.
+    //
+    if (((Offset < PCI_BRIDGE_PRIMARY_BUS_REGISTER_OFFSET + 3) &&
+         (Offset + Length > PCI_BRIDGE_PRIMARY_BUS_REGISTER_OFFSET)) ||
+        ((Offset < OFFSET_OF (PCI_TYPE01, Bridge.BridgeControl) + 2) &&
+         (Offset + Length > OFFSET_OF (PCI_TYPE01, Bridge.BridgeControl))))
+    {
+      if ((Entry == NULL) || !Entry->HeaderTypeKnown ||
+          ((Entry->HeaderType & HEADER_LAYOUT_CODE) != HEADER_TYPE_DEVICE))
+      {
+        ConfigCacheFlush (Cache);
+        return;
+      }
+    }
+
+    if (Entry != NULL) {
+      ConfigCacheInvalidate (Entry);
+    }
+
+    return;
+  }
+
+  if ((Width >= EfiPciWidthFifoUint8) || (Offset + Length > PCI_CONFIG_CACHE_SIZE)) {
+    return;
+  }
+
+  Data = Buffer;
+  if (Entry == NULL) {
+    //
+    // Only cache functions that exist. A Vendor ID of 0001h is a
+    // Configuration Request Retry Status completion, i.e. the function
+    // is not ready yet.
+    //
+    if ((Offset != PCI_VENDOR_ID_OFFSET) || (Length < sizeof (UINT16))) {
+      return;
+    }
+
+    VendorId = ReadUnaligned16 ((CONST UINT16 *)Data);
+    if ((VendorId == MAX_UINT16) || (VendorId == 0x0001)) {
+      return;
+    }
+
+    Entry = ConfigCacheAdd (Cache, Function);
+  }
+
+  for (Index = Offset; Index < Offset + Length; Index++) {
+    if (!PCI_CONFIG_CACHE_TEST (Entry->Cacheable, Index)) {
+      continue;
+    }
+
+    Entry->Data[Index] = Data[Index - Offset];
+    PCI_CONFIG_CACHE_SET (Entry->Valid, Index);
+
+    if (Index == PCI_HEADER_TYPE_OFFSET) {
+      Entry->HeaderType      = Entry->Data[Index];
+      Entry->HeaderTypeKnown = TRUE;
+    }
+
+    if (PCI_CONFIG_CACHE_TEST (Entry->CapPointer, Index)) {
+      //
+      // Follow the capability list: the ID and next pointer of the
+      // capability pointed to are read-only too.
+      //
+      Pointer = Entry->Data[Index] & ~(UINT8)0x3;
+      if (Pointer >= sizeof (PCI_TYPE00)) {
+        PCI_CONFIG_CACHE_SET (Entry->Cacheable, Pointer);
+        PCI_CONFIG_CACHE_SET (Entry->Cacheable, Pointer + 1);
+        PCI_CONFIG_CACHE_SET (Entry->CapPointer, Pointer + 1);
+      }
+    }
+  }
+}
+
+/**
+  Stop caching at EndOfDxe.
+
+  @param Event          EFI_EVENT.
+  @param Context        PCI_ROOT_BRIDGE_INSTANCE *.
+
+**/
+STATIC
+VOID
+EFIAPI
+ConfigCacheOnEndOfDxe (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  PCI_ROOT_BRIDGE_INSTANCE  *RootBridge;
+  PCI_CONFIG_CACHE          *Cache;
+  EFI_TPL                   Tpl;
+
+  RootBridge = Context;
+
+  Tpl                     = gBS->RaiseTPL (TPL_NOTIFY);
+  Cache                   = RootBridge->ConfigCache;
+  RootBridge->ConfigCache = NULL;
+  gBS->RestoreTPL (Tpl);
+
+  if (Cache != NULL) {
+    DEBUG ((
+      DEBUG_INFO,
+      "%s: config cache: %lu hits, %lu ECAM accesses\n",
+      RootBridge->DevicePathStr,
+      Cache->Hits,
+      Cache->Accesses
+      ));
+    FreePool (Cache);
+  }
+
+  gBS->CloseEvent (Event);
+  RootBridge->ConfigCacheEndOfDxeEvent = NULL;
+}
+
+/**
+  Enable the configuration space read cache, if PcdPciConfigReadCache
+  is set.
+
+  @param RootBridge   PCI_ROOT_BRIDGE_INSTANCE *.
+
+  @retval EFI_SUCCESS   Cache enabled.
+  @retval Other         Configuration space reads remain uncached.
+
+**/
+EFI_STATUS
+ConfigCacheInit (
+  IN  PCI_ROOT_BRIDGE_INSTANCE  *RootBridge
+  )
+{
+  EFI_STATUS        Status;
+  PCI_CONFIG_CACHE  *Cache;
+
+  if (!PcdGetBool (PcdPciConfigReadCache)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  Cache = AllocateZeroPool (sizeof (PCI_CONFIG_CACHE));
+  if (Cache == NULL) {
+    DEBUG ((
+      DEBUG_ERROR,
+      "%s: %a: AllocateZeroPool: %r\n",
+      RootBridge->DevicePathStr,
+      __func__,
+      EFI_OUT_OF_RESOURCES
+      ));
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  ConfigCacheFlush (Cache);
+
+  Status = gBS->CreateEventEx (
+                  EVT_NOTIFY_SIGNAL,
+                  TPL_CALLBACK,
+                  ConfigCacheOnEndOfDxe,
+                  RootBridge,
+                  &gEfiEndOfDxeEventGroupGuid,
+                  &RootBridge->ConfigCacheEndOfDxeEvent
+                  );
+  if (EFI_ERROR (Status)) {
+    DEBUG ((
+      DEBUG_ERROR,
+      "%s: %a: CreateEventEx: %r\n",
+      RootBridge->DevicePathStr,
+      __func__,
+      Status
+      ));
+    FreePool (Cache);
+    return Status;
+  }
+
+  RootBridge->ConfigCache = Cache;
+  return EFI_SUCCESS;
+}
+
+/**
+  Free the configuration space read cache, if still around.
+
+  @param RootBridge   PCI_ROOT_BRIDGE_INSTANCE *.
+
+**/
+VOID
+ConfigCacheFree (
+  IN  PCI_ROOT_BRIDGE_INSTANCE  *RootBridge
+  )
+{
+  if (RootBridge->ConfigCacheEndOfDxeEvent != NULL) {
+    gBS->CloseEvent (RootBridge->ConfigCacheEndOfDxeEvent);
+    RootBridge->ConfigCacheEndOfDxeEvent = NULL;
+  }
+
+  if (RootBridge->ConfigCache != NULL) {
+    FreePool (RootBridge->ConfigCache);
+    RootBridge->ConfigCache = NULL;
+  }
+}
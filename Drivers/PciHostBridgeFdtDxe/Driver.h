@@ -25,6 +25,10 @@
 #include <Library/FbpUtilsLib.h>
 #include <Library/FbpPciUtilsLib.h>
 #include <Library/PcdLib.h>
+#include <Library/IoLib.h>
+#include <Library/TimerLib.h>
+#include <Library/BaseLib.h>
+#include <Library/UefiRuntimeServicesTableLib.h>
 #include <Protocol/DtIo.h>
 #include <Protocol/PciIo.h>
 #include <Protocol/PciRootBridgeIo.h>
@@ -92,6 +96,29 @@ typedef struct {
   BOOLEAN                 ResTracked;
 } PCI_RES_NODE;
 
+typedef struct _PCI_CONFIG_CACHE PCI_CONFIG_CACHE;
+
+//
+// Io: VgaIo1, VgaIo2, Io. Mem: Mem, VgaMem, PMem, MemAbove4G, PMemAbove4G.
+//
+#define PCI_ROOT_BRIDGE_APERTURES_MAX  5
+
+typedef struct {
+  UINT64        Base;
+  UINT64        Limit;
+  EFI_DT_REG    Reg;
+} PCI_ROOT_BRIDGE_APERTURE;
+
+//
+// Apertures valid for an access type, sorted by Base, with adjacent
+// and overlapping apertures sharing a translation merged.
+//
+typedef struct {
+  UINTN                       Count;
+  UINTN                       LastHit;
+  PCI_ROOT_BRIDGE_APERTURE    Entries[PCI_ROOT_BRIDGE_APERTURES_MAX];
+} PCI_ROOT_BRIDGE_APERTURES;
+
 typedef struct _PCI_ROOT_BRIDGE_INSTANCE PCI_ROOT_BRIDGE_INSTANCE;
 
 struct _PCI_ROOT_BRIDGE_INSTANCE {
@@ -104,6 +131,16 @@ struct _PCI_ROOT_BRIDGE_INSTANCE {
 
   UINT32                                              Segment;
   EFI_DT_REG                                          ConfigReg;
+  //
+  // CPU address of ConfigReg, when it can be accessed directly.
+  //
+  BOOLEAN                                             EcamDirect;
+  EFI_PHYSICAL_ADDRESS                                EcamBase;
+  //
+  // Manipulated by ConfigCache.c.
+  //
+  PCI_CONFIG_CACHE                                    *ConfigCache;
+  EFI_EVENT                                           ConfigCacheEndOfDxeEvent;
   UINT64                                              Attributes;
   UINT64                                              Supports;
   PCI_RES_NODE                                        ResAllocNode[TypeMax];
@@ -116,14 +153,23 @@ struct _PCI_ROOT_BRIDGE_INSTANCE {
   EFI_DT_RANGE                                        VgaMemRange;
   EFI_DT_RANGE                                        VgaIo1Range;
   EFI_DT_RANGE                                        VgaIo2Range;
+  //
+  // Built from the ranges above, for RootBridgeIoCheckParameter.
+  //
+  PCI_ROOT_BRIDGE_APERTURES                           IoApertures;
+  PCI_ROOT_BRIDGE_APERTURES                           MemApertures;
   BOOLEAN                                             DmaAbove4G;
   BOOLEAN                                             NoExtendedConfigSpace;
   BOOLEAN                                             KeepExistingConfig;
+  BOOLEAN                                             PersistConfig;
+  BOOLEAN                                             PMemWriteCombine;
+  BOOLEAN                                             PreferAbove4G;
   //
   // Manipulated by HostBridge.c.
   //
   BOOLEAN                                             ResourceSubmitted;
   BOOLEAN                                             CanRestart;
+  UINT64                                              EnumerationStart;
   UINT64                                              AllocationAttributes;
   EFI_PCI_HOST_BRIDGE_RESOURCE_ALLOCATION_PROTOCOL    ResAlloc;
 };
@@ -166,4 +212,33 @@ GetTranslationByResourceType (
   IN  PCI_RESOURCE_TYPE         ResourceType
   );
 
+EFI_STATUS
+ConfigCacheInit (
+  IN  PCI_ROOT_BRIDGE_INSTANCE  *RootBridge
+  );
+
+VOID
+ConfigCacheFree (
+  IN  PCI_ROOT_BRIDGE_INSTANCE  *RootBridge
+  );
+
+BOOLEAN
+ConfigCacheLookup (
+  IN  PCI_ROOT_BRIDGE_INSTANCE               *RootBridge,
+  IN  EFI_PCI_ROOT_BRIDGE_IO_PROTOCOL_WIDTH  Width,
+  IN  UINTN                                  EcamOffset,
+  IN  UINTN                                  Count,
+  OUT VOID                                   *Buffer
+  );
+
+VOID
+ConfigCacheUpdate (
+  IN  PCI_ROOT_BRIDGE_INSTANCE               *RootBridge,
+  IN  BOOLEAN                                Read,
+  IN  EFI_PCI_ROOT_BRIDGE_IO_PROTOCOL_WIDTH  Width,
+  IN  UINTN                                  EcamOffset,
+  IN  UINTN                                  Count,
+  IN  CONST VOID                             *Buffer
+  );
+
 #endif /* __DRIVER_H__ */
@@ -23,9 +23,75 @@ GLOBAL_REMOVE_IF_UNREFERENCED CHAR16  *mAcpiAddressSpaceTypeStr[] = {
   L"Mem", L"I/O", L"Bus"
 };
 
+/**
+  Allocate Length of MMIO or IO resource at exactly BaseAddress.
+
+  @param Mmio            TRUE for MMIO and FALSE for IO.
+  @param Length          Length of the resource to allocate.
+  @param BitsOfAlignment Alignment of the resource to allocate.
+  @param BaseAddress     The address to allocate at.
+
+  @retval  The base address of the allocated resource or MAX_UINT64 if allocation
+           fails.
+**/
+STATIC
+UINT64
+AllocateResourceAt (
+  IN  BOOLEAN  Mmio,
+  IN  UINT64   Length,
+  IN  UINTN    BitsOfAlignment,
+  IN  UINT64   BaseAddress
+  )
+{
+  EFI_STATUS  Status;
+
+  if (Mmio) {
+    Status = gDS->AllocateMemorySpace (
+                    EfiGcdAllocateAddress,
+                    EfiGcdMemoryTypeMemoryMappedIo,
+                    BitsOfAlignment,
+                    Length,
+                    &BaseAddress,
+                    gImageHandle,
+                    NULL
+                    );
+  } else {
+    Status = gDS->AllocateIoSpace (
+                    EfiGcdAllocateAddress,
+                    EfiGcdIoTypeIo,
+                    BitsOfAlignment,
+                    Length,
+                    &BaseAddress,
+                    gImageHandle,
+                    NULL
+                    );
+  }
+
+  if (EFI_ERROR (Status)) {
+    DEBUG ((
+      DEBUG_ERROR,
+      "%a: Allocate%aSpace(0x%lx, 0x%lx): %r\n",
+      __func__,
+      Mmio ? "Memory" : "Io",
+      BaseAddress,
+      Length,
+      Status
+      ));
+    return MAX_UINT64;
+  }
+
+  return BaseAddress;
+}
+
 /**
   Allocate Length of MMIO or IO resource with alignment BitsOfAlignment
-  from GCD range [BaseAddress, Limit).
+  from GCD range [BaseAddress, Limit].
+
+  Rather than probing the range one alignment step at a time, the GCD
+  map is scanned once for free space. Of all the free intervals inside
+  the range that can fit the resource, the smallest one is used (lowest
+  address on a tie), which keeps large free intervals intact for later,
+  larger allocations.
 
   @param Mmio            TRUE for MMIO and FALSE for IO.
   @param Length          Length of the resource to allocate.
@@ -46,51 +112,564 @@ AllocateResource (
   IN  UINT64   Limit
   )
 {
-  EFI_STATUS  Status;
+  EFI_STATUS                       Status;
+  UINTN                            NumberOfDescriptors;
+  EFI_GCD_MEMORY_SPACE_DESCRIPTOR  *MemorySpaceMap;
+  EFI_GCD_IO_SPACE_DESCRIPTOR      *IoSpaceMap;
+  UINTN                            Index;
+  UINT64                           Alignment;
+  UINT64                           FreeBase;
+  UINT64                           FreeLimit;
+  UINT64                           DescBase;
+  UINT64                           DescLength;
+  BOOLEAN                          DescFree;
+  UINT64                           Candidate;
+  UINT64                           BestBase;
+  UINT64                           BestSize;
+
+  if ((BaseAddress >= Limit) || (Length == 0)) {
+    return MAX_UINT64;
+  }
+
+  //
+  // Have to make sure Aligment is handled since we are doing direct address allocation
+  // Strictly speaking, alignment requirement should be applied to device
+  // address instead of host address which is used in GCD manipulation below,
+  // but as we restrict the alignment of Translation to be larger than any BAR
+  // alignment in the root bridge, we can simplify the situation and consider
+  // the same alignment requirement is also applied to host address.
+  //
+  Alignment      = LShiftU64 (1, BitsOfAlignment);
+  MemorySpaceMap = NULL;
+  IoSpaceMap     = NULL;
+
+  if (Mmio) {
+    Status = gDS->GetMemorySpaceMap (&NumberOfDescriptors, &MemorySpaceMap);
+  } else {
+    Status = gDS->GetIoSpaceMap (&NumberOfDescriptors, &IoSpaceMap);
+  }
+
+  if (EFI_ERROR (Status)) {
+    DEBUG ((
+      DEBUG_ERROR,
+      "%a: Get%aSpaceMap(): %r\n",
+      __func__,
+      Mmio ? "Memory" : "Io",
+      Status
+      ));
+    return MAX_UINT64;
+  }
+
+  //
+  // The GCD maps are sorted by address. Adjacent free descriptors
+  // (e.g. ones differing only in capabilities) are coalesced into a
+  // single free interval [FreeBase, FreeLimit], since an
+  // EfiGcdAllocateAddress allocation may span them.
+  //
+  BestBase  = MAX_UINT64;
+  BestSize  = MAX_UINT64;
+  FreeBase  = MAX_UINT64;
+  FreeLimit = 0;
+  for (Index = 0; Index <= NumberOfDescriptors; Index++) {
+    if (Index == NumberOfDescriptors) {
+      DescBase   = MAX_UINT64;
+      DescLength = 0;
+      DescFree   = FALSE;
+    } else if (Mmio) {
+      DescBase   = MemorySpaceMap[Index].BaseAddress;
+      DescLength = MemorySpaceMap[Index].Length;
+      DescFree   = (MemorySpaceMap[Index].GcdMemoryType == EfiGcdMemoryTypeMemoryMappedIo) &&
+                   (MemorySpaceMap[Index].ImageHandle == NULL);
+    } else {
+      DescBase   = IoSpaceMap[Index].BaseAddress;
+      DescLength = IoSpaceMap[Index].Length;
+      DescFree   = (IoSpaceMap[Index].GcdIoType == EfiGcdIoTypeIo) &&
+                   (IoSpaceMap[Index].ImageHandle == NULL);
+    }
+
+    if (DescFree && (DescLength != 0)) {
+      if ((FreeBase != MAX_UINT64) && (DescBase == FreeLimit + 1)) {
+        FreeLimit = DescBase + DescLength - 1;
+        continue;
+      }
+    }
 
-  if (BaseAddress < Limit) {
     //
-    // Have to make sure Aligment is handled since we are doing direct address allocation
-    // Strictly speaking, alignment requirement should be applied to device
-    // address instead of host address which is used in GCD manipulation below,
-    // but as we restrict the alignment of Translation to be larger than any BAR
-    // alignment in the root bridge, we can simplify the situation and consider
-    // the same alignment requirement is also applied to host address.
+    // The interval being coalesced (if any) ends here. Clip it
+    // to [BaseAddress, Limit] and see if the resource fits.
     //
-    BaseAddress = ALIGN_VALUE (BaseAddress, LShiftU64 (1, BitsOfAlignment));
-
-    while (BaseAddress + Length <= Limit + 1) {
-      if (Mmio) {
-        Status = gDS->AllocateMemorySpace (
-                        EfiGcdAllocateAddress,
-                        EfiGcdMemoryTypeMemoryMappedIo,
-                        BitsOfAlignment,
-                        Length,
-                        &BaseAddress,
-                        gImageHandle,
-                        NULL
-                        );
-      } else {
-        Status = gDS->AllocateIoSpace (
-                        EfiGcdAllocateAddress,
-                        EfiGcdIoTypeIo,
-                        BitsOfAlignment,
-                        Length,
-                        &BaseAddress,
-                        gImageHandle,
-                        NULL
-                        );
+    if ((FreeBase != MAX_UINT64) &&
+        (FreeBase <= Limit) && (FreeLimit >= BaseAddress))
+    {
+      FreeBase  = MAX (FreeBase, BaseAddress);
+      FreeLimit = MIN (FreeLimit, Limit);
+      Candidate = ALIGN_VALUE (FreeBase, Alignment);
+      if ((Candidate >= FreeBase) && (Candidate <= FreeLimit) &&
+          (FreeLimit - Candidate >= Length - 1) &&
+          (FreeLimit - FreeBase < BestSize))
+      {
+        BestBase = Candidate;
+        BestSize = FreeLimit - FreeBase;
       }
+    }
+
+    FreeBase = MAX_UINT64;
+    if (DescFree && (DescLength != 0)) {
+      FreeBase  = DescBase;
+      FreeLimit = DescBase + DescLength - 1;
+    }
+  }
+
+  if (Mmio) {
+    FreePool (MemorySpaceMap);
+  } else {
+    FreePool (IoSpaceMap);
+  }
+
+  if (BestBase == MAX_UINT64) {
+    return MAX_UINT64;
+  }
+
+  return AllocateResourceAt (Mmio, Length, BitsOfAlignment, BestBase);
+}
+
+//
+// Aperture assignment persisted across boots for root bridges
+// with fdtbuspkg,pci-persist-config. Stored in a variable named
+// after the root bridge device path.
+//
+typedef struct {
+  UINT32    Fingerprint;
+  UINT32    Reserved;
+  UINT64    Base[TypeBus];
+  UINT64    Length[TypeBus];
+} PCI_PERSISTED_ASSIGNMENT;
 
-      if (!EFI_ERROR (Status)) {
-        return BaseAddress;
+/**
+  Fingerprint the root bridge windows and the resources submitted by
+  the PCI bus driver, so a persisted assignment is only reused when
+  nothing changed.
+
+  @param RootBridge  PCI_ROOT_BRIDGE_INSTANCE *.
+
+  @retval  CRC32 of the root bridge configuration and resource requests.
+**/
+STATIC
+UINT32
+HostBridgeFingerprint (
+  IN  PCI_ROOT_BRIDGE_INSTANCE  *RootBridge
+  )
+{
+  UINT64        Data[3 + 3 * (TypeBus - TypeIo) + 2 * (TypeBus - TypeIo)];
+  UINTN         Count;
+  UINTN         Index;
+  EFI_DT_RANGE  *Ranges[TypeBus - TypeIo];
+
+  Ranges[TypeIo]     = &RootBridge->IoRange;
+  Ranges[TypeMem32]  = &RootBridge->MemRange;
+  Ranges[TypePMem32] = &RootBridge->PMemRange;
+  Ranges[TypeMem64]  = &RootBridge->MemAbove4GRange;
+  Ranges[TypePMem64] = &RootBridge->PMemAbove4GRange;
+
+  Count         = 0;
+  Data[Count++] = RootBridge->Segment;
+  Data[Count++] = RB (RootBridge->BusRange);
+  Data[Count++] = RS (RootBridge->BusRange);
+
+  for (Index = TypeIo; Index < TypeBus; Index++) {
+    Data[Count++] = RB (*Ranges[Index]);
+    Data[Count++] = RS (*Ranges[Index]);
+    Data[Count++] = RT (*Ranges[Index]);
+    Data[Count++] = RootBridge->ResAllocNode[Index].Length;
+    Data[Count++] = RootBridge->ResAllocNode[Index].Alignment;
+  }
+
+  ASSERT (Count == ARRAY_SIZE (Data));
+  return CalculateCrc32 (Data, sizeof (Data));
+}
+
+/**
+  Load the persisted aperture assignment for a root bridge.
+
+  @param RootBridge   PCI_ROOT_BRIDGE_INSTANCE *.
+  @param Fingerprint  Result of HostBridgeFingerprint.
+  @param Assignment   Persisted assignment.
+
+  @retval TRUE        Assignment matches the current configuration.
+  @retval FALSE       No usable persisted assignment.
+**/
+STATIC
+BOOLEAN
+HostBridgeLoadAssignment (
+  IN  PCI_ROOT_BRIDGE_INSTANCE  *RootBridge,
+  IN  UINT32                    Fingerprint,
+  OUT PCI_PERSISTED_ASSIGNMENT  *Assignment
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       Size;
+
+  Size   = sizeof (*Assignment);
+  Status = gRT->GetVariable (
+                  RootBridge->DevicePathStr,
+                  &gFdtBusPkgPciAssignmentGuid,
+                  NULL,
+                  &Size,
+                  Assignment
+                  );
+  if (EFI_ERROR (Status) || (Size != sizeof (*Assignment))) {
+    return FALSE;
+  }
+
+  if (Assignment->Fingerprint != Fingerprint) {
+    DEBUG ((
+      DEBUG_INFO,
+      "%s: persisted PCI assignment is stale\n",
+      RootBridge->DevicePathStr
+      ));
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+/**
+  Persist the aperture assignment for a root bridge, if it changed.
+
+  @param RootBridge   PCI_ROOT_BRIDGE_INSTANCE *.
+  @param Fingerprint  Result of HostBridgeFingerprint.
+  @param Old          Previously persisted assignment or NULL.
+**/
+STATIC
+VOID
+HostBridgeSaveAssignment (
+  IN  PCI_ROOT_BRIDGE_INSTANCE        *RootBridge,
+  IN  UINT32                          Fingerprint,
+  IN  CONST PCI_PERSISTED_ASSIGNMENT  *Old OPTIONAL
+  )
+{
+  EFI_STATUS                Status;
+  PCI_PERSISTED_ASSIGNMENT  New;
+  UINTN                     Index;
+
+  ZeroMem (&New, sizeof (New));
+  New.Fingerprint = Fingerprint;
+  for (Index = TypeIo; Index < TypeBus; Index++) {
+    if (RootBridge->ResAllocNode[Index].Status == ResAllocated) {
+      New.Base[Index]   = RootBridge->ResAllocNode[Index].Base;
+      New.Length[Index] = RootBridge->ResAllocNode[Index].Length;
+    }
+  }
+
+  if ((Old != NULL) && (CompareMem (Old, &New, sizeof (New)) == 0)) {
+    return;
+  }
+
+  Status = gRT->SetVariable (
+                  RootBridge->DevicePathStr,
+                  &gFdtBusPkgPciAssignmentGuid,
+                  EFI_VARIABLE_NON_VOLATILE | EFI_VARIABLE_BOOTSERVICE_ACCESS,
+                  sizeof (New),
+                  &New
+                  );
+  if (EFI_ERROR (Status)) {
+    DEBUG ((
+      DEBUG_WARN,
+      "%s: couldn't persist PCI assignment: %r\n",
+      RootBridge->DevicePathStr,
+      Status
+      ));
+  }
+}
+
+/**
+  Return whether a (CPU) address range lies entirely within a window.
+
+  @param Range   Window.
+  @param Base    Base of the range.
+  @param Length  Length of the range.
+
+  @retval TRUE   The range is within the window.
+  @retval FALSE  The range is not (entirely) within the window.
+**/
+STATIC
+BOOLEAN
+HostBridgeInWindow (
+  IN  EFI_DT_RANGE  *Range,
+  IN  UINT64        Base,
+  IN  UINT64        Length
+  )
+{
+  if (!RANGE_VALID (*Range) || (Length == 0)) {
+    return FALSE;
+  }
+
+  return (Base >= TO_HOST_ADDRESS (RB (*Range), RT (*Range))) &&
+         (Length - 1 <= TO_HOST_ADDRESS (RL (*Range), RT (*Range)) - Base);
+}
+
+/**
+  Allocate a resource node at its persisted address.
+
+  @param RootBridge       PCI_ROOT_BRIDGE_INSTANCE *.
+  @param Index            Resource type.
+  @param BitsOfAlignment  Alignment of the resource to allocate.
+  @param Base             Persisted (CPU) address.
+
+  @retval  The base address of the allocated resource or MAX_UINT64 if allocation
+           fails.
+**/
+STATIC
+UINT64
+HostBridgeAllocatePersisted (
+  IN  PCI_ROOT_BRIDGE_INSTANCE  *RootBridge,
+  IN  PCI_RESOURCE_TYPE         Index,
+  IN  UINTN                     BitsOfAlignment,
+  IN  UINT64                    Base
+  )
+{
+  UINT64        Length;
+  EFI_DT_RANGE  *Window;
+  EFI_DT_RANGE  *Fallback;
+
+  Length = RootBridge->ResAllocNode[Index].Length;
+  if ((Base & RootBridge->ResAllocNode[Index].Alignment) != 0) {
+    return MAX_UINT64;
+  }
+
+  //
+  // The window configuration may have changed in a way the
+  // fingerprint doesn't catch, so only accept a base that
+  // AllocateResource could have returned.
+  //
+  Fallback = NULL;
+  switch (Index) {
+    case TypeIo:
+      Window = &RootBridge->IoRange;
+      break;
+    case TypeMem32:
+      Window = &RootBridge->MemRange;
+      break;
+    case TypePMem32:
+      Window = &RootBridge->PMemRange;
+      break;
+    case TypeMem64:
+      Window   = &RootBridge->MemAbove4GRange;
+      Fallback = &RootBridge->MemRange;
+      break;
+    case TypePMem64:
+      Window   = &RootBridge->PMemAbove4GRange;
+      Fallback = &RootBridge->PMemRange;
+      if (RootBridge->PreferAbove4G &&
+          (RT (RootBridge->MemAbove4GRange) == RT (RootBridge->PMemAbove4GRange)) &&
+          HostBridgeInWindow (&RootBridge->MemAbove4GRange, Base, Length))
+      {
+        Window = &RootBridge->MemAbove4GRange;
       }
 
-      BaseAddress += LShiftU64 (1, BitsOfAlignment);
+      break;
+    default:
+      ASSERT (FALSE);
+      return MAX_UINT64;
+  }
+
+  if (!HostBridgeInWindow (Window, Base, Length) &&
+      ((Fallback == NULL) || !HostBridgeInWindow (Fallback, Base, Length)))
+  {
+    return MAX_UINT64;
+  }
+
+  if (Index != TypeIo) {
+    return AllocateResourceAt (TRUE, Length, MIN (63, BitsOfAlignment), Base);
+  }
+
+  //
+  // See note in AddIoSpace.
+  //
+  Base = AllocateResourceAt (
+           FALSE,
+           Length,
+           MIN (15, BitsOfAlignment),
+           TO_DEVICE_ADDRESS (Base, RT (RootBridge->IoRange))
+           );
+  if (Base != MAX_UINT64) {
+    Base = TO_HOST_ADDRESS (Base, RT (RootBridge->IoRange));
+  }
+
+  return Base;
+}
+
+/**
+
+  Map an allocated prefetchable memory window as write-combining.
+
+  Needs CPU architecture support for a write-combining memory type
+  (e.g. AArch64 Normal-NC or RISC-V Svpbmt NC). Without it, setting
+  the attributes fails and the window keeps its original attributes.
+
+  Windows that aren't page aligned are left alone, as attributes
+  work on pages and would spill over into whatever shares them.
+
+  @param RootBridge  PCI_ROOT_BRIDGE_INSTANCE *.
+  @param Base        Base of the window.
+  @param Length      Length of the window.
+
+**/
+STATIC
+VOID
+HostBridgeSetWriteCombining (
+  IN  PCI_ROOT_BRIDGE_INSTANCE  *RootBridge,
+  IN  EFI_PHYSICAL_ADDRESS      Base,
+  IN  UINT64                    Length
+  )
+{
+  EFI_STATUS                       Status;
+  EFI_GCD_MEMORY_SPACE_DESCRIPTOR  Descriptor;
+  EFI_PHYSICAL_ADDRESS             Next;
+  EFI_PHYSICAL_ADDRESS             End;
+  EFI_PHYSICAL_ADDRESS             DescriptorEnd;
+  EFI_PHYSICAL_ADDRESS             Undo;
+  UINT64                           CacheType;
+
+  if (((Base & EFI_PAGE_MASK) != 0) || ((Length & EFI_PAGE_MASK) != 0)) {
+    DEBUG ((
+      DEBUG_WARN,
+      "%s: 0x%lx-0x%lx is not page aligned, not mapping write-combining\n",
+      RootBridge->DevicePathStr,
+      Base,
+      Base + Length - 1
+      ));
+    return;
+  }
+
+  //
+  // First make sure the entire window supports WC and has a single
+  // cache type, so that a failure below can be rolled back.
+  //
+  Status    = EFI_SUCCESS;
+  CacheType = 0;
+  End       = Base + Length;
+
+  for (Next = Base; Next < End; Next = DescriptorEnd) {
+    Status = gDS->GetMemorySpaceDescriptor (Next, &Descriptor);
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+
+    DescriptorEnd = MIN (Descriptor.BaseAddress + Descriptor.Length, End);
+
+    if (Next == Base) {
+      CacheType = Descriptor.Attributes & EFI_MEMORY_CACHETYPE_MASK;
+    } else if ((Descriptor.Attributes & EFI_MEMORY_CACHETYPE_MASK) != CacheType) {
+      Status = EFI_UNSUPPORTED;
+      break;
+    }
+
+    if ((Descriptor.Capabilities & EFI_MEMORY_WC) == 0) {
+      Status = gDS->SetMemorySpaceCapabilities (
+                      Next,
+                      DescriptorEnd - Next,
+                      Descriptor.Capabilities | EFI_MEMORY_WC
+                      );
+      if (EFI_ERROR (Status)) {
+        break;
+      }
+    }
+  }
+
+  if (!EFI_ERROR (Status)) {
+    for (Next = Base; Next < End; Next = DescriptorEnd) {
+      Status = gDS->GetMemorySpaceDescriptor (Next, &Descriptor);
+      if (EFI_ERROR (Status)) {
+        break;
+      }
+
+      DescriptorEnd = MIN (Descriptor.BaseAddress + Descriptor.Length, End);
+
+      Status = gDS->SetMemorySpaceAttributes (
+                      Next,
+                      DescriptorEnd - Next,
+                      (Descriptor.Attributes & ~EFI_MEMORY_CACHETYPE_MASK) | EFI_MEMORY_WC
+                      );
+      if (EFI_ERROR (Status)) {
+        break;
+      }
+    }
+
+    //
+    // Don't leave the window half write-combining.
+    //
+    for (Undo = Base; EFI_ERROR (Status) && (Undo < Next); Undo = DescriptorEnd) {
+      if (EFI_ERROR (gDS->GetMemorySpaceDescriptor (Undo, &Descriptor))) {
+        break;
+      }
+
+      DescriptorEnd = MIN (Descriptor.BaseAddress + Descriptor.Length, Next);
+      gDS->SetMemorySpaceAttributes (
+             Undo,
+             DescriptorEnd - Undo,
+             (Descriptor.Attributes & ~EFI_MEMORY_CACHETYPE_MASK) | CacheType
+             );
+    }
+  }
+
+  if (EFI_ERROR (Status)) {
+    DEBUG ((
+      DEBUG_WARN,
+      "%s: couldn't map 0x%lx-0x%lx write-combining: %r\n",
+      RootBridge->DevicePathStr,
+      Base,
+      End - 1,
+      Status
+      ));
+    return;
+  }
+
+  DEBUG ((
+    DEBUG_INFO,
+    "%s: 0x%lx-0x%lx mapped write-combining\n",
+    RootBridge->DevicePathStr,
+    Base,
+    End - 1
+    ));
+}
+
+/**
+  Return the number of performance counter ticks since StartTick,
+  allowing for the counter counting down and for (at most one)
+  rollover in between.
+
+  @param  StartTick  Earlier reading.
+
+  @return Elapsed ticks.
+
+**/
+STATIC
+UINT64
+HostBridgeElapsedTicks (
+  IN  UINT64  StartTick
+  )
+{
+  UINT64  EndTick;
+  UINT64  PerfStart;
+  UINT64  PerfEnd;
+
+  EndTick = GetPerformanceCounter ();
+  GetPerformanceCounterProperties (&PerfStart, &PerfEnd);
+
+  if (PerfEnd >= PerfStart) {
+    if (EndTick >= StartTick) {
+      return EndTick - StartTick;
     }
+
+    return (PerfEnd - StartTick) + (EndTick - PerfStart) + 1;
   }
 
-  return MAX_UINT64;
+  if (StartTick >= EndTick) {
+    return StartTick - EndTick;
+  }
+
+  return (StartTick - PerfEnd) + (PerfStart - EndTick) + 1;
 }
 
 /**
@@ -146,6 +725,7 @@ HostBridgeNotifyPhase (
         RootBridge->ResourceSubmitted = FALSE;
       }
 
+      RootBridge->EnumerationStart = GetPerformanceCounter ();
       break;
     }
     case EfiPciHostBridgeBeginBusAllocation:
@@ -166,194 +746,294 @@ HostBridgeNotifyPhase (
       break;
     case EfiPciHostBridgeAllocateResources:
     {
-      UINTN                 Index;
-      UINTN                 Index1;
-      UINTN                 Index2;
-      EFI_PHYSICAL_ADDRESS  BaseAddress;
-      UINTN                 BitsOfAlignment;
-      UINT64                Alignment;
-      UINT64                MaxAlignment;
-      UINT64                Translation;
-      BOOLEAN               ResNodeHandled[TypeMax];
+      UINTN                     Index;
+      UINTN                     Index1;
+      UINTN                     Index2;
+      EFI_PHYSICAL_ADDRESS      BaseAddress;
+      UINTN                     BitsOfAlignment;
+      UINT64                    Alignment;
+      UINT64                    MaxAlignment;
+      UINT64                    Translation;
+      BOOLEAN                   ResNodeHandled[TypeMax];
+      BOOLEAN                   Deferred[TypeMax];
+      BOOLEAN                   Defer;
+      UINTN                     Pass;
+      BOOLEAN                   Persisted;
+      UINT32                    Fingerprint;
+      PCI_PERSISTED_ASSIGNMENT  Assignment;
       ReturnStatus = EFI_SUCCESS;
 
       if (!RootBridge->ResourceSubmitted) {
         return EFI_NOT_READY;
       }
 
+      Persisted   = FALSE;
+      Fingerprint = 0;
+      if (RootBridge->PersistConfig) {
+        Fingerprint = HostBridgeFingerprint (RootBridge);
+        Persisted   = HostBridgeLoadAssignment (RootBridge, Fingerprint, &Assignment);
+      }
+
       for (Index = TypeIo; Index < TypeBus; Index++) {
         ResNodeHandled[Index] = FALSE;
+        Deferred[Index]       = FALSE;
       }
 
-      for (Index1 = TypeIo; Index1 < TypeBus; Index1++) {
-        if (RootBridge->ResAllocNode[Index1].Status == ResNone) {
-          ResNodeHandled[Index1] = TRUE;
-        } else {
-          //
-          // Allocate the resource node with max alignment at first.
-          //
-          MaxAlignment = 0;
-          Index        = TypeMax;
-          for (Index2 = TypeIo; Index2 < TypeBus; Index2++) {
-            if (ResNodeHandled[Index2]) {
-              continue;
-            }
+      //
+      // With PreferAbove4G, 64-bit nodes that don't fit above 4G are
+      // deferred to a second pass, so they only fall back to the 32-bit
+      // windows once the 32-bit-only nodes have been placed.
+      //
+      for (Pass = 0; Pass < 2; Pass++) {
+        if (Pass == 1) {
+          Defer = FALSE;
+          for (Index = TypeIo; Index < TypeBus; Index++) {
+            ResNodeHandled[Index] = !Deferred[Index];
+            Defer                |= Deferred[Index];
+          }
 
-            if (MaxAlignment <= RootBridge->ResAllocNode[Index2].Alignment) {
-              MaxAlignment = RootBridge->ResAllocNode[Index2].Alignment;
-              Index        = Index2;
-            }
+          if (!Defer) {
+            break;
           }
+        }
 
-          ASSERT (Index < TypeMax);
-          ResNodeHandled[Index] = TRUE;
-          Alignment             = RootBridge->ResAllocNode[Index].Alignment;
-          BitsOfAlignment       = LowBitSet64 (Alignment + 1);
-          BaseAddress           = MAX_UINT64;
-
-          //
-          // RESTRICTION: To simplify the situation, we require the alignment of
-          // Translation must be larger than any BAR alignment in the same root
-          // bridge, so that resource allocation alignment can be applied to
-          // both device address and host address.
-          //
-          Translation = GetTranslationByResourceType (RootBridge, Index);
-          if ((Translation & Alignment) != 0) {
-            DEBUG ((
-              DEBUG_ERROR,
-              "%s: Translation 0x%lx is not aligned to 0x%lx!\n",
-              RootBridge->DevicePathStr,
-              Translation,
-              Alignment
-              ));
-            ASSERT ((Translation & Alignment) == 0);
+        Defer = (Pass == 0) && RootBridge->PreferAbove4G;
+
+        for (Index1 = TypeIo; Index1 < TypeBus; Index1++) {
+          if (RootBridge->ResAllocNode[Index1].Status == ResNone) {
+            ResNodeHandled[Index1] = TRUE;
+          } else {
             //
-            // This may be caused by too large alignment or too small
-            // Translation; pick the 1st possibility and return out of resource,
-            // which can also go thru the same process for out of resource
-            // outside the loop.
+            // Allocate the resource node with max alignment at first.
             //
-            ReturnStatus = EFI_OUT_OF_RESOURCES;
-            continue;
-          }
-
-          switch (Index) {
-            case TypeIo:
-              //
-              // See note in AddIoSpace for why the base/limits passed to
-              // AllocateResource are not translated via TO_HOST_ADDRESS.
-              //
-              BaseAddress = AllocateResource (
-                              FALSE,
-                              RootBridge->ResAllocNode[Index].Length,
-                              MIN (15, BitsOfAlignment),
-                              ALIGN_VALUE (RB (RootBridge->IoRange), Alignment + 1),
-                              RL (RootBridge->IoRange)
-                              );
+            MaxAlignment = 0;
+            Index        = TypeMax;
+            for (Index2 = TypeIo; Index2 < TypeBus; Index2++) {
+              if (ResNodeHandled[Index2]) {
+                continue;
+              }
 
-              if (BaseAddress != MAX_UINT64) {
-                //
-                // The root bridge reported resources always use CPU-side addresses.
-                //
-                BaseAddress = TO_HOST_ADDRESS (BaseAddress, RT (RootBridge->IoRange));
+              if (MaxAlignment <= RootBridge->ResAllocNode[Index2].Alignment) {
+                MaxAlignment = RootBridge->ResAllocNode[Index2].Alignment;
+                Index        = Index2;
               }
+            }
 
+            if (Index == TypeMax) {
+              //
+              // Only the deferred nodes are left in the second pass.
+              //
+              ASSERT (Pass == 1);
               break;
+            }
 
-            case TypeMem64:
-              BaseAddress = AllocateResource (
-                              TRUE,
-                              RootBridge->ResAllocNode[Index].Length,
-                              MIN (63, BitsOfAlignment),
-                              TO_HOST_ADDRESS (
-                                ALIGN_VALUE (RB (RootBridge->MemAbove4GRange), Alignment + 1),
-                                RT (RootBridge->MemAbove4GRange)
-                                ),
-                              TO_HOST_ADDRESS (
-                                RL (RootBridge->MemAbove4GRange),
-                                RT (RootBridge->MemAbove4GRange)
-                                )
-                              );
-              if (BaseAddress != MAX_UINT64) {
-                break;
-              }
+            ResNodeHandled[Index] = TRUE;
+            Alignment             = RootBridge->ResAllocNode[Index].Alignment;
+            BitsOfAlignment       = LowBitSet64 (Alignment + 1);
+            BaseAddress           = MAX_UINT64;
 
             //
-            // If memory above 4GB is not available, try memory below 4GB.
+            // RESTRICTION: To simplify the situation, we require the alignment of
+            // Translation must be larger than any BAR alignment in the same root
+            // bridge, so that resource allocation alignment can be applied to
+            // both device address and host address.
             //
-            case TypeMem32:
-              BaseAddress = AllocateResource (
-                              TRUE,
-                              RootBridge->ResAllocNode[Index].Length,
-                              MIN (31, BitsOfAlignment),
-                              TO_HOST_ADDRESS (
-                                ALIGN_VALUE (RB (RootBridge->MemRange), Alignment + 1),
-                                RT (RootBridge->MemRange)
-                                ),
-                              TO_HOST_ADDRESS (
-                                RL (RootBridge->MemRange),
-                                RT (RootBridge->MemRange)
-                                )
-                              );
-              break;
+            Translation = GetTranslationByResourceType (RootBridge, Index);
+            if ((Translation & Alignment) != 0) {
+              DEBUG ((
+                DEBUG_ERROR,
+                "%s: Translation 0x%lx is not aligned to 0x%lx!\n",
+                RootBridge->DevicePathStr,
+                Translation,
+                Alignment
+                ));
+              ASSERT ((Translation & Alignment) == 0);
+              //
+              // This may be caused by too large alignment or too small
+              // Translation; pick the 1st possibility and return out of resource,
+              // which can also go thru the same process for out of resource
+              // outside the loop.
+              //
+              ReturnStatus = EFI_OUT_OF_RESOURCES;
+              continue;
+            }
 
-            case TypePMem64:
-              BaseAddress = AllocateResource (
-                              TRUE,
-                              RootBridge->ResAllocNode[Index].Length,
-                              MIN (63, BitsOfAlignment),
-                              TO_HOST_ADDRESS (
-                                ALIGN_VALUE (RB (RootBridge->PMemAbove4GRange), Alignment + 1),
-                                RT (RootBridge->PMemAbove4GRange)
-                                ),
-                              TO_HOST_ADDRESS (
-                                RL (RootBridge->PMemAbove4GRange),
-                                RT (RootBridge->PMemAbove4GRange)
-                                )
+            if (Persisted &&
+                (Assignment.Length[Index] == RootBridge->ResAllocNode[Index].Length))
+            {
+              BaseAddress = HostBridgeAllocatePersisted (
+                              RootBridge,
+                              Index,
+                              BitsOfAlignment,
+                              Assignment.Base[Index]
                               );
-              if (BaseAddress != MAX_UINT64) {
-                break;
-              }
+            }
 
-            //
-            // If memory above 4GB is not available, try memory below 4GB.
-            //
-            case TypePMem32:
-              BaseAddress = AllocateResource (
-                              TRUE,
-                              RootBridge->ResAllocNode[Index].Length,
-                              MIN (31, BitsOfAlignment),
-                              TO_HOST_ADDRESS (
-                                ALIGN_VALUE (RB (RootBridge->PMemRange), Alignment + 1),
-                                RT (RootBridge->PMemRange)
-                                ),
-                              TO_HOST_ADDRESS (
-                                RL (RootBridge->PMemRange),
-                                RT (RootBridge->PMemRange)
-                                )
-                              );
-              break;
+            if (BaseAddress == MAX_UINT64) {
+              switch (Index) {
+                case TypeIo:
+                  //
+                  // See note in AddIoSpace for why the base/limits passed to
+                  // AllocateResource are not translated via TO_HOST_ADDRESS.
+                  //
+                  BaseAddress = AllocateResource (
+                                  FALSE,
+                                  RootBridge->ResAllocNode[Index].Length,
+                                  MIN (15, BitsOfAlignment),
+                                  ALIGN_VALUE (RB (RootBridge->IoRange), Alignment + 1),
+                                  RL (RootBridge->IoRange)
+                                  );
+
+                  if (BaseAddress != MAX_UINT64) {
+                    //
+                    // The root bridge reported resources always use CPU-side addresses.
+                    //
+                    BaseAddress = TO_HOST_ADDRESS (BaseAddress, RT (RootBridge->IoRange));
+                  }
+
+                  break;
+
+                case TypeMem64:
+                  if (Pass == 0) {
+                    BaseAddress = AllocateResource (
+                                    TRUE,
+                                    RootBridge->ResAllocNode[Index].Length,
+                                    MIN (63, BitsOfAlignment),
+                                    TO_HOST_ADDRESS (
+                                      ALIGN_VALUE (RB (RootBridge->MemAbove4GRange), Alignment + 1),
+                                      RT (RootBridge->MemAbove4GRange)
+                                      ),
+                                    TO_HOST_ADDRESS (
+                                      RL (RootBridge->MemAbove4GRange),
+                                      RT (RootBridge->MemAbove4GRange)
+                                      )
+                                    );
+                  }
 
-            default:
-              ASSERT (FALSE);
-              break;
-          }
+                  if ((BaseAddress != MAX_UINT64) || Defer) {
+                    break;
+                  }
 
-          DEBUG ((
-            DEBUG_INFO,
-            "  %s: Base/Length/Alignment = %lx/%lx/%lx - ",
-            mPciResourceTypeStr[Index],
-            BaseAddress,
-            RootBridge->ResAllocNode[Index].Length,
-            Alignment
-            ));
-          if (BaseAddress != MAX_UINT64) {
-            RootBridge->ResAllocNode[Index].Base   = BaseAddress;
-            RootBridge->ResAllocNode[Index].Status = ResAllocated;
-            DEBUG ((DEBUG_INFO, "%r\n", ReturnStatus));
-          } else {
-            ReturnStatus = EFI_OUT_OF_RESOURCES;
-            DEBUG ((DEBUG_ERROR, "%r\n", ReturnStatus));
+                //
+                // If memory above 4GB is not available, try memory below 4GB.
+                //
+                case TypeMem32:
+                  BaseAddress = AllocateResource (
+                                  TRUE,
+                                  RootBridge->ResAllocNode[Index].Length,
+                                  MIN (31, BitsOfAlignment),
+                                  TO_HOST_ADDRESS (
+                                    ALIGN_VALUE (RB (RootBridge->MemRange), Alignment + 1),
+                                    RT (RootBridge->MemRange)
+                                    ),
+                                  TO_HOST_ADDRESS (
+                                    RL (RootBridge->MemRange),
+                                    RT (RootBridge->MemRange)
+                                    )
+                                  );
+                  break;
+
+                case TypePMem64:
+                  if (Pass == 0) {
+                    BaseAddress = AllocateResource (
+                                    TRUE,
+                                    RootBridge->ResAllocNode[Index].Length,
+                                    MIN (63, BitsOfAlignment),
+                                    TO_HOST_ADDRESS (
+                                      ALIGN_VALUE (RB (RootBridge->PMemAbove4GRange), Alignment + 1),
+                                      RT (RootBridge->PMemAbove4GRange)
+                                      ),
+                                    TO_HOST_ADDRESS (
+                                      RL (RootBridge->PMemAbove4GRange),
+                                      RT (RootBridge->PMemAbove4GRange)
+                                      )
+                                    );
+
+                    //
+                    // A prefetchable node can always be placed in a
+                    // non-prefetchable window, which beats using up
+                    // the 32-bit window. GetProposedResources reports
+                    // the PMem64 translation, so the two windows must
+                    // share it.
+                    //
+                    if ((BaseAddress == MAX_UINT64) &&
+                        RootBridge->PreferAbove4G &&
+                        RANGE_VALID (RootBridge->MemAbove4GRange) &&
+                        (RT (RootBridge->MemAbove4GRange) == RT (RootBridge->PMemAbove4GRange)))
+                    {
+                      BaseAddress = AllocateResource (
+                                      TRUE,
+                                      RootBridge->ResAllocNode[Index].Length,
+                                      MIN (63, BitsOfAlignment),
+                                      TO_HOST_ADDRESS (
+                                        ALIGN_VALUE (RB (RootBridge->MemAbove4GRange), Alignment + 1),
+                                        RT (RootBridge->MemAbove4GRange)
+                                        ),
+                                      TO_HOST_ADDRESS (
+                                        RL (RootBridge->MemAbove4GRange),
+                                        RT (RootBridge->MemAbove4GRange)
+                                        )
+                                      );
+                    }
+                  }
+
+                  if ((BaseAddress != MAX_UINT64) || Defer) {
+                    break;
+                  }
+
+                //
+                // If memory above 4GB is not available, try memory below 4GB.
+                //
+                case TypePMem32:
+                  BaseAddress = AllocateResource (
+                                  TRUE,
+                                  RootBridge->ResAllocNode[Index].Length,
+                                  MIN (31, BitsOfAlignment),
+                                  TO_HOST_ADDRESS (
+                                    ALIGN_VALUE (RB (RootBridge->PMemRange), Alignment + 1),
+                                    RT (RootBridge->PMemRange)
+                                    ),
+                                  TO_HOST_ADDRESS (
+                                    RL (RootBridge->PMemRange),
+                                    RT (RootBridge->PMemRange)
+                                    )
+                                  );
+                  break;
+
+                default:
+                  ASSERT (FALSE);
+                  break;
+              }
+            }
+
+            if ((BaseAddress == MAX_UINT64) && Defer &&
+                ((Index == TypeMem64) || (Index == TypePMem64)))
+            {
+              DEBUG ((
+                DEBUG_INFO,
+                "  %s: no room above 4G, deferring\n",
+                mPciResourceTypeStr[Index]
+                ));
+              Deferred[Index] = TRUE;
+              continue;
+            }
+
+            DEBUG ((
+              DEBUG_INFO,
+              "  %s: Base/Length/Alignment = %lx/%lx/%lx - ",
+              mPciResourceTypeStr[Index],
+              BaseAddress,
+              RootBridge->ResAllocNode[Index].Length,
+              Alignment
+              ));
+            if (BaseAddress != MAX_UINT64) {
+              RootBridge->ResAllocNode[Index].Base   = BaseAddress;
+              RootBridge->ResAllocNode[Index].Status = ResAllocated;
+              DEBUG ((DEBUG_INFO, "%r\n", ReturnStatus));
+            } else {
+              ReturnStatus = EFI_OUT_OF_RESOURCES;
+              DEBUG ((DEBUG_ERROR, "%r\n", ReturnStatus));
+            }
           }
         }
       }
@@ -367,6 +1047,10 @@ HostBridgeNotifyPhase (
         }
       }
 
+      if (RootBridge->PersistConfig && !EFI_ERROR (ReturnStatus)) {
+        HostBridgeSaveAssignment (RootBridge, Fingerprint, Persisted ? &Assignment : NULL);
+      }
+
       return ReturnStatus;
     }
     case EfiPciHostBridgeSetResources:
@@ -441,15 +1125,41 @@ HostBridgeNotifyPhase (
     }
     case EfiPciHostBridgeEndResourceAllocation:
       //
-      // The resource allocation phase is completed.  No specific action is required
-      // here. This notification can be used to perform any chipset specific programming.
+      // The resource allocation phase is completed.
       //
+      if (RootBridge->PMemWriteCombine) {
+        if (RootBridge->ResAllocNode[TypePMem32].Status == ResAllocated) {
+          HostBridgeSetWriteCombining (
+            RootBridge,
+            RootBridge->ResAllocNode[TypePMem32].Base,
+            RootBridge->ResAllocNode[TypePMem32].Length
+            );
+        }
+
+        if (RootBridge->ResAllocNode[TypePMem64].Status == ResAllocated) {
+          HostBridgeSetWriteCombining (
+            RootBridge,
+            RootBridge->ResAllocNode[TypePMem64].Base,
+            RootBridge->ResAllocNode[TypePMem64].Length
+            );
+        }
+      }
+
       break;
     case EfiPciHostBridgeEndEnumeration:
       //
       // The Host Bridge Enumeration is completed. No specific action is required here.
       // This notification can be used to perform any chipset specific programming.
       //
+      DEBUG ((
+        DEBUG_INFO,
+        "%s: enumeration took %lu us\n",
+        RootBridge->DevicePathStr,
+        DivU64x32 (
+          GetTimeInNanoSecond (HostBridgeElapsedTicks (RootBridge->EnumerationStart)),
+          1000
+          )
+        ));
       break;
     default:
       return EFI_INVALID_PARAMETER;
@@ -44,6 +44,145 @@ STATIC_ASSERT (_ (FillUint64));
 STATIC_ASSERT (_ (Maximum));
 #undef _
 
+/**
+  Build a sorted table of the apertures valid for an access type,
+  merging adjacent and overlapping apertures that share a translation.
+
+  @param[out] Apertures      The table to build.
+  @param[in]  Ranges         The apertures, in order of precedence.
+  @param[in]  Count          Number of elements in Ranges.
+
+**/
+STATIC
+VOID
+RootBridgeBuildApertures (
+  OUT PCI_ROOT_BRIDGE_APERTURES  *Apertures,
+  IN  EFI_DT_RANGE               **Ranges,
+  IN  UINTN                      Count
+  )
+{
+  UINTN                     Index;
+  UINTN                     Slot;
+  PCI_ROOT_BRIDGE_APERTURE  *Entries;
+
+  ASSERT (Count <= PCI_ROOT_BRIDGE_APERTURES_MAX);
+
+  ZeroMem (Apertures, sizeof (*Apertures));
+  Entries = Apertures->Entries;
+
+  for (Index = 0; Index < Count; Index++) {
+    if (!RANGE_VALID (*Ranges[Index])) {
+      continue;
+    }
+
+    //
+    // Insertion sort, keeping apertures with the same Base in order
+    // of precedence.
+    //
+    for (Slot = Apertures->Count;
+         Slot > 0 && Entries[Slot - 1].Base > RB (*Ranges[Index]);
+         Slot--)
+    {
+      Entries[Slot] = Entries[Slot - 1];
+    }
+
+    Entries[Slot].Base  = RB (*Ranges[Index]);
+    Entries[Slot].Limit = RL (*Ranges[Index]);
+    FbpRangeToReg (Ranges[Index], RB (*Ranges[Index]), &Entries[Slot].Reg);
+    Apertures->Count++;
+  }
+
+  for (Index = 0; Index + 1 < Apertures->Count;) {
+    if ((Entries[Index + 1].Base > Entries[Index].Limit) &&
+        (Entries[Index + 1].Base - Entries[Index].Limit > 1))
+    {
+      Index++;
+      continue;
+    }
+
+    if ((Entries[Index + 1].Reg.BusBase != Entries[Index].Reg.BusBase) ||
+        (Entries[Index + 1].Reg.TranslatedBase != Entries[Index].Reg.TranslatedBase) ||
+        (Entries[Index + 1].Reg.BusDtIo != Entries[Index].Reg.BusDtIo))
+    {
+      Index++;
+      continue;
+    }
+
+    Entries[Index].Limit      = MAX (Entries[Index].Limit, Entries[Index + 1].Limit);
+    Entries[Index].Reg.Length = Entries[Index].Limit + 1;
+    Apertures->Count--;
+    for (Slot = Index + 1; Slot < Apertures->Count; Slot++) {
+      Entries[Slot] = Entries[Slot + 1];
+    }
+  }
+}
+
+/**
+  Find the aperture containing [Address, Address + Length).
+
+  Drivers tend to access the same BAR over and over again, so the
+  aperture last found is tried first.
+
+  @param[in]  Apertures      The table built by RootBridgeBuildApertures.
+  @param[in]  Address        The base address of the access.
+  @param[in]  Length         The length of the access.
+
+  @retval NULL               No aperture contains the range.
+  @retval Others             The aperture.
+
+**/
+STATIC
+CONST PCI_ROOT_BRIDGE_APERTURE *
+RootBridgeFindAperture (
+  IN  PCI_ROOT_BRIDGE_APERTURES  *Apertures,
+  IN  UINT64                     Address,
+  IN  UINT64                     Length
+  )
+{
+  CONST PCI_ROOT_BRIDGE_APERTURE  *Entries;
+  UINTN                           Low;
+  UINTN                           High;
+  UINTN                           Middle;
+  UINTN                           LastHit;
+
+  Entries = Apertures->Entries;
+  LastHit = Apertures->LastHit;
+  if ((LastHit < Apertures->Count) &&
+      (Address >= Entries[LastHit].Base) &&
+      (Address + Length <= Entries[LastHit].Limit + 1))
+  {
+    return &Entries[LastHit];
+  }
+
+  //
+  // Find the last aperture with Base <= Address.
+  //
+  Low  = 0;
+  High = Apertures->Count;
+  while (Low < High) {
+    Middle = Low + (High - Low) / 2;
+    if (Entries[Middle].Base <= Address) {
+      Low = Middle + 1;
+    } else {
+      High = Middle;
+    }
+  }
+
+  //
+  // Apertures that couldn't be merged may still overlap, so also
+  // consider the ones below.
+  //
+  while (Low > 0) {
+    Low--;
+    if (Address + Length <= Entries[Low].Limit + 1) {
+      Apertures->LastHit = Low;
+      return &Entries[Low];
+    }
+  }
+
+  return NULL;
+}
+
 /**
   Check parameters for IO,MMIO,PCI read/write services of PCI Root Bridge IO.
 
@@ -98,6 +237,7 @@ RootBridgeIoCheckParameter (
 {
   PCI_ROOT_BRIDGE_INSTANCE                     *RootBridge;
   EFI_PCI_ROOT_BRIDGE_IO_PROTOCOL_PCI_ADDRESS  *PciRbAddr;
+  CONST PCI_ROOT_BRIDGE_APERTURE               *Aperture;
   UINT64                                       Base;
   UINT64                                       Limit;
   UINT32                                       Size;
@@ -160,70 +300,22 @@ RootBridgeIoCheckParameter (
   // Count can also be the maximum integer value supported by the CPU, this
   // range check must be adjusted to avoid all oveflow conditions.
   //
-  if (OperationType == IoOperation) {
-    EFI_DT_RANGE  *Range;
-
-    //
-    // By comparing the Address against Limit we know which range to be used
-    // for checking
-    //
-    if ((Address >= RB (RootBridge->VgaIo1Range)) &&
-        (Address + Length <= RL (RootBridge->VgaIo1Range) + 1))
-    {
-      Base  = RB (RootBridge->VgaIo1Range);
-      Limit = RL (RootBridge->VgaIo1Range);
-      Range = &RootBridge->VgaIo1Range;
-    } else if ((Address >= RB (RootBridge->VgaIo2Range)) &&
-               (Address + Length <= RL (RootBridge->VgaIo2Range) + 1))
-    {
-      Base  = RB (RootBridge->VgaIo2Range);
-      Limit = RL (RootBridge->VgaIo2Range);
-      Range = &RootBridge->VgaIo2Range;
-    } else {
-      Base  = RB (RootBridge->IoRange);
-      Limit = RL (RootBridge->IoRange);
-      Range = &RootBridge->IoRange;
-    }
-
-    FbpRangeToReg (Range, RB (*Range), Reg);
-  } else if ((OperationType == MemOperation) || (OperationType == MemOperationNoBuffer)) {
-    EFI_DT_RANGE  *Range;
-
-    //
-    // By comparing the Address against Limit we know which range to be used
-    // for checking
-    //
-    if ((Address >= RB (RootBridge->MemRange)) &&
-        (Address + Length <= RL (RootBridge->MemRange) + 1))
-    {
-      Base  = RB (RootBridge->MemRange);
-      Limit = RL (RootBridge->MemRange);
-      Range = &RootBridge->MemRange;
-    } else if ((Address >= RB (RootBridge->VgaMemRange)) &&
-               (Address + Length <= RL (RootBridge->VgaMemRange) + 1))
-    {
-      Base  = RB (RootBridge->VgaMemRange);
-      Limit = RL (RootBridge->VgaMemRange);
-      Range = &RootBridge->VgaMemRange;
-    } else if ((Address >= RB (RootBridge->PMemRange)) &&
-               (Address + Length <= RL (RootBridge->PMemRange) + 1))
-    {
-      Base  = RB (RootBridge->PMemRange);
-      Limit = RL (RootBridge->PMemRange);
-      Range = &RootBridge->PMemRange;
-    } else if ((Address >= RB (RootBridge->MemAbove4GRange)) &&
-               (Address + Length <= RL (RootBridge->MemAbove4GRange) + 1))
-    {
-      Base  = RB (RootBridge->MemAbove4GRange);
-      Limit = RL (RootBridge->MemAbove4GRange);
-      Range = &RootBridge->MemAbove4GRange;
-    } else {
-      Base  = RB (RootBridge->PMemAbove4GRange);
-      Limit = RL (RootBridge->PMemAbove4GRange);
-      Range = &RootBridge->PMemAbove4GRange;
+  if ((OperationType == IoOperation) ||
+      (OperationType == MemOperation) ||
+      (OperationType == MemOperationNoBuffer))
+  {
+    Aperture = RootBridgeFindAperture (
+                 (OperationType == IoOperation) ?
+                 &RootBridge->IoApertures : &RootBridge->MemApertures,
+                 Address,
+                 Length
+                 );
+    if (Aperture == NULL) {
+      return EFI_INVALID_PARAMETER;
     }
 
-    FbpRangeToReg (Range, RB (*Range), Reg);
+    *Reg = Aperture->Reg;
+    return EFI_SUCCESS;
   } else {
     PciRbAddr = (EFI_PCI_ROOT_BRIDGE_IO_PROTOCOL_PCI_ADDRESS *)&Address;
     if ((PciRbAddr->Bus < RB (RootBridge->BusRange)) ||
@@ -486,6 +578,154 @@ FreeIoSpaceMap:
   return Status;
 }
 
+/**
+  Copy a single element between two MMIO addresses.
+
+  @param Width    Signifies the width of the memory operation.
+  @param Dest     The destination CPU address.
+  @param Src      The source CPU address.
+
+**/
+STATIC
+VOID
+RootBridgeIoMmioCopy (
+  IN  EFI_PCI_ROOT_BRIDGE_IO_PROTOCOL_WIDTH  Width,
+  IN  UINTN                                  Dest,
+  IN  UINTN                                  Src
+  )
+{
+  switch (Width & 0x03) {
+    case EfiPciWidthUint8:
+      MmioWrite8 (Dest, MmioRead8 (Src));
+      break;
+    case EfiPciWidthUint16:
+      MmioWrite16 (Dest, MmioRead16 (Src));
+      break;
+    case EfiPciWidthUint32:
+      MmioWrite32 (Dest, MmioRead32 (Src));
+      break;
+    default:
+      MmioWrite64 (Dest, MmioRead64 (Src));
+      break;
+  }
+}
+
+/**
+  Return whether a memory range lies entirely within a prefetchable
+  aperture. Prefetchable memory has no read side effects and tolerates
+  merged writes, so it may be accessed wider than requested.
+
+  @param RootBridge  The root bridge instance.
+  @param Address     The PCI memory address.
+  @param Length      The length of the range.
+
+  @retval TRUE       The range is prefetchable.
+  @retval FALSE      The range is not (entirely) prefetchable.
+
+**/
+STATIC
+BOOLEAN
+RootBridgeIoIsPrefetchable (
+  IN  PCI_ROOT_BRIDGE_INSTANCE  *RootBridge,
+  IN  UINT64                    Address,
+  IN  UINT64                    Length
+  )
+{
+  if (RANGE_VALID (RootBridge->PMemRange) &&
+      (Address >= RB (RootBridge->PMemRange)) &&
+      (Address + Length <= RL (RootBridge->PMemRange) + 1))
+  {
+    return TRUE;
+  }
+
+  if (RANGE_VALID (RootBridge->PMemAbove4GRange) &&
+      (Address >= RB (RootBridge->PMemAbove4GRange)) &&
+      (Address + Length <= RL (RootBridge->PMemAbove4GRange) + 1))
+  {
+    return TRUE;
+  }
+
+  return FALSE;
+}
+
+/**
+  Copy between two prefetchable MMIO ranges, using 64-bit accesses
+  for the naturally aligned middle part and the caller's width for
+  the unaligned head and tail. Copies backwards when the destination
+  overlaps the end of the source.
+
+  Dest and Src must be aligned to Width, and must be equally aligned
+  relative to 64 bits.
+
+  @param Width    Signifies the width of the head and tail accesses.
+  @param Dest     The destination CPU address.
+  @param Src      The source CPU address.
+  @param Length   The number of bytes to copy, a multiple of Width.
+
+**/
+STATIC
+VOID
+RootBridgeIoMmioCopyWide (
+  IN  EFI_PCI_ROOT_BRIDGE_IO_PROTOCOL_WIDTH  Width,
+  IN  UINTN                                  Dest,
+  IN  UINTN                                  Src,
+  IN  UINTN                                  Length
+  )
+{
+  UINTN  Size;
+
+  Size = (UINTN)1 << (Width & 0x03);
+
+  if ((Dest <= Src) || (Dest >= Src + Length)) {
+    while ((Length != 0) && ((Dest & (sizeof (UINT64) - 1)) != 0)) {
+      RootBridgeIoMmioCopy (Width, Dest, Src);
+      Dest   += Size;
+      Src    += Size;
+      Length -= Size;
+    }
+
+    while (Length >= sizeof (UINT64)) {
+      MmioWrite64 (Dest, MmioRead64 (Src));
+      Dest   += sizeof (UINT64);
+      Src    += sizeof (UINT64);
+      Length -= sizeof (UINT64);
+    }
+
+    while (Length != 0) {
+      RootBridgeIoMmioCopy (Width, Dest, Src);
+      Dest   += Size;
+      Src    += Size;
+      Length -= Size;
+    }
+
+    return;
+  }
+
+  Dest += Length;
+  Src  += Length;
+
+  while ((Length != 0) && ((Dest & (sizeof (UINT64) - 1)) != 0)) {
+    Dest   -= Size;
+    Src    -= Size;
+    Length -= Size;
+    RootBridgeIoMmioCopy (Width, Dest, Src);
+  }
+
+  while (Length >= sizeof (UINT64)) {
+    Dest   -= sizeof (UINT64);
+    Src    -= sizeof (UINT64);
+    Length -= sizeof (UINT64);
+    MmioWrite64 (Dest, MmioRead64 (Src));
+  }
+
+  while (Length != 0) {
+    Dest   -= Size;
+    Src    -= Size;
+    Length -= Size;
+    RootBridgeIoMmioCopy (Width, Dest, Src);
+  }
+}
+
 /**
   Polls an address in memory mapped I/O space until an exit condition is met,
   or a timeout occurs.
@@ -898,9 +1138,10 @@ RootBridgeIoIoWrite (
   bridge memory space to another region of PCI root bridge memory space. This
   is especially useful for video scroll operation on a memory mapped video
   buffer.
-  The memory operations are carried out exactly as requested. The caller is
-  responsible for satisfying any alignment and memory width restrictions that a
-  PCI root bridge on a platform might require.
+  The memory operations are carried out exactly as requested, except within
+  prefetchable apertures, where accesses may be widened to 64 bits. The caller
+  is responsible for satisfying any alignment and memory width restrictions
+  that a PCI root bridge on a platform might require.
 
   @param[in] This        A pointer to the EFI_PCI_ROOT_BRIDGE_IO_PROTOCOL
                          instance.
@@ -936,6 +1177,9 @@ RootBridgeIoCopyMem (
   PCI_ROOT_BRIDGE_INSTANCE  *RootBridge;
   EFI_DT_REG                SrcReg;
   EFI_DT_REG                DestReg;
+  EFI_PHYSICAL_ADDRESS      SrcCpu;
+  EFI_PHYSICAL_ADDRESS      DestCpu;
+  UINT64                    Length;
 
   Status = RootBridgeIoCheckParameter (
              This,
@@ -964,6 +1208,28 @@ RootBridgeIoCopyMem (
   }
 
   RootBridge = ROOT_BRIDGE_FROM_THIS (This);
+
+  //
+  // Both ranges have been validated once. When both lie within
+  // prefetchable apertures, copy directly using 64-bit accesses
+  // instead of going through a temporary buffer one element at
+  // a time in the caller's width.
+  //
+  Length = LShiftU64 (Count, Width & 0x03);
+  if ((Count != 0) && (Width <= EfiPciWidthUint64) &&
+      RootBridgeIoIsPrefetchable (RootBridge, SrcAddress, Length) &&
+      RootBridgeIoIsPrefetchable (RootBridge, DestAddress, Length) &&
+      !EFI_ERROR (FbpRegToPhysicalAddress (&SrcReg, &SrcCpu)) &&
+      !EFI_ERROR (FbpRegToPhysicalAddress (&DestReg, &DestCpu)))
+  {
+    SrcCpu  += SrcAddress;
+    DestCpu += DestAddress;
+    if (((SrcCpu ^ DestCpu) & (sizeof (UINT64) - 1)) == 0) {
+      RootBridgeIoMmioCopyWide (Width, (UINTN)DestCpu, (UINTN)SrcCpu, (UINTN)Length);
+      return EFI_SUCCESS;
+    }
+  }
+
   return RootBridge->DtIo->CopyReg (
                              RootBridge->DtIo,
                              Width,
@@ -975,6 +1241,142 @@ RootBridgeIoCopyMem (
                              );
 }
 
+/**
+  PCI configuration space access via direct MMIO to the ECAM window.
+
+  Parameters must have been validated with RootBridgeIoCheckParameter.
+
+  @param Read     TRUE indicating it's a read operation.
+  @param Width    Signifies the width of the memory operation.
+  @param Address  The CPU address of the first configuration register.
+  @param Count    The number of PCI configuration operations
+                  to perform.
+  @param Buffer   The destination or source buffer.
+
+**/
+STATIC
+VOID
+RootBridgeIoEcamAccess (
+  IN     BOOLEAN                                Read,
+  IN     EFI_PCI_ROOT_BRIDGE_IO_PROTOCOL_WIDTH  Width,
+  IN     UINTN                                  Address,
+  IN     UINTN                                  Count,
+  IN OUT VOID                                   *Buffer
+  )
+{
+  UINT8  InStride;
+  UINT8  OutStride;
+  UINT8  *Uint8Buffer;
+
+  InStride  = (UINT8)(1 << (Width & 0x03));
+  OutStride = InStride;
+  if ((Width >= EfiPciWidthFifoUint8) && (Width <= EfiPciWidthFifoUint64)) {
+    InStride = 0;
+  }
+
+  if ((Width >= EfiPciWidthFillUint8) && (Width <= EfiPciWidthFillUint64)) {
+    OutStride = 0;
+  }
+
+  Width = (EFI_PCI_ROOT_BRIDGE_IO_PROTOCOL_WIDTH)(Width & 0x03);
+
+  for (Uint8Buffer = Buffer;
+       Count > 0;
+       Address += InStride, Uint8Buffer += OutStride, Count--)
+  {
+    if (Read) {
+      switch (Width) {
+        case EfiPciWidthUint8:
+          *Uint8Buffer = MmioRead8 (Address);
+          break;
+        case EfiPciWidthUint16:
+          *((UINT16 *)Uint8Buffer) = MmioRead16 (Address);
+          break;
+        case EfiPciWidthUint32:
+          *((UINT32 *)Uint8Buffer) = MmioRead32 (Address);
+          break;
+        default:
+          *((UINT64 *)Uint8Buffer) = MmioRead64 (Address);
+          break;
+      }
+    } else {
+      switch (Width) {
+        case EfiPciWidthUint8:
+          MmioWrite8 (Address, *Uint8Buffer);
+          break;
+        case EfiPciWidthUint16:
+          MmioWrite16 (Address, *((UINT16 *)Uint8Buffer));
+          break;
+        case EfiPciWidthUint32:
+          MmioWrite32 (Address, *((UINT32 *)Uint8Buffer));
+          break;
+        default:
+          MmioWrite64 (Address, *((UINT64 *)Uint8Buffer));
+          break;
+      }
+    }
+  }
+}
+
+/**
+  PCI configuration space access, bypassing the read cache.
+
+  @param RootBridge  PCI_ROOT_BRIDGE_INSTANCE *.
+  @param Read        TRUE indicating it's a read operation.
+  @param Width       Signifies the width of the memory operation.
+  @param Reg         The ECAM window.
+  @param EcamOffset  The offset of the register within the ECAM window.
+  @param Count       The number of PCI configuration operations
+                     to perform.
+  @param Buffer      The destination or source buffer.
+
+  @retval EFI_SUCCESS            The data was read/written from/to the PCI root bridge.
+  @retval Other                  DtIo error.
+**/
+STATIC
+EFI_STATUS
+RootBridgeIoConfigAccess (
+  IN     PCI_ROOT_BRIDGE_INSTANCE               *RootBridge,
+  IN     BOOLEAN                                Read,
+  IN     EFI_PCI_ROOT_BRIDGE_IO_PROTOCOL_WIDTH  Width,
+  IN     EFI_DT_REG                             *Reg,
+  IN     UINTN                                  EcamOffset,
+  IN     UINTN                                  Count,
+  IN OUT VOID                                   *Buffer
+  )
+{
+  if (RootBridge->EcamDirect) {
+    RootBridgeIoEcamAccess (
+      Read,
+      Width,
+      (UINTN)RootBridge->EcamBase + EcamOffset,
+      Count,
+      Buffer
+      );
+    return EFI_SUCCESS;
+  }
+
+  if (Read) {
+    return RootBridge->DtIo->ReadReg (
+                               RootBridge->DtIo,
+                               Width,
+                               Reg,
+                               EcamOffset,
+                               Count,
+                               Buffer
+                               );
+  } else {
+    return RootBridge->DtIo->WriteReg (
+                               RootBridge->DtIo,
+                               Width,
+                               Reg,
+                               EcamOffset,
+                               Count,
+                               Buffer
+                               );
+  }
+}
+
 /**
   PCI configuration space access.
 
@@ -1006,6 +1408,8 @@ RootBridgeIoPciAccess (
   PCI_ROOT_BRIDGE_INSTANCE                     *RootBridge;
   EFI_PCI_ROOT_BRIDGE_IO_PROTOCOL_PCI_ADDRESS  PciAddress;
   EFI_DT_REG                                   Reg;
+  UINTN                                        EcamOffset;
+  EFI_TPL                                      Tpl;
 
   Status = RootBridgeIoCheckParameter (
              This,
@@ -1027,35 +1431,36 @@ RootBridgeIoPciAccess (
     PciAddress.ExtendedRegister = PciAddress.Register;
   }
 
-  if (Read) {
-    return RootBridge->DtIo->ReadReg (
-                               RootBridge->DtIo,
-                               Width,
-                               &Reg,
-                               PCI_ECAM_ADDRESS (
-                                 PciAddress.Bus,
-                                 PciAddress.Device,
-                                 PciAddress.Function,
-                                 PciAddress.ExtendedRegister
-                                 ),
-                               Count,
-                               Buffer
-                               );
+  EcamOffset = PCI_ECAM_ADDRESS (
+                 PciAddress.Bus,
+                 PciAddress.Device,
+                 PciAddress.Function,
+                 PciAddress.ExtendedRegister
+                 );
+
+  if (RootBridge->ConfigCache == NULL) {
+    return RootBridgeIoConfigAccess (RootBridge, Read, Width, &Reg, EcamOffset, Count, Buffer);
+  }
+
+  //
+  // Keep the cache consistent with the hardware: a read that misses
+  // is filled in before anyone else gets to write to the function.
+  // The cache may also be gone by now, as it is dropped at EndOfDxe,
+  // but ConfigCacheLookup/Update handle that.
+  //
+  Tpl = gBS->RaiseTPL (TPL_NOTIFY);
+  if (Read && ConfigCacheLookup (RootBridge, Width, EcamOffset, Count, Buffer)) {
+    Status = EFI_SUCCESS;
   } else {
-    return RootBridge->DtIo->WriteReg (
-                               RootBridge->DtIo,
-                               Width,
-                               &Reg,
-                               PCI_ECAM_ADDRESS (
-                                 PciAddress.Bus,
-                                 PciAddress.Device,
-                                 PciAddress.Function,
-                                 PciAddress.ExtendedRegister
-                                 ),
-                               Count,
-                               Buffer
-                               );
+    Status = RootBridgeIoConfigAccess (RootBridge, Read, Width, &Reg, EcamOffset, Count, Buffer);
+    if (!Read || !EFI_ERROR (Status)) {
+      ConfigCacheUpdate (RootBridge, Read, Width, EcamOffset, Count, Buffer);
+    }
   }
+
+  gBS->RestoreTPL (Tpl);
+
+  return Status;
 }
 
 /**
@@ -1698,6 +2103,8 @@ RootBridgeValidate (
     (RootBridge->AllocationAttributes & EFI_PCI_HOST_BRIDGE_MEM64_DECODE) != 0 ? L"Mem64Decode" : L""
     ));
   DEBUG ((DEBUG_INFO, "    KeepConfig: %s\n", RootBridge->KeepExistingConfig ? L"Yes" : L"No"));
+  DEBUG ((DEBUG_INFO, "        PMemWC: %s\n", RootBridge->PMemWriteCombine ? L"Yes" : L"No"));
+  DEBUG ((DEBUG_INFO, " PreferAbove4G: %s\n", RootBridge->PreferAbove4G ? L"Yes" : L"No"));
   PrintRangeInfo (14, "Bus", &RootBridge->BusRange);
   PrintRangeInfo (14, "Io", &RootBridge->IoRange);
   PrintRangeInfo (14, "VgaIo1", &RootBridge->VgaIo1Range);
@@ -1844,6 +2251,7 @@ RootBridgeDtInit (
   EFI_DT_RANGE        Range;
   UINTN               Index;
   EFI_DT_PROPERTY     Property;
+  EFI_DT_RANGE        *Ranges[PCI_ROOT_BRIDGE_APERTURES_MAX];
 
   DtIo = RootBridge->DtIo;
 
@@ -1936,11 +2344,45 @@ RootBridgeDtInit (
       RootBridge->BusRange.TranslatedParentBase = BusMin;
   RootBridge->BusRange.Length                   = BusMax - BusMin + 1;
 
+  //
+  // Validate the ECAM window once, so that RootBridgeIoPciAccess can
+  // bypass DtIo->ReadReg/WriteReg. This requires the window to be
+  // CPU-addressable (i.e. not behind non-identity bus callbacks) and
+  // to cover all of bus-range.
+  //
+  if (!EFI_ERROR (FbpRegToPhysicalAddress (&RootBridge->ConfigReg, &RootBridge->EcamBase)) &&
+      (RootBridge->ConfigReg.Length > PCI_ECAM_ADDRESS (BusMax, PCI_MAX_DEVICE, PCI_MAX_FUNC, 0xFFF)))
+  {
+    RootBridge->EcamDirect = TRUE;
+  } else {
+    DEBUG ((
+      DEBUG_INFO,
+      "%s: ECAM window not directly accessible, using DtIo\n",
+      RootBridge->DevicePathStr
+      ));
+  }
+
   Status = DtIo->GetProp (DtIo, "fdtbuspkg,pci-keep-config", &Property);
   if (!EFI_ERROR (Status)) {
     RootBridge->KeepExistingConfig = TRUE;
   }
 
+  Status = DtIo->GetProp (DtIo, "fdtbuspkg,pci-persist-config", &Property);
+  if (!EFI_ERROR (Status)) {
+    RootBridge->PersistConfig = TRUE;
+  }
+
+  Status = DtIo->GetProp (DtIo, "fdtbuspkg,pmem-wc", &Property);
+  if (!EFI_ERROR (Status)) {
+    RootBridge->PMemWriteCombine = TRUE;
+  }
+
+  RootBridge->PreferAbove4G = PcdGetBool (PcdPciPreferAbove4G);
+  Status                    = DtIo->GetProp (DtIo, "fdtbuspkg,pci-prefer-above-4g", &Property);
+  if (!EFI_ERROR (Status)) {
+    RootBridge->PreferAbove4G = TRUE;
+  }
+
   for (Index = 0,
        Status = DtIo->GetRange (
                         DtIo,
@@ -2039,6 +2481,21 @@ RootBridgeDtInit (
     RootBridge->VgaMemRange.Length                = VGA_MEM_SIZE;
   }
 
+  //
+  // Apertures valid for Io and Mem accesses, in order of precedence.
+  //
+  Ranges[0] = &RootBridge->VgaIo1Range;
+  Ranges[1] = &RootBridge->VgaIo2Range;
+  Ranges[2] = &RootBridge->IoRange;
+  RootBridgeBuildApertures (&RootBridge->IoApertures, Ranges, 3);
+
+  Ranges[0] = &RootBridge->MemRange;
+  Ranges[1] = &RootBridge->VgaMemRange;
+  Ranges[2] = &RootBridge->PMemRange;
+  Ranges[3] = &RootBridge->MemAbove4GRange;
+  Ranges[4] = &RootBridge->PMemAbove4GRange;
+  RootBridgeBuildApertures (&RootBridge->MemApertures, Ranges, 5);
+
   RootBridge->Supports     =
     RootBridge->Attributes =
       EFI_PCI_ATTRIBUTE_VGA_PALETTE_IO |
@@ -2263,6 +2720,11 @@ RootBridgeCreate (
   RootBridge->RootBridgeIo.Configuration  = RootBridgeIoConfiguration;
   RootBridge->RootBridgeIo.ParentHandle   = Controller;
 
+  //
+  // Optional, so failure is not fatal.
+  //
+  ConfigCacheInit (RootBridge);
+
   HostBridgeInit (RootBridge);
 
 out:
@@ -2303,6 +2765,7 @@ RootBridgeFree (
     HostBridgeFreeExistingConfig (RootBridge);
   }
 
+  ConfigCacheFree (RootBridge);
   FreePool (RootBridge->ConfigBuffer);
   FreePool (RootBridge->DevicePathStr);
   FreePool (RootBridge);
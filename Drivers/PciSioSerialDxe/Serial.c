@@ -533,11 +533,14 @@ CreateSerialDevice (
   EFI_ACPI_FIXED_LOCATION_IO_PORT_DESCRIPTOR  *FixedIo;
   EFI_ACPI_ADDRESS_SPACE_DESCRIPTOR           *AddressSpace;
   EFI_DEVICE_PATH_PROTOCOL                    *TempDevicePath;
+  UINT32                                      FifoSize;
+  UINT32                                      RegShift;
 
   BarIndex       = 0;
   Offset         = 0;
   FlowControl    = NULL;
   FlowControlMap = 0;
+  FifoSize       = PcdGet32 (PcdSerialFifoSize);
 
   //
   // Initialize the serial device instance
@@ -563,10 +566,16 @@ CreateSerialDevice (
   if (IoProtocolGuid == &gEfiDtIoProtocolGuid) {
     SerialDevice->DtIo = ParentIo.DtIo;
     //
-    // TBD, process reg-shift (for stride), reg-io-width (access size),
-    // fifo-size.
+    // TBD, process reg-io-width (access size).
     //
     ParentIo.DtIo->GetU32 (ParentIo.DtIo, "clock-frequency", 0, &SerialDevice->ClockRate);
+    if (!EFI_ERROR (ParentIo.DtIo->GetU32 (ParentIo.DtIo, "reg-shift", 0, &RegShift)) &&
+        (RegShift < 8))
+    {
+      SerialDevice->RegisterStride = (UINT8)(1 << RegShift);
+    }
+
+    ParentIo.DtIo->GetU32 (ParentIo.DtIo, "fdtbuspkg,serial-fifo-size", 0, &FifoSize);
   } else if (IoProtocolGuid == &gEfiPciIoProtocolGuid) {
     //
     // For PCI serial device, use the information from PCD.
@@ -591,6 +600,19 @@ CreateSerialDevice (
     }
   }
 
+  //
+  // Software FIFOs are power-of-two sized, so indexing is a mask.
+  //
+  FifoSize                    = MAX (GetPowerOfTwo32 (FifoSize), SERIAL_MIN_FIFO_SIZE);
+  SerialDevice->Receive.Mask  = FifoSize - 1;
+  SerialDevice->Receive.Data  = AllocatePool (FifoSize);
+  SerialDevice->Transmit.Mask = FifoSize - 1;
+  SerialDevice->Transmit.Data = AllocatePool (FifoSize);
+  if ((SerialDevice->Receive.Data == NULL) || (SerialDevice->Transmit.Data == NULL)) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto CreateError;
+  }
+
   //
   // Pass NULL ActualBaudRate to VerifyUartParameters to disallow baudrate degrade.
   // DriverBindingStart() shouldn't create a handle with different UART device path.
@@ -615,6 +637,17 @@ CreateSerialDevice (
     if (EFI_ERROR (Status)) {
       goto CreateError;
     }
+
+    //
+    // Validate the window once, instead of on every ReadReg/WriteReg.
+    // Registers behind bus callbacks (BusDtIo != NULL) have no CPU
+    // address and keep going through DtIo.
+    //
+    if (!EFI_ERROR (FbpRegToPhysicalAddress (&SerialDevice->DtReg, &SerialDevice->BaseAddress)) &&
+        (SerialDevice->DtReg.Length > SERIAL_REGISTER_SCR * SerialDevice->RegisterStride))
+    {
+      SerialDevice->DtDirectAccess = TRUE;
+    }
   } else {
     if (IoProtocolGuid == &gEfiSioProtocolGuid) {
       Status = ParentIo.Sio->GetResources (ParentIo.Sio, &Resources);
@@ -767,6 +800,16 @@ CreateSerialDevice (
     goto CreateError;
   }
 
+  //
+  // Receive via interrupts where the DT describes them, else keep polling.
+  //
+  SerialInterruptInit (SerialDevice);
+
+  //
+  // Queue writes and transmit in the background, if so configured.
+  //
+  SerialTransmitInit (SerialDevice);
+
   AddName (SerialDevice, Instance);
   //
   // Install protocol interfaces for the serial device.
@@ -808,6 +851,17 @@ CreateSerialDevice (
 
 CreateError:
   if (EFI_ERROR (Status)) {
+    SerialTransmitDeinit (SerialDevice);
+    SerialInterruptDeinit (SerialDevice);
+
+    if (SerialDevice->Receive.Data != NULL) {
+      FreePool (SerialDevice->Receive.Data);
+    }
+
+    if (SerialDevice->Transmit.Data != NULL) {
+      FreePool (SerialDevice->Transmit.Data);
+    }
+
     if (SerialDevice->DevicePath != NULL) {
       FreePool (SerialDevice->DevicePath);
     }
@@ -1412,6 +1466,10 @@ SerialControllerDriverStop (
                EFI_OPEN_PROTOCOL_BY_CHILD_CONTROLLER
                );
       } else {
+        SerialTransmitDeinit (SerialDevice);
+        SerialInterruptDeinit (SerialDevice);
+        FreePool (SerialDevice->Receive.Data);
+        FreePool (SerialDevice->Transmit.Data);
         FreePool (SerialDevice->DevicePath);
         FreeUnicodeStringTable (SerialDevice->ControllerNameTable);
         FreePool (SerialDevice);
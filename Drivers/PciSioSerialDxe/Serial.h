@@ -16,6 +16,7 @@
 
 #include <Protocol/SuperIo.h>
 #include <Protocol/DtIo.h>
+#include <Protocol/DtInterrupt.h>
 #include <Protocol/PciIo.h>
 #include <Protocol/SerialIo.h>
 #include <Protocol/DevicePath.h>
@@ -31,6 +32,8 @@
 #include <Library/PcdLib.h>
 #include <Library/IoLib.h>
 #include <Library/PrintLib.h>
+#include <Library/FbpInterruptUtilsLib.h>
+#include <Library/FbpUtilsLib.h>
 
 //
 // Driver Binding Externs
@@ -75,11 +78,12 @@ typedef struct {
 } PCI_SERIAL_PARAMETER;
 #pragma pack()
 
-#define SERIAL_MAX_FIFO_SIZE  17      ///< Actual FIFO size is 16. FIFO based on circular wastes one unit.
+#define SERIAL_MIN_FIFO_SIZE  16      ///< Smallest software FIFO, must be a power of two.
 typedef struct {
-  UINT16    Head;                       ///< Head pointer of the FIFO. Empty when (Head == Tail).
-  UINT16    Tail;                       ///< Tail pointer of the FIFO. Full when ((Tail + 1) % SERIAL_MAX_FIFO_SIZE == Head).
-  UINT8     Data[SERIAL_MAX_FIFO_SIZE]; ///< Store the FIFO data.
+  UINT32    Head;                       ///< Free-running head index of the FIFO. Empty when (Head == Tail).
+  UINT32    Tail;                       ///< Free-running tail index of the FIFO. Full when ((Tail - Head) == Mask + 1).
+  UINT32    Mask;                       ///< FIFO size - 1, FIFO size is a power of two.
+  UINT8     *Data;                      ///< Store the FIFO data.
 } SERIAL_DEV_FIFO;
 
 typedef union {
@@ -123,6 +127,29 @@ typedef struct {
   PCI_DEVICE_INFO             *PciDeviceInfo;
   EFI_DT_IO_PROTOCOL          *DtIo;
   EFI_DT_REG                  DtReg;
+  //
+  // Set when DtReg is CPU-addressable and covers all UART registers,
+  // so accesses bypass DtIo->ReadReg/WriteReg and use BaseAddress.
+  //
+  BOOLEAN                     DtDirectAccess;
+  //
+  // Set when receiving via interrupts. The receive FIFO is then only
+  // accessed at TPL_HIGH_LEVEL or from SerialInterruptHandler.
+  //
+  EFI_DT_INTERRUPT_PROTOCOL   *DtInterrupt;
+  EFI_DT_PROPERTY             InterruptData;
+  EFI_DT_INTERRUPT_COOKIE     InterruptCookie;
+  BOOLEAN                     ReceiveInterruptMasked;   ///< Receive FIFO was full.
+  BOOLEAN                     TransmitInterruptEnabled; ///< Handler drains the transmit FIFO.
+  EFI_EVENT                   InterruptExitBootServicesEvent;
+  //
+  // Set when SerialWrite only queues data in the transmit FIFO. Without
+  // DtInterrupt, TransmitTimer drains it.
+  //
+  BOOLEAN                     AsyncTransmit;
+  EFI_EVENT                   TransmitTimer;
+  BOOLEAN                     TransmitTimerArmed;
+  EFI_EVENT                   TransmitExitBootServicesEvent;
 } SERIAL_DEV;
 
 #define SERIAL_DEV_SIGNATURE  SIGNATURE_32 ('s', 'e', 'r', 'd')
@@ -542,6 +569,40 @@ SerialFifoRemove (
   OUT UINT8            *Data
   );
 
+/**
+  Add as much data as fits to specific FIFO.
+
+  @param Fifo                  A pointer to the Data Structure SERIAL_DEV_FIFO
+  @param Buffer                the data added to FIFO
+  @param Size                  size of Buffer
+
+  @return Number of bytes added.
+
+**/
+UINTN
+SerialFifoPush (
+  IN SERIAL_DEV_FIFO  *Fifo,
+  IN CONST UINT8      *Buffer,
+  IN UINTN            Size
+  );
+
+/**
+  Remove as much data as available from specific FIFO.
+
+  @param Fifo                  A pointer to the Data Structure SERIAL_DEV_FIFO
+  @param Buffer                the data removed from FIFO
+  @param Size                  size of Buffer
+
+  @return Number of bytes removed.
+
+**/
+UINTN
+SerialFifoPop (
+  IN  SERIAL_DEV_FIFO  *Fifo,
+  OUT UINT8            *Buffer,
+  IN  UINTN            Size
+  );
+
 /**
   Reads and writes all available data.
 
@@ -585,6 +646,153 @@ SerialWriteRegister (
   IN UINT8       Data
   );
 
+/**
+  Enable receive data available and line status interrupts in the UART.
+
+  @param SerialDevice   Pointer to serial device structure.
+
+**/
+VOID
+SerialInterruptEnableReceive (
+  IN SERIAL_DEV  *SerialDevice
+  );
+
+/**
+  Enable the transmitter holding register empty interrupt in the UART,
+  so the interrupt handler drains the software transmit FIFO.
+
+  Must be called at TPL_HIGH_LEVEL.
+
+  @param SerialDevice   Pointer to serial device structure.
+
+**/
+VOID
+SerialInterruptEnableTransmit (
+  IN SERIAL_DEV  *SerialDevice
+  );
+
+/**
+  Disable the transmitter holding register empty interrupt in the UART.
+
+  Must be called at TPL_HIGH_LEVEL or from the interrupt handler.
+
+  @param SerialDevice   Pointer to serial device structure.
+
+**/
+VOID
+SerialInterruptDisableTransmit (
+  IN SERIAL_DEV  *SerialDevice
+  );
+
+/**
+  Switch a DT-described UART to interrupt-driven receive, if the
+  DT node describes an interrupt and the interrupt controller
+  produces EFI_DT_INTERRUPT_PROTOCOL.
+
+  @param SerialDevice   Pointer to serial device structure.
+
+  @retval EFI_SUCCESS   Receive interrupts enabled.
+  @retval Other         The UART remains polled.
+
+**/
+EFI_STATUS
+SerialInterruptInit (
+  IN SERIAL_DEV  *SerialDevice
+  );
+
+/**
+  Switch a UART back to polled receive.
+
+  @param SerialDevice   Pointer to serial device structure.
+
+**/
+VOID
+SerialInterruptDeinit (
+  IN SERIAL_DEV  *SerialDevice
+  );
+
+/**
+  Move data from the software transmit FIFO to the hardware transmit FIFO,
+  if the latter is empty.
+
+  Called from SerialInterruptHandler, so no DEBUG() or REPORT_STATUS_CODE().
+  Other callers must be at TPL_HIGH_LEVEL when receiving via interrupts.
+
+  @param SerialDevice   Pointer to serial device structure.
+
+  @return Number of bytes moved.
+
+**/
+UINTN
+SerialTransmitFill (
+  IN SERIAL_DEV  *SerialDevice
+  );
+
+/**
+  Queue data in the software transmit FIFO, and start draining it.
+
+  Must be called at TPL_NOTIFY.
+
+  @param SerialDevice   Pointer to serial device structure.
+  @param Buffer         Data to transmit.
+  @param Size           Size of Buffer.
+
+  @return Number of bytes queued, 0 if the FIFO is full.
+
+**/
+UINTN
+SerialTransmitQueue (
+  IN SERIAL_DEV   *SerialDevice,
+  IN CONST UINT8  *Buffer,
+  IN UINTN        Size
+  );
+
+/**
+  Drain the software transmit FIFO into the UART, waiting as long
+  as data keeps moving.
+
+  @param SerialDevice   Pointer to serial device structure.
+  @param Timeout        How long to wait without progress, in microseconds.
+
+  @retval EFI_SUCCESS   The software transmit FIFO is empty.
+  @retval EFI_TIMEOUT   The UART stopped accepting data.
+
+**/
+EFI_STATUS
+SerialTransmitDrain (
+  IN SERIAL_DEV  *SerialDevice,
+  IN UINTN       Timeout
+  );
+
+/**
+  Enable asynchronous transmit, if PcdSerialAsyncTransmit is set.
+
+  Must be called after SerialInterruptInit.
+
+  @param SerialDevice   Pointer to serial device structure.
+
+  @retval EFI_SUCCESS   Asynchronous transmit enabled.
+  @retval Other         SerialWrite remains synchronous.
+
+**/
+EFI_STATUS
+SerialTransmitInit (
+  IN SERIAL_DEV  *SerialDevice
+  );
+
+/**
+  Flush any queued data and switch back to synchronous transmit.
+
+  Must be called before SerialInterruptDeinit.
+
+  @param SerialDevice   Pointer to serial device structure.
+
+**/
+VOID
+SerialTransmitDeinit (
+  IN SERIAL_DEV  *SerialDevice
+  );
+
 //
 // EFI Component Name Functions
 //
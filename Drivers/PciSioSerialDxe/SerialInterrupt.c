@@ -0,0 +1,401 @@
+/** @file
+    Interrupt-driven receive for DT-described 16550 UARTs.
+
+    When the DT node describes an interrupt and the interrupt controller
+    produces EFI_DT_INTERRUPT_PROTOCOL, the receive data available and
+    line status interrupts are enabled and the handler drains the
+    hardware FIFO into the software receive FIFO. Everything else
+    touching the receive FIFO runs at TPL_HIGH_LEVEL, so the handler
+    never sees it in an inconsistent state.
+
+    Copyright (c) 2024, Intel Corporation. All rights reserved.<BR>
+
+    SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "Serial.h"
+
+/**
+  Drain the hardware receive FIFO into the software receive FIFO.
+
+  Runs in interrupt context, so no DEBUG() or REPORT_STATUS_CODE(),
+  which may themselves end up on this UART.
+
+  @param SerialDevice   Pointer to serial device structure.
+
+**/
+STATIC
+VOID
+SerialInterruptReceive (
+  IN SERIAL_DEV  *SerialDevice
+  )
+{
+  SERIAL_PORT_LSR  Lsr;
+  SERIAL_PORT_MCR  Mcr;
+  SERIAL_PORT_IER  Ier;
+  UINT8            Data;
+
+  for ( ; ;) {
+    Lsr.Data = READ_LSR (SerialDevice);
+    if (Lsr.Bits.Dr == 0) {
+      break;
+    }
+
+    if (SerialFifoFull (&SerialDevice->Receive)) {
+      //
+      // Nowhere to put the data. Leave it in the hardware FIFO and
+      // stop taking receive interrupts, until SerialReceiveTransmit
+      // sees there is room again.
+      //
+      Ier.Data       = READ_IER (SerialDevice);
+      Ier.Bits.Ravie = 0;
+      Ier.Bits.Rie   = 0;
+      WRITE_IER (SerialDevice, Ier.Data);
+      SerialDevice->ReceiveInterruptMasked = TRUE;
+      break;
+    }
+
+    Data = READ_RBR (SerialDevice);
+    if ((Lsr.Bits.FIFOe == 1) || (Lsr.Bits.Pe == 1) || (Lsr.Bits.Fe == 1) || (Lsr.Bits.Bi == 1)) {
+      continue;
+    }
+
+    SerialFifoAdd (&SerialDevice->Receive, Data);
+
+    //
+    // For full handshake flow control, if receive buffer full
+    // tell the peer to stop sending data.
+    //
+    if (SerialDevice->HardwareFlowControl &&
+        !FeaturePcdGet (PcdSerialUseHalfHandshake) &&
+        SerialFifoFull (&SerialDevice->Receive)
+        )
+    {
+      Mcr.Data     = READ_MCR (SerialDevice);
+      Mcr.Bits.Rts = 0;
+      WRITE_MCR (SerialDevice, Mcr.Data);
+    }
+  }
+}
+
+/**
+  Interrupt handler for the UART.
+
+  @param Cookie         Identifies the interrupt registered.
+  @param CookieContext  SERIAL_DEV.
+  @param SystemContext  Unused.
+
+**/
+STATIC
+VOID
+EFIAPI
+SerialInterruptHandler (
+  IN  EFI_DT_INTERRUPT_COOKIE  Cookie,
+  IN  VOID                     *CookieContext,
+  IN  EFI_SYSTEM_CONTEXT       SystemContext
+  )
+{
+  SERIAL_DEV  *SerialDevice;
+
+  SerialDevice = CookieContext;
+  ASSERT (SerialDevice->Signature == SERIAL_DEV_SIGNATURE);
+
+  //
+  // Reading the LSR clears any line status interrupt, and draining
+  // the FIFO clears the data available and character timeout interrupts.
+  //
+  SerialInterruptReceive (SerialDevice);
+
+  //
+  // Writing the THR clears the THRE interrupt. Once there is nothing
+  // left to write, the interrupt has to be disabled instead.
+  //
+  if (SerialDevice->TransmitInterruptEnabled) {
+    SerialTransmitFill (SerialDevice);
+    if (SerialFifoEmpty (&SerialDevice->Transmit)) {
+      SerialInterruptDisableTransmit (SerialDevice);
+    }
+  }
+}
+
+/**
+  Enable receive data available and line status interrupts in the UART.
+
+  Called after the UART is reset, and when the software receive FIFO
+  has room again after the handler masked the receive interrupts.
+
+  @param SerialDevice   Pointer to serial device structure.
+
+**/
+VOID
+SerialInterruptEnableReceive (
+  IN SERIAL_DEV  *SerialDevice
+  )
+{
+  SERIAL_PORT_IER  Ier;
+  SERIAL_PORT_MCR  Mcr;
+
+  ASSERT (SerialDevice->DtInterrupt != NULL);
+
+  //
+  // OUT2 gates the interrupt line on PC-style designs and is
+  // harmless elsewhere.
+  //
+  Mcr.Data = READ_MCR (SerialDevice);
+  if (Mcr.Bits.Out2 == 0) {
+    Mcr.Bits.Out2 = 1;
+    WRITE_MCR (SerialDevice, Mcr.Data);
+  }
+
+  Ier.Data       = READ_IER (SerialDevice);
+  Ier.Bits.Ravie = 1;
+  Ier.Bits.Rie   = 1;
+  WRITE_IER (SerialDevice, Ier.Data);
+  SerialDevice->ReceiveInterruptMasked = FALSE;
+}
+
+/**
+  Enable the transmitter holding register empty interrupt in the UART,
+  so the interrupt handler drains the software transmit FIFO.
+
+  Must be called at TPL_HIGH_LEVEL.
+
+  @param SerialDevice   Pointer to serial device structure.
+
+**/
+VOID
+SerialInterruptEnableTransmit (
+  IN SERIAL_DEV  *SerialDevice
+  )
+{
+  SERIAL_PORT_IER  Ier;
+
+  ASSERT (SerialDevice->DtInterrupt != NULL);
+
+  if (SerialDevice->TransmitInterruptEnabled) {
+    return;
+  }
+
+  Ier.Data       = READ_IER (SerialDevice);
+  Ier.Bits.Theie = 1;
+  WRITE_IER (SerialDevice, Ier.Data);
+  SerialDevice->TransmitInterruptEnabled = TRUE;
+}
+
+/**
+  Disable the transmitter holding register empty interrupt in the UART.
+
+  Must be called at TPL_HIGH_LEVEL or from the interrupt handler.
+
+  @param SerialDevice   Pointer to serial device structure.
+
+**/
+VOID
+SerialInterruptDisableTransmit (
+  IN SERIAL_DEV  *SerialDevice
+  )
+{
+  SERIAL_PORT_IER  Ier;
+
+  if (!SerialDevice->TransmitInterruptEnabled) {
+    return;
+  }
+
+  Ier.Data       = READ_IER (SerialDevice);
+  Ier.Bits.Theie = 0;
+  WRITE_IER (SerialDevice, Ier.Data);
+  SerialDevice->TransmitInterruptEnabled = FALSE;
+}
+
+/**
+  Disable all UART interrupts, gate the interrupt line and unregister
+  the interrupt handler, leaving the UART in polled mode.
+
+  @param SerialDevice   Pointer to serial device structure.
+
+**/
+STATIC
+VOID
+SerialInterruptStop (
+  IN SERIAL_DEV  *SerialDevice
+  )
+{
+  SERIAL_PORT_IER  Ier;
+  SERIAL_PORT_MCR  Mcr;
+  EFI_TPL          Tpl;
+
+  Tpl            = gBS->RaiseTPL (TPL_HIGH_LEVEL);
+  Ier.Data       = READ_IER (SerialDevice);
+  Ier.Bits.Ravie = 0;
+  Ier.Bits.Theie = 0;
+  Ier.Bits.Rie   = 0;
+  WRITE_IER (SerialDevice, Ier.Data);
+  Mcr.Data      = READ_MCR (SerialDevice);
+  Mcr.Bits.Out2 = 0;
+  WRITE_MCR (SerialDevice, Mcr.Data);
+  SerialDevice->TransmitInterruptEnabled = FALSE;
+  gBS->RestoreTPL (Tpl);
+
+  SerialDevice->DtInterrupt->UnregisterInterrupt (
+                               SerialDevice->DtInterrupt,
+                               SerialDevice->InterruptCookie
+                               );
+  SerialDevice->DtInterrupt = NULL;
+}
+
+/**
+  Stop taking UART interrupts before the OS takes over.
+
+  @param  Event         Event whose notification function is being invoked.
+  @param  Context       Pointer to SERIAL_DEV.
+
+**/
+STATIC
+VOID
+EFIAPI
+SerialInterruptExitBootServices (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  SERIAL_DEV  *SerialDevice;
+
+  SerialDevice = Context;
+  if (SerialDevice->DtInterrupt != NULL) {
+    SerialInterruptStop (SerialDevice);
+  }
+}
+
+/**
+  Switch a DT-described UART to interrupt-driven receive, if the
+  DT node describes an interrupt and the interrupt controller
+  produces EFI_DT_INTERRUPT_PROTOCOL.
+
+  On failure, the UART is left in polled mode.
+
+  @param SerialDevice   Pointer to serial device structure.
+
+  @retval EFI_SUCCESS   Receive interrupts enabled.
+  @retval Other         The UART remains polled.
+
+**/
+EFI_STATUS
+SerialInterruptInit (
+  IN SERIAL_DEV  *SerialDevice
+  )
+{
+  EFI_STATUS                 Status;
+  EFI_HANDLE                 InterruptParent;
+  EFI_DT_INTERRUPT_PROTOCOL  *DtInterrupt;
+  EFI_TPL                    Tpl;
+
+  if (SerialDevice->DtIo == NULL) {
+    return EFI_UNSUPPORTED;
+  }
+
+  Status = FbpInterruptGet (
+             SerialDevice->DtIo,
+             0,
+             &InterruptParent,
+             &SerialDevice->InterruptData
+             );
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  //
+  // Interrupt controller drivers don't go away, so can use the simpler
+  // HandleProtocol instead of OpenProtocol.
+  //
+  Status = gBS->HandleProtocol (
+                  InterruptParent,
+                  &gEfiDtInterruptProtocolGuid,
+                  (VOID **)&DtInterrupt
+                  );
+  if (EFI_ERROR (Status)) {
+    DEBUG ((
+      DEBUG_INFO,
+      "%a: %a: no EFI_DT_INTERRUPT_PROTOCOL on interrupt parent (%r), polling\n",
+      __func__,
+      SerialDevice->DtIo->ComponentName,
+      Status
+      ));
+    return Status;
+  }
+
+  Status = DtInterrupt->RegisterInterrupt (
+                          DtInterrupt,
+                          &SerialDevice->InterruptData,
+                          SerialInterruptHandler,
+                          SerialDevice,
+                          &SerialDevice->InterruptCookie
+                          );
+  if (EFI_ERROR (Status)) {
+    DEBUG ((
+      DEBUG_ERROR,
+      "%a: %a: RegisterInterrupt: %r\n",
+      __func__,
+      SerialDevice->DtIo->ComponentName,
+      Status
+      ));
+    return Status;
+  }
+
+  Status = DtInterrupt->EnableInterrupt (
+                          DtInterrupt,
+                          SerialDevice->InterruptCookie
+                          );
+  if (EFI_ERROR (Status)) {
+    DEBUG ((
+      DEBUG_ERROR,
+      "%a: %a: EnableInterrupt: %r\n",
+      __func__,
+      SerialDevice->DtIo->ComponentName,
+      Status
+      ));
+    DtInterrupt->UnregisterInterrupt (DtInterrupt, SerialDevice->InterruptCookie);
+    return Status;
+  }
+
+  Status = gBS->CreateEvent (
+                  EVT_SIGNAL_EXIT_BOOT_SERVICES,
+                  TPL_NOTIFY,
+                  SerialInterruptExitBootServices,
+                  SerialDevice,
+                  &SerialDevice->InterruptExitBootServicesEvent
+                  );
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "%a: CreateEvent(ExitBootServices): %r\n", __func__, Status));
+    DtInterrupt->UnregisterInterrupt (DtInterrupt, SerialDevice->InterruptCookie);
+    return Status;
+  }
+
+  Tpl                       = gBS->RaiseTPL (TPL_HIGH_LEVEL);
+  SerialDevice->DtInterrupt = DtInterrupt;
+  SerialInterruptEnableReceive (SerialDevice);
+  gBS->RestoreTPL (Tpl);
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Switch a UART back to polled receive.
+
+  @param SerialDevice   Pointer to serial device structure.
+
+**/
+VOID
+SerialInterruptDeinit (
+  IN SERIAL_DEV  *SerialDevice
+  )
+{
+  if (SerialDevice->InterruptExitBootServicesEvent != NULL) {
+    gBS->CloseEvent (SerialDevice->InterruptExitBootServicesEvent);
+    SerialDevice->InterruptExitBootServicesEvent = NULL;
+  }
+
+  if (SerialDevice->DtInterrupt != NULL) {
+    SerialInterruptStop (SerialDevice);
+  }
+}
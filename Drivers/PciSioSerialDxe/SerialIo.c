@@ -216,7 +216,7 @@ SerialFifoFull (
   IN SERIAL_DEV_FIFO  *Fifo
   )
 {
-  return (BOOLEAN)(((Fifo->Tail + 1) % SERIAL_MAX_FIFO_SIZE) == Fifo->Head);
+  return (BOOLEAN)((Fifo->Tail - Fifo->Head) > Fifo->Mask);
 }
 
 /**
@@ -260,8 +260,8 @@ SerialFifoAdd (
   //
   // FIFO is not full can add data
   //
-  Fifo->Data[Fifo->Tail] = Data;
-  Fifo->Tail             = (Fifo->Tail + 1) % SERIAL_MAX_FIFO_SIZE;
+  Fifo->Data[Fifo->Tail & Fifo->Mask] = Data;
+  Fifo->Tail++;
   return EFI_SUCCESS;
 }
 
@@ -291,11 +291,109 @@ SerialFifoRemove (
   //
   // FIFO is not empty, can remove data
   //
-  *Data      = Fifo->Data[Fifo->Head];
-  Fifo->Head = (Fifo->Head + 1) % SERIAL_MAX_FIFO_SIZE;
+  *Data = Fifo->Data[Fifo->Head & Fifo->Mask];
+  Fifo->Head++;
   return EFI_SUCCESS;
 }
 
+/**
+  Add as much data as fits to specific FIFO.
+
+  @param Fifo                  A pointer to the Data Structure SERIAL_DEV_FIFO
+  @param Buffer                the data added to FIFO
+  @param Size                  size of Buffer
+
+  @return Number of bytes added.
+
+**/
+UINTN
+SerialFifoPush (
+  IN OUT SERIAL_DEV_FIFO  *Fifo,
+  IN     CONST UINT8      *Buffer,
+  IN     UINTN            Size
+  )
+{
+  UINTN   Count;
+  UINTN   Chunk;
+  UINT32  Offset;
+
+  Count  = MIN (Size, Fifo->Mask + 1 - (Fifo->Tail - Fifo->Head));
+  Offset = Fifo->Tail & Fifo->Mask;
+  Chunk  = MIN (Count, Fifo->Mask + 1 - Offset);
+
+  //
+  // Up to two copies, when wrapping around.
+  //
+  CopyMem (&Fifo->Data[Offset], Buffer, Chunk);
+  CopyMem (Fifo->Data, Buffer + Chunk, Count - Chunk);
+  Fifo->Tail += (UINT32)Count;
+  return Count;
+}
+
+/**
+  Remove as much data as available from specific FIFO.
+
+  @param Fifo                  A pointer to the Data Structure SERIAL_DEV_FIFO
+  @param Buffer                the data removed from FIFO
+  @param Size                  size of Buffer
+
+  @return Number of bytes removed.
+
+**/
+UINTN
+SerialFifoPop (
+  IN OUT SERIAL_DEV_FIFO  *Fifo,
+  OUT    UINT8            *Buffer,
+  IN     UINTN            Size
+  )
+{
+  UINTN   Count;
+  UINTN   Chunk;
+  UINT32  Offset;
+
+  Count  = MIN (Size, Fifo->Tail - Fifo->Head);
+  Offset = Fifo->Head & Fifo->Mask;
+  Chunk  = MIN (Count, Fifo->Mask + 1 - Offset);
+
+  CopyMem (Buffer, &Fifo->Data[Offset], Chunk);
+  CopyMem (Buffer + Chunk, Fifo->Data, Count - Chunk);
+  Fifo->Head += (UINT32)Count;
+  return Count;
+}
+
+/**
+  Remove as much data as available from the receive FIFO, which may
+  also be filled by SerialInterruptHandler.
+
+  @param SerialDevice          The device to read from.
+  @param Buffer                the data removed from FIFO
+  @param Size                  size of Buffer
+
+  @return Number of bytes removed.
+
+**/
+STATIC
+UINTN
+SerialReceiveFifoPop (
+  IN  SERIAL_DEV  *SerialDevice,
+  OUT UINT8       *Buffer,
+  IN  UINTN       Size
+  )
+{
+  UINTN    Count;
+  EFI_TPL  Tpl;
+
+  if (SerialDevice->DtInterrupt == NULL) {
+    return SerialFifoPop (&SerialDevice->Receive, Buffer, Size);
+  }
+
+  Tpl   = gBS->RaiseTPL (TPL_HIGH_LEVEL);
+  Count = SerialFifoPop (&SerialDevice->Receive, Buffer, Size);
+  gBS->RestoreTPL (Tpl);
+
+  return Count;
+}
+
 /**
   Reads and writes all available data.
 
@@ -306,8 +404,9 @@ SerialFifoRemove (
                                 this happens, pending writes are not done.
 
 **/
+STATIC
 EFI_STATUS
-SerialReceiveTransmit (
+SerialReceiveTransmitWorker (
   IN SERIAL_DEV  *SerialDevice
   )
 
@@ -458,7 +557,145 @@ SerialReceiveTransmit (
 }
 
 /**
-  Flush the serial hardware transmit FIFO, holding register, and shift register.
+  Reads and writes all available data.
+
+  @param SerialDevice           The device to transmit.
+
+  @retval EFI_SUCCESS           Data was read/written successfully.
+  @retval EFI_OUT_OF_RESOURCE   Failed because software receive FIFO is full.  Note, when
+                                this happens, pending writes are not done.
+
+**/
+EFI_STATUS
+SerialReceiveTransmit (
+  IN SERIAL_DEV  *SerialDevice
+  )
+{
+  EFI_STATUS  Status;
+  EFI_TPL     Tpl;
+
+  if (SerialDevice->DtInterrupt == NULL) {
+    return SerialReceiveTransmitWorker (SerialDevice);
+  }
+
+  //
+  // Keep SerialInterruptHandler out while the receive FIFO
+  // and the UART registers are being used.
+  //
+  Tpl    = gBS->RaiseTPL (TPL_HIGH_LEVEL);
+  Status = SerialReceiveTransmitWorker (SerialDevice);
+  if (SerialDevice->ReceiveInterruptMasked &&
+      !SerialFifoFull (&SerialDevice->Receive))
+  {
+    SerialInterruptEnableReceive (SerialDevice);
+  }
+
+  gBS->RestoreTPL (Tpl);
+
+  return Status;
+}
+
+/**
+  Briefly drop back to the caller's TPL in the middle of a transfer.
+
+  SerialWrite and SerialRead touch the FIFOs and the UART at TPL_NOTIFY,
+  but wait for the UART at the caller's TPL. TPL_NOTIFY is thus held for
+  at most one hardware FIFO's worth of characters, no matter how large
+  the transfer is. Pending events at higher TPLs get dispatched here.
+
+  @param CallerTpl     TPL returned by the RaiseTPL (TPL_NOTIFY) call.
+  @param Microseconds  How long to stall for, may be 0.
+
+**/
+STATIC
+VOID
+SerialDropTpl (
+  IN EFI_TPL  CallerTpl,
+  IN UINTN    Microseconds
+  )
+{
+  gBS->RestoreTPL (CallerTpl);
+  if (Microseconds != 0) {
+    gBS->Stall (Microseconds);
+  }
+
+  gBS->RaiseTPL (TPL_NOTIFY);
+}
+
+/**
+  Fill the hardware transmit FIFO straight from Buffer, if it is empty.
+
+  Pending receive data is moved into the software receive FIFO first,
+  to prevent an overrun during a long write. Only used without software
+  loopback and hardware flow control, which go through the software
+  transmit FIFO one byte at a time.
+
+  @param SerialDevice  The device to transmit to.
+  @param Buffer        Data to transmit.
+  @param Size          Size of Buffer.
+
+  @return Number of bytes written to the hardware FIFO, 0 if it is not empty yet.
+**/
+STATIC
+UINTN
+SerialTransmitBurst (
+  IN SERIAL_DEV   *SerialDevice,
+  IN CONST UINT8  *Buffer,
+  IN UINTN        Size
+  )
+{
+  SERIAL_PORT_LSR  Lsr;
+  UINTN            Count;
+  UINTN            Index;
+  BOOLEAN          Interrupts;
+  EFI_TPL          Tpl;
+
+  //
+  // Anything left over in the software transmit FIFO (from an earlier
+  // timed out write) goes out first.
+  //
+  if (!SerialFifoEmpty (&SerialDevice->Transmit)) {
+    SerialReceiveTransmit (SerialDevice);
+    return 0;
+  }
+
+  //
+  // Keep SerialInterruptHandler out between reading LSR (which clears
+  // the line status error bits) and filling THR.
+  //
+  Interrupts = (SerialDevice->DtInterrupt != NULL);
+  Tpl        = TPL_HIGH_LEVEL;
+  if (Interrupts) {
+    Tpl = gBS->RaiseTPL (TPL_HIGH_LEVEL);
+  }
+
+  Lsr.Data = READ_LSR (SerialDevice);
+  if ((Lsr.Bits.Dr == 1) && !Interrupts) {
+    SerialReceiveTransmit (SerialDevice);
+    Lsr.Data = READ_LSR (SerialDevice);
+  }
+
+  //
+  // With the FIFOs enabled, THRE means the whole transmit FIFO is empty.
+  //
+  Count = 0;
+  if (Lsr.Bits.Thre == 1) {
+    Count = MIN (Size, SerialDevice->TransmitFifoDepth);
+    for (Index = 0; Index < Count; Index++) {
+      WRITE_THR (SerialDevice, Buffer[Index]);
+    }
+  }
+
+  if (Interrupts) {
+    gBS->RestoreTPL (Tpl);
+  }
+
+  return Count;
+}
+
+/**
+  Flush the software transmit FIFO, when transmitting asynchronously,
+  and the serial hardware transmit FIFO, holding register, and shift register.
 
   @param SerialDevice  The device to flush.
 
@@ -505,6 +742,12 @@ SerialFlushTransmitFifo (
   // in the rest of this function that may send additional characters to this
   // UART device invalidating the flush operation.
   //
+  if (SerialDevice->AsyncTransmit &&
+      (SerialTransmitDrain (SerialDevice, Timeout) != EFI_SUCCESS))
+  {
+    return EFI_TIMEOUT;
+  }
+
   Elapsed  = 0;
   Lsr.Data = READ_LSR (SerialDevice);
   while (Lsr.Bits.Temt == 0 || Lsr.Bits.Thre == 0) {
@@ -586,6 +829,7 @@ SerialReset (
   Ier.Bits.Rie   = 0;
   Ier.Bits.Mie   = 0;
   WRITE_IER (SerialDevice, Ier.Data);
+  SerialDevice->TransmitInterruptEnabled = FALSE;
 
   //
   // Reset the FIFO
@@ -661,10 +905,15 @@ SerialReset (
   }
 
   //
-  // Reset the software FIFO
+  // Reset the software FIFO. UART interrupts are off, so
+  // SerialInterruptHandler won't touch the receive FIFO.
   //
   SerialDevice->Receive.Head  = SerialDevice->Receive.Tail = 0;
   SerialDevice->Transmit.Head = SerialDevice->Transmit.Tail = 0;
+  if (SerialDevice->DtInterrupt != NULL) {
+    SerialInterruptEnableReceive (SerialDevice);
+  }
+
   gBS->RestoreTPL (Tpl);
 
   //
@@ -708,6 +957,7 @@ SerialSetAttributes (
   SERIAL_PORT_LCR   Lcr;
   UART_DEVICE_PATH  *Uart;
   EFI_TPL           Tpl;
+  EFI_TPL           DlabTpl;
 
   SerialDevice = SERIAL_DEV_FROM_THIS (This);
 
@@ -761,6 +1011,12 @@ SerialSetAttributes (
   //
   SerialFlushTransmitFifo (SerialDevice);
 
+  //
+  // With DLAB set, SerialInterruptHandler would read the divisor
+  // latch instead of the receive buffer.
+  //
+  DlabTpl = gBS->RaiseTPL (TPL_HIGH_LEVEL);
+
   //
   // Put serial port on Divisor Latch Mode
   //
@@ -833,6 +1089,7 @@ SerialSetAttributes (
   //
   Lcr.Bits.SerialDB = (UINT8)((DataBits - 5) & 0x03);
   WRITE_LCR (SerialDevice, Lcr.Data);
+  gBS->RestoreTPL (DlabTpl);
 
   //
   // Set the Serial I/O mode
@@ -1129,6 +1386,7 @@ SerialWrite (
   EFI_TPL     Tpl;
   UINTN       Timeout;
   UINTN       BitsPerCharacter;
+  UINTN       Written;
 
   SerialDevice = SERIAL_DEV_FROM_THIS (This);
   Elapsed      = 0;
@@ -1182,6 +1440,73 @@ SerialWrite (
                        )
               );
 
+  if (SerialDevice->AsyncTransmit &&
+      !SerialDevice->SoftwareLoopbackEnable &&
+      !SerialDevice->HardwareFlowControl)
+  {
+    //
+    // Only wait if the software transmit FIFO is full. It is drained
+    // in the background.
+    //
+    while (ActualWrite < *BufferSize) {
+      Written = SerialTransmitQueue (
+                  SerialDevice,
+                  CharBuffer + ActualWrite,
+                  *BufferSize - ActualWrite
+                  );
+      if (Written != 0) {
+        ActualWrite += Written;
+        Elapsed      = 0;
+        SerialDropTpl (Tpl, 0);
+        continue;
+      }
+
+      if (Elapsed >= Timeout) {
+        *BufferSize = ActualWrite;
+        gBS->RestoreTPL (Tpl);
+        return EFI_TIMEOUT;
+      }
+
+      SerialDropTpl (Tpl, TIMEOUT_STALL_INTERVAL);
+      Elapsed += TIMEOUT_STALL_INTERVAL;
+    }
+
+    gBS->RestoreTPL (Tpl);
+    return EFI_SUCCESS;
+  }
+
+  if (!SerialDevice->SoftwareLoopbackEnable && !SerialDevice->HardwareFlowControl) {
+    //
+    // Refill the whole transmit FIFO every time it empties, instead of
+    // waiting for each byte to drain before queueing the next.
+    //
+    while (ActualWrite < *BufferSize) {
+      Written = SerialTransmitBurst (
+                  SerialDevice,
+                  CharBuffer + ActualWrite,
+                  *BufferSize - ActualWrite
+                  );
+      if (Written != 0) {
+        ActualWrite += Written;
+        Elapsed      = 0;
+        SerialDropTpl (Tpl, 0);
+        continue;
+      }
+
+      if (Elapsed >= Timeout) {
+        *BufferSize = ActualWrite;
+        gBS->RestoreTPL (Tpl);
+        return EFI_TIMEOUT;
+      }
+
+      SerialDropTpl (Tpl, TIMEOUT_STALL_INTERVAL);
+      Elapsed += TIMEOUT_STALL_INTERVAL;
+    }
+
+    gBS->RestoreTPL (Tpl);
+    return EFI_SUCCESS;
+  }
+
   for (Index = 0; Index < *BufferSize; Index++) {
     SerialFifoAdd (&SerialDevice->Transmit, CharBuffer[Index]);
 
@@ -1196,7 +1521,7 @@ SerialWrite (
         return EFI_TIMEOUT;
       }
 
-      gBS->Stall (TIMEOUT_STALL_INTERVAL);
+      SerialDropTpl (Tpl, TIMEOUT_STALL_INTERVAL);
 
       Elapsed += TIMEOUT_STALL_INTERVAL;
     }
@@ -1206,6 +1531,7 @@ SerialWrite (
     //  Successful write so reset timeout
     //
     Elapsed = 0;
+    SerialDropTpl (Tpl, 0);
   }
 
   gBS->RestoreTPL (Tpl);
@@ -1235,7 +1561,8 @@ SerialRead (
   )
 {
   SERIAL_DEV  *SerialDevice;
-  UINT32      Index;
+  UINTN       Index;
+  UINTN       Count;
   UINT8       *CharBuffer;
   UINTN       Elapsed;
   EFI_STATUS  Status;
@@ -1271,34 +1598,38 @@ SerialRead (
   }
 
   CharBuffer = (UINT8 *)Buffer;
-  for (Index = 0; Index < *BufferSize; Index++) {
-    while (SerialFifoRemove (&SerialDevice->Receive, &(CharBuffer[Index])) != EFI_SUCCESS) {
+  Index      = 0;
+  while (Index < *BufferSize) {
+    Count = SerialReceiveFifoPop (SerialDevice, CharBuffer + Index, *BufferSize - Index);
+    if (Count != 0) {
       //
-      //  Unsuccessful read so check if timeout has expired, if not,
-      //  stall for a bit, increment time elapsed, and try again
-      //  Need this time out to get conspliter to work.
+      //  Successful read so reset timeout
       //
-      if (Elapsed >= This->Mode->Timeout) {
-        *BufferSize = Index;
-        gBS->RestoreTPL (Tpl);
-        return EFI_TIMEOUT;
-      }
-
-      gBS->Stall (TIMEOUT_STALL_INTERVAL);
-      Elapsed += TIMEOUT_STALL_INTERVAL;
-
-      Status = SerialReceiveTransmit (SerialDevice);
-      if (Status == EFI_DEVICE_ERROR) {
-        *BufferSize = Index;
-        gBS->RestoreTPL (Tpl);
-        return EFI_DEVICE_ERROR;
-      }
+      Index  += Count;
+      Elapsed = 0;
+      continue;
     }
 
     //
-    //  Successful read so reset timeout
+    //  Unsuccessful read so check if timeout has expired, if not,
+    //  stall for a bit, increment time elapsed, and try again
+    //  Need this time out to get conspliter to work.
     //
-    Elapsed = 0;
+    if (Elapsed >= This->Mode->Timeout) {
+      *BufferSize = Index;
+      gBS->RestoreTPL (Tpl);
+      return EFI_TIMEOUT;
+    }
+
+    SerialDropTpl (Tpl, TIMEOUT_STALL_INTERVAL);
+    Elapsed += TIMEOUT_STALL_INTERVAL;
+
+    Status = SerialReceiveTransmit (SerialDevice);
+    if (Status == EFI_DEVICE_ERROR) {
+      *BufferSize = Index;
+      gBS->RestoreTPL (Tpl);
+      return EFI_DEVICE_ERROR;
+    }
   }
 
   SerialReceiveTransmit (SerialDevice);
@@ -1367,7 +1698,9 @@ SerialReadRegister (
   UINT8       Data;
   EFI_STATUS  Status;
 
-  if (SerialDev->DtIo != NULL) {
+  if (SerialDev->DtDirectAccess) {
+    return MmioRead8 ((UINTN)SerialDev->BaseAddress + Offset * SerialDev->RegisterStride);
+  } else if (SerialDev->DtIo != NULL) {
     Status = SerialDev->DtIo->ReadReg (
                                 SerialDev->DtIo,
                                 EfiDtIoWidthUint8,
@@ -1423,7 +1756,9 @@ SerialWriteRegister (
 {
   EFI_STATUS  Status;
 
-  if (SerialDev->DtIo != NULL) {
+  if (SerialDev->DtDirectAccess) {
+    MmioWrite8 ((UINTN)SerialDev->BaseAddress + Offset * SerialDev->RegisterStride, Data);
+  } else if (SerialDev->DtIo != NULL) {
     Status = SerialDev->DtIo->WriteReg (
                                 SerialDev->DtIo,
                                 EfiDtIoWidthUint8,
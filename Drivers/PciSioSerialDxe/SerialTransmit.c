@@ -0,0 +1,361 @@
+/** @file
+    Asynchronous transmit for 16550 UARTs.
+
+    With PcdSerialAsyncTransmit, SerialWrite only copies data into the
+    software transmit FIFO and returns. The FIFO is drained in the
+    background by SerialInterruptHandler on THRE interrupts, when the
+    UART receives via interrupts, or else by a periodic timer event.
+    SerialFlushTransmitFifo drains it synchronously, which keeps the
+    blocking semantics for Reset, SetAttributes, SetControl and
+    ExitBootServices.
+
+    Copyright (c) 2024, Intel Corporation. All rights reserved.<BR>
+
+    SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "Serial.h"
+
+/**
+  Move data from the software transmit FIFO to the hardware transmit FIFO,
+  if the latter is empty.
+
+  Called from SerialInterruptHandler, so no DEBUG() or REPORT_STATUS_CODE().
+  Other callers must be at TPL_HIGH_LEVEL when receiving via interrupts.
+
+  @param SerialDevice   Pointer to serial device structure.
+
+  @return Number of bytes moved.
+
+**/
+UINTN
+SerialTransmitFill (
+  IN SERIAL_DEV  *SerialDevice
+  )
+{
+  SERIAL_PORT_LSR  Lsr;
+  UINTN            Count;
+  UINT8            Data;
+
+  //
+  // With the FIFOs enabled, THRE means the whole transmit FIFO is empty.
+  //
+  Lsr.Data = READ_LSR (SerialDevice);
+  if (Lsr.Bits.Thre == 0) {
+    return 0;
+  }
+
+  for (Count = 0; Count < SerialDevice->TransmitFifoDepth; Count++) {
+    if (SerialFifoRemove (&SerialDevice->Transmit, &Data) != EFI_SUCCESS) {
+      break;
+    }
+
+    WRITE_THR (SerialDevice, Data);
+  }
+
+  return Count;
+}
+
+/**
+  Make sure the software transmit FIFO keeps draining in the background.
+
+  Must be called at TPL_NOTIFY.
+
+  @param SerialDevice   Pointer to serial device structure.
+
+**/
+STATIC
+VOID
+SerialTransmitKick (
+  IN SERIAL_DEV  *SerialDevice
+  )
+{
+  UINT64  BitsPerCharacter;
+  UINT64  Period;
+
+  if (SerialFifoEmpty (&SerialDevice->Transmit) ||
+      SerialDevice->TransmitTimerArmed)
+  {
+    return;
+  }
+
+  //
+  // Poll about as often as the hardware FIFO empties at the current
+  // baud rate. The platform timer tick may well be coarser than that,
+  // in which case throughput drops, but nothing ever spins.
+  //
+  BitsPerCharacter = 1 + SerialDevice->SerialMode.DataBits +
+                     ((SerialDevice->SerialMode.StopBits == TwoStopBits) ?
+                      2 : SerialDevice->SerialMode.StopBits);
+  Period = DivU64x64Remainder (
+             BitsPerCharacter * SerialDevice->TransmitFifoDepth * 10000000,
+             SerialDevice->SerialMode.BaudRate,
+             NULL
+             );
+
+  if (!EFI_ERROR (gBS->SetTimer (SerialDevice->TransmitTimer, TimerPeriodic, MAX (Period, 1)))) {
+    SerialDevice->TransmitTimerArmed = TRUE;
+  }
+}
+
+/**
+  Drain the software transmit FIFO in the background, when not
+  transmitting via interrupts.
+
+  @param Event    The timer event.
+  @param Context  SERIAL_DEV.
+
+**/
+STATIC
+VOID
+EFIAPI
+SerialTransmitTimerNotify (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  SERIAL_DEV       *SerialDevice;
+  SERIAL_PORT_LSR  Lsr;
+
+  SerialDevice = Context;
+
+  //
+  // Flush incoming data to prevent an overrun during a long write.
+  //
+  Lsr.Data = READ_LSR (SerialDevice);
+  if (Lsr.Bits.Dr == 1) {
+    SerialReceiveTransmit (SerialDevice);
+  }
+
+  SerialTransmitFill (SerialDevice);
+  if (SerialFifoEmpty (&SerialDevice->Transmit)) {
+    gBS->SetTimer (Event, TimerCancel, 0);
+    SerialDevice->TransmitTimerArmed = FALSE;
+  }
+}
+
+/**
+  Flush the software transmit FIFO before the OS takes over.
+
+  @param Event    The ExitBootServices event.
+  @param Context  SERIAL_DEV.
+
+**/
+STATIC
+VOID
+EFIAPI
+SerialTransmitExitBootServices (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  SERIAL_DEV  *SerialDevice;
+
+  SerialDevice = Context;
+
+  SerialFlushTransmitFifo (SerialDevice);
+
+  //
+  // Neither timer events nor interrupts are going to drain the
+  // transmit FIFO anymore.
+  //
+  SerialDevice->AsyncTransmit = FALSE;
+}
+
+/**
+  Queue data in the software transmit FIFO, and start draining it.
+
+  Must be called at TPL_NOTIFY.
+
+  @param SerialDevice   Pointer to serial device structure.
+  @param Buffer         Data to transmit.
+  @param Size           Size of Buffer.
+
+  @return Number of bytes queued, 0 if the FIFO is full.
+
+**/
+UINTN
+SerialTransmitQueue (
+  IN SERIAL_DEV   *SerialDevice,
+  IN CONST UINT8  *Buffer,
+  IN UINTN        Size
+  )
+{
+  SERIAL_PORT_LSR  Lsr;
+  UINTN            Count;
+  EFI_TPL          Tpl;
+
+  ASSERT (SerialDevice->AsyncTransmit);
+
+  if (SerialDevice->DtInterrupt == NULL) {
+    Lsr.Data = READ_LSR (SerialDevice);
+    if (Lsr.Bits.Dr == 1) {
+      SerialReceiveTransmit (SerialDevice);
+    }
+
+    Count = SerialFifoPush (&SerialDevice->Transmit, Buffer, Size);
+    SerialTransmitFill (SerialDevice);
+    SerialTransmitKick (SerialDevice);
+    return Count;
+  }
+
+  //
+  // Keep SerialInterruptHandler out while the transmit FIFO is updated.
+  // Enabling the THRE interrupt with the hardware FIFO already empty
+  // raises it right away, so the handler takes it from here.
+  //
+  Tpl   = gBS->RaiseTPL (TPL_HIGH_LEVEL);
+  Count = SerialFifoPush (&SerialDevice->Transmit, Buffer, Size);
+  if (!SerialFifoEmpty (&SerialDevice->Transmit)) {
+    SerialInterruptEnableTransmit (SerialDevice);
+  }
+
+  gBS->RestoreTPL (Tpl);
+
+  return Count;
+}
+
+/**
+  Drain the software transmit FIFO into the UART, waiting as long
+  as data keeps moving.
+
+  @param SerialDevice   Pointer to serial device structure.
+  @param Timeout        How long to wait without progress, in microseconds.
+
+  @retval EFI_SUCCESS   The software transmit FIFO is empty.
+  @retval EFI_TIMEOUT   The UART stopped accepting data.
+
+**/
+EFI_STATUS
+SerialTransmitDrain (
+  IN SERIAL_DEV  *SerialDevice,
+  IN UINTN       Timeout
+  )
+{
+  UINTN    Elapsed;
+  BOOLEAN  Empty;
+  EFI_TPL  Tpl;
+
+  //
+  // NOTE: Do not use any DEBUG() or REPORT_STATUS_CODE() here, as
+  // these may send additional characters to this UART device.
+  //
+  Elapsed = 0;
+  for ( ; ;) {
+    Tpl = gBS->RaiseTPL (TPL_HIGH_LEVEL);
+    if (SerialTransmitFill (SerialDevice) != 0) {
+      Elapsed = 0;
+    }
+
+    Empty = SerialFifoEmpty (&SerialDevice->Transmit);
+    if (Empty && (SerialDevice->DtInterrupt != NULL)) {
+      //
+      // Nothing left for SerialInterruptHandler to send, and the
+      // non-asynchronous paths in SerialWrite touch the transmit
+      // FIFO without holding it off.
+      //
+      SerialInterruptDisableTransmit (SerialDevice);
+    }
+
+    gBS->RestoreTPL (Tpl);
+
+    if (Empty) {
+      return EFI_SUCCESS;
+    }
+
+    if (Elapsed >= Timeout) {
+      return EFI_TIMEOUT;
+    }
+
+    gBS->Stall (TIMEOUT_STALL_INTERVAL);
+    Elapsed += TIMEOUT_STALL_INTERVAL;
+  }
+}
+
+/**
+  Enable asynchronous transmit, if PcdSerialAsyncTransmit is set.
+
+  Must be called after SerialInterruptInit.
+
+  @param SerialDevice   Pointer to serial device structure.
+
+  @retval EFI_SUCCESS   Asynchronous transmit enabled.
+  @retval Other         SerialWrite remains synchronous.
+
+**/
+EFI_STATUS
+SerialTransmitInit (
+  IN SERIAL_DEV  *SerialDevice
+  )
+{
+  EFI_STATUS  Status;
+
+  if (!PcdGetBool (PcdSerialAsyncTransmit)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  if (SerialDevice->DtInterrupt == NULL) {
+    Status = gBS->CreateEvent (
+                    EVT_TIMER | EVT_NOTIFY_SIGNAL,
+                    TPL_NOTIFY,
+                    SerialTransmitTimerNotify,
+                    SerialDevice,
+                    &SerialDevice->TransmitTimer
+                    );
+    if (EFI_ERROR (Status)) {
+      DEBUG ((DEBUG_ERROR, "%a: CreateEvent: %r\n", __func__, Status));
+      return Status;
+    }
+  }
+
+  Status = gBS->CreateEvent (
+                  EVT_SIGNAL_EXIT_BOOT_SERVICES,
+                  TPL_NOTIFY,
+                  SerialTransmitExitBootServices,
+                  SerialDevice,
+                  &SerialDevice->TransmitExitBootServicesEvent
+                  );
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "%a: CreateEvent(ExitBootServices): %r\n", __func__, Status));
+    if (SerialDevice->TransmitTimer != NULL) {
+      gBS->CloseEvent (SerialDevice->TransmitTimer);
+      SerialDevice->TransmitTimer = NULL;
+    }
+
+    return Status;
+  }
+
+  SerialDevice->AsyncTransmit = TRUE;
+  return EFI_SUCCESS;
+}
+
+/**
+  Flush any queued data and switch back to synchronous transmit.
+
+  Must be called before SerialInterruptDeinit.
+
+  @param SerialDevice   Pointer to serial device structure.
+
+**/
+VOID
+SerialTransmitDeinit (
+  IN SERIAL_DEV  *SerialDevice
+  )
+{
+  if (!SerialDevice->AsyncTransmit) {
+    return;
+  }
+
+  SerialFlushTransmitFifo (SerialDevice);
+  SerialDevice->AsyncTransmit = FALSE;
+
+  if (SerialDevice->TransmitTimer != NULL) {
+    gBS->CloseEvent (SerialDevice->TransmitTimer);
+    SerialDevice->TransmitTimer      = NULL;
+    SerialDevice->TransmitTimerArmed = FALSE;
+  }
+
+  gBS->CloseEvent (SerialDevice->TransmitExitBootServicesEvent);
+  SerialDevice->TransmitExitBootServicesEvent = NULL;
+}
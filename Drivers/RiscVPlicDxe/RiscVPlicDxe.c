@@ -0,0 +1,1193 @@
+/** @file
+    RISC-V PLIC and APLIC interrupt controller driver.
+
+    Produces EFI_DT_INTERRUPT_PROTOCOL for sifive,plic-1.0.0, riscv,plic0
+    and riscv,aplic (direct delivery mode) controllers, routing interrupts
+    to supervisor mode on the boot hart.
+
+    Copyright (c) 2024, Intel Corporation. All rights reserved.<BR>
+
+    SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "RiscVPlicDxe.h"
+
+STATIC EFI_CPU_ARCH_PROTOCOL  *mCpu;
+STATIC UINT64                 mPerfStart;
+STATIC UINT64                 mPerfEnd;
+STATIC EFI_EVENT              mExitBootServicesEvent;
+
+//
+// All started controllers. Only modified at TPL_HIGH_LEVEL, as
+// it is walked by the external interrupt handler.
+//
+STATIC LIST_ENTRY  mPlics = INITIALIZE_LIST_HEAD_VARIABLE (mPlics);
+
+STATIC CONST CHAR8  *mPlicCompatibles[] = {
+  "sifive,plic-1.0.0",
+  "riscv,plic0",
+};
+
+/**
+  Read a controller register.
+
+  @param  Plic    PLIC_DEVICE *.
+  @param  Offset  Register offset.
+
+  @return Register value.
+
+**/
+STATIC
+UINT32
+PlicRead32 (
+  IN  PLIC_DEVICE  *Plic,
+  IN  UINTN        Offset
+  )
+{
+  return MmioRead32 (Plic->Base + Offset);
+}
+
+/**
+  Write a controller register.
+
+  @param  Plic    PLIC_DEVICE *.
+  @param  Offset  Register offset.
+  @param  Value   Value to write.
+
+**/
+STATIC
+VOID
+PlicWrite32 (
+  IN  PLIC_DEVICE  *Plic,
+  IN  UINTN        Offset,
+  IN  UINT32       Value
+  )
+{
+  MmioWrite32 (Plic->Base + Offset, Value);
+}
+
+/**
+  Return the number of performance counter ticks between two readings,
+  allowing for the counter counting down and for (at most one) rollover
+  between them.
+
+  @param  StartTick  Earlier reading.
+  @param  EndTick    Later reading.
+
+  @return Elapsed ticks.
+
+**/
+STATIC
+UINT64
+PlicElapsedTicks (
+  IN  UINT64  StartTick,
+  IN  UINT64  EndTick
+  )
+{
+  if (mPerfEnd >= mPerfStart) {
+    if (EndTick >= StartTick) {
+      return EndTick - StartTick;
+    }
+
+    return (mPerfEnd - StartTick) + (EndTick - mPerfStart) + 1;
+  }
+
+  if (StartTick >= EndTick) {
+    return StartTick - EndTick;
+  }
+
+  return (StartTick - mPerfEnd) + (mPerfStart - EndTick) + 1;
+}
+
+/**
+  Unmask or mask an interrupt source for the boot hart.
+
+  @param  Plic    PLIC_DEVICE *.
+  @param  Source  Interrupt source.
+  @param  Enable  TRUE to unmask.
+
+**/
+STATIC
+VOID
+PlicSourceEnable (
+  IN  PLIC_DEVICE  *Plic,
+  IN  UINT32       Source,
+  IN  BOOLEAN      Enable
+  )
+{
+  EFI_TPL  OldTpl;
+  UINTN    Offset;
+  UINT32   Value;
+
+  Plic->Sources[Source].Enabled = Enable;
+
+  if (Plic->Type == PlicTypeAplic) {
+    PlicWrite32 (Plic, Enable ? APLIC_SETIENUM : APLIC_CLRIENUM, Source);
+    return;
+  }
+
+  Offset = PLIC_ENABLE (Plic->Context) + (Source / 32) * sizeof (UINT32);
+
+  OldTpl = gBS->RaiseTPL (TPL_HIGH_LEVEL);
+  Value  = PlicRead32 (Plic, Offset);
+  if (Enable) {
+    Value |= 1U << (Source % 32);
+  } else {
+    Value &= ~(1U << (Source % 32));
+  }
+
+  PlicWrite32 (Plic, Offset, Value);
+  gBS->RestoreTPL (OldTpl);
+}
+
+/**
+  Program the priority (and for the APLIC, the trigger mode and
+  target) of an interrupt source.
+
+  @param  Plic    PLIC_DEVICE *.
+  @param  Source  Interrupt source.
+  @param  Flags   IRQ_TYPE_xxx from the interrupt specifier, or 0.
+
+  @retval EFI_SUCCESS      Success.
+  @retval EFI_UNSUPPORTED  Trigger mode not supported.
+
+**/
+STATIC
+EFI_STATUS
+PlicSourceConfigure (
+  IN  PLIC_DEVICE  *Plic,
+  IN  UINT32       Source,
+  IN  UINT32       Flags
+  )
+{
+  UINT32  SourceMode;
+
+  if (Plic->Type == PlicTypePlic) {
+    //
+    // PLIC trigger mode is fixed by the hardware.
+    //
+    PlicWrite32 (Plic, PLIC_PRIORITY (Source), PLIC_DEFAULT_PRIORITY);
+    return EFI_SUCCESS;
+  }
+
+  switch (Flags) {
+    case 0:
+    case IRQ_TYPE_LEVEL_HIGH:
+      SourceMode = APLIC_SM_LEVEL_HIGH;
+      break;
+    case IRQ_TYPE_LEVEL_LOW:
+      SourceMode = APLIC_SM_LEVEL_LOW;
+      break;
+    case IRQ_TYPE_EDGE_RISING:
+      SourceMode = APLIC_SM_EDGE_RISE;
+      break;
+    case IRQ_TYPE_EDGE_FALLING:
+      SourceMode = APLIC_SM_EDGE_FALL;
+      break;
+    default:
+      DEBUG ((DEBUG_ERROR, "%a: unsupported trigger 0x%x for source %u\n", __func__, Flags, Source));
+      return EFI_UNSUPPORTED;
+  }
+
+  PlicWrite32 (Plic, APLIC_SOURCECFG (Source), SourceMode);
+  PlicWrite32 (
+    Plic,
+    APLIC_TARGET (Source),
+    (Plic->Context << APLIC_TARGET_HART_SHIFT) | APLIC_DEFAULT_PRIORITY
+    );
+  return EFI_SUCCESS;
+}
+
+/**
+  Return an interrupt source to the reset state, i.e. masked and
+  never delivered.
+
+  @param  Plic    PLIC_DEVICE *.
+  @param  Source  Interrupt source.
+
+**/
+STATIC
+VOID
+PlicSourceReset (
+  IN  PLIC_DEVICE  *Plic,
+  IN  UINT32       Source
+  )
+{
+  PlicSourceEnable (Plic, Source, FALSE);
+
+  if (Plic->Type == PlicTypePlic) {
+    //
+    // Priority 0 means "never interrupt".
+    //
+    PlicWrite32 (Plic, PLIC_PRIORITY (Source), 0);
+  } else {
+    PlicWrite32 (Plic, APLIC_SOURCECFG (Source), APLIC_SM_INACTIVE);
+  }
+}
+
+/**
+  Claim the highest priority pending interrupt.
+
+  @param  Plic    PLIC_DEVICE *.
+
+  @return Interrupt source, or 0 if none pending.
+
+**/
+STATIC
+UINT32
+PlicClaim (
+  IN  PLIC_DEVICE  *Plic
+  )
+{
+  if (Plic->Type == PlicTypeAplic) {
+    return PlicRead32 (Plic, APLIC_IDC (Plic->Context) + APLIC_IDC_CLAIMI) >> APLIC_IDC_CLAIMI_SHIFT;
+  }
+
+  return PlicRead32 (Plic, PLIC_CLAIM (Plic->Context));
+}
+
+/**
+  Signal completion of a claimed interrupt.
+
+  @param  Plic    PLIC_DEVICE *.
+  @param  Source  Interrupt source returned by PlicClaim.
+
+**/
+STATIC
+VOID
+PlicComplete (
+  IN  PLIC_DEVICE  *Plic,
+  IN  UINT32       Source
+  )
+{
+  //
+  // Reading claimi already completes the claim on the APLIC.
+  //
+  if (Plic->Type == PlicTypePlic) {
+    PlicWrite32 (Plic, PLIC_CLAIM (Plic->Context), Source);
+  }
+}
+
+/**
+  Supervisor external interrupt handler. Claims and dispatches
+  pending interrupts on every controller until none are left.
+
+  @param  InterruptType  EXCEPT_RISCV_IRQ_EXT_FROM_SMODE.
+  @param  SystemContext  Interrupted context.
+
+**/
+STATIC
+VOID
+EFIAPI
+PlicInterruptHandler (
+  IN  EFI_EXCEPTION_TYPE  InterruptType,
+  IN  EFI_SYSTEM_CONTEXT  SystemContext
+  )
+{
+  LIST_ENTRY   *Link;
+  PLIC_DEVICE  *Plic;
+  PLIC_SOURCE  *Entry;
+  UINT32       Source;
+  UINT64       StartTick;
+  UINT64       Ticks;
+  EFI_TPL      OriginalTPL;
+
+  OriginalTPL = gBS->RaiseTPL (TPL_HIGH_LEVEL);
+
+  for (Link = GetFirstNode (&mPlics)
+       ; !IsNull (&mPlics, Link)
+       ; Link = GetNextNode (&mPlics, Link)
+       )
+  {
+    Plic = PLIC_DEVICE_FROM_LINK (Link);
+
+    while ((Source = PlicClaim (Plic)) != 0) {
+      Entry = NULL;
+      if (Source <= Plic->NumSources) {
+        Entry = &Plic->Sources[Source];
+      }
+
+      if ((Entry != NULL) && (Entry->Handler != NULL)) {
+        if (!Entry->Enabled) {
+          //
+          // Raced with DisableInterrupt. The handler isn't called for
+          // a disabled source, the claim is just completed.
+          //
+          Entry->SpuriousClaims++;
+          PlicComplete (Plic, Source);
+          continue;
+        }
+
+        StartTick = GetPerformanceCounter ();
+        if (Entry->FirstInterruptTicks == 0) {
+          Entry->FirstInterruptTicks = MAX (PlicElapsedTicks (Entry->RegisterTick, StartTick), 1);
+        }
+
+        Entry->Handler (Entry, Entry->CookieContext, SystemContext);
+
+        Ticks = PlicElapsedTicks (StartTick, GetPerformanceCounter ());
+        if ((Entry->Interrupts == 0) || (Ticks < Entry->HandlerMinTicks)) {
+          Entry->HandlerMinTicks = Ticks;
+        }
+
+        if (Ticks > Entry->HandlerMaxTicks) {
+          Entry->HandlerMaxTicks = Ticks;
+        }
+
+        Entry->HandlerTotalTicks += Ticks;
+        Entry->Interrupts++;
+      } else {
+        //
+        // Nothing to handle it. Mask it so it doesn't storm.
+        //
+        Plic->SpuriousInterrupts++;
+        if (Entry != NULL) {
+          PlicSourceEnable (Plic, Source, FALSE);
+        }
+      }
+
+      PlicComplete (Plic, Source);
+    }
+  }
+
+  gBS->RestoreTPL (OriginalTPL);
+}
+
+/**
+  Validate a cookie returned by PlicRegisterInterrupt.
+
+  @param  Plic    PLIC_DEVICE *.
+  @param  Cookie  EFI_DT_INTERRUPT_COOKIE.
+
+  @return PLIC_SOURCE * or NULL if the cookie is invalid.
+
+**/
+STATIC
+PLIC_SOURCE *
+PlicSourceFromCookie (
+  IN  PLIC_DEVICE              *Plic,
+  IN  EFI_DT_INTERRUPT_COOKIE  Cookie
+  )
+{
+  PLIC_SOURCE  *Entry;
+
+  Entry = Cookie;
+  if ((Entry == NULL) ||
+      (Entry <= &Plic->Sources[0]) ||
+      (Entry > &Plic->Sources[Plic->NumSources]) ||
+      (Entry->Signature != PLIC_SOURCE_SIGNATURE) ||
+      (Entry->Handler == NULL))
+  {
+    return NULL;
+  }
+
+  return Entry;
+}
+
+/**
+  Register Handler for the specified interrupt source.
+
+  InterruptData->Iter is only modified on success.
+
+  @param This            Instance pointer for this protocol.
+  @param InterruptData   Interrupt specifier.
+  @param Handler         Callback for interrupt.
+  @param CookieContext   Additional context to pass to Handler.
+  @param Cookie          A unique value used for further operations on a registered interrupt.
+
+  @retval EFI_SUCCESS            Interrupt handler registered, *Cookie set, InterruptData->Iter updated.
+  @retval EFI_UNSUPPORTED        Configuration not supported.
+  @retval EFI_INVALID_PARAMETER  Bad parameter.
+  @retval EFI_DEVICE_ERROR       Hardware could not be programmed.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+PlicRegisterInterrupt (
+  IN  EFI_DT_INTERRUPT_PROTOCOL  *This,
+  IN  EFI_DT_PROPERTY            *InterruptData,
+  IN  EFI_DT_INTERRUPT_HANDLER   Handler,
+  IN  VOID                       *CookieContext,
+  OUT EFI_DT_INTERRUPT_COOKIE    *Cookie
+  )
+{
+  EFI_STATUS       Status;
+  EFI_TPL          OldTpl;
+  PLIC_DEVICE      *Plic;
+  PLIC_SOURCE      *Entry;
+  EFI_DT_PROPERTY  Data;
+  UINT32           Source;
+  UINT32           Flags;
+
+  if ((This == NULL) || (InterruptData == NULL) ||
+      (Handler == NULL) || (Cookie == NULL))
+  {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Plic = PLIC_DEVICE_FROM_DT_INTERRUPT (This);
+  if ((InterruptData->End - InterruptData->Iter) < (sizeof (EFI_DT_CELL) * Plic->InterruptCells)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Data   = *InterruptData;
+  Flags  = 0;
+  Status = Plic->DtIo->ParseProp (Plic->DtIo, &Data, EFI_DT_VALUE_U32, 0, &Source);
+  if (!EFI_ERROR (Status) && (Plic->InterruptCells > 1)) {
+    Status = Plic->DtIo->ParseProp (Plic->DtIo, &Data, EFI_DT_VALUE_U32, 0, &Flags);
+  }
+
+  if (EFI_ERROR (Status) || (Source == 0) || (Source > Plic->NumSources)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Entry  = &Plic->Sources[Source];
+  OldTpl = gBS->RaiseTPL (TPL_HIGH_LEVEL);
+  if (Entry->Handler != NULL) {
+    //
+    // Shared interrupt lines are not supported.
+    //
+    gBS->RestoreTPL (OldTpl);
+    DEBUG ((DEBUG_ERROR, "%a: %a source %u already registered\n", __func__, Plic->DtIo->Name, Source));
+    return EFI_UNSUPPORTED;
+  }
+
+  Status = PlicSourceConfigure (Plic, Source, Flags);
+  if (!EFI_ERROR (Status)) {
+    Entry->Handler             = Handler;
+    Entry->CookieContext       = CookieContext;
+    Entry->RegisterTick        = GetPerformanceCounter ();
+    Entry->FirstInterruptTicks = 0;
+    Entry->Interrupts          = 0;
+    Entry->SpuriousClaims      = 0;
+    Entry->HandlerMinTicks     = 0;
+    Entry->HandlerMaxTicks     = 0;
+    Entry->HandlerTotalTicks   = 0;
+  }
+
+  gBS->RestoreTPL (OldTpl);
+
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  InterruptData->Iter = ((EFI_DT_CELL *)InterruptData->Iter) + Plic->InterruptCells;
+  *Cookie             = Entry;
+  return EFI_SUCCESS;
+}
+
+/**
+  Unregister handler for an interrupt.
+
+  @param This    Instance pointer for this protocol.
+  @param Cookie  As provided by EFI_DT_INTERRUPT_REGISTER callback.
+
+  @retval EFI_SUCCESS            Interrupt unregistered.
+  @retval EFI_INVALID_PARAMETER  Bad parameter.
+  @retval EFI_DEVICE_ERROR       Hardware could not be programmed.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+PlicUnregisterInterrupt (
+  IN  EFI_DT_INTERRUPT_PROTOCOL  *This,
+  IN  EFI_DT_INTERRUPT_COOKIE    Cookie
+  )
+{
+  EFI_TPL      OldTpl;
+  PLIC_DEVICE  *Plic;
+  PLIC_SOURCE  *Entry;
+
+  if (This == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Plic  = PLIC_DEVICE_FROM_DT_INTERRUPT (This);
+  Entry = PlicSourceFromCookie (Plic, Cookie);
+  if (Entry == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  OldTpl = gBS->RaiseTPL (TPL_HIGH_LEVEL);
+  PlicSourceReset (Plic, Entry->Source);
+  Entry->Handler       = NULL;
+  Entry->CookieContext = NULL;
+  gBS->RestoreTPL (OldTpl);
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Enable interrupt.
+
+  @param This    Instance pointer for this protocol.
+  @param Cookie  As provided by EFI_DT_INTERRUPT_REGISTER callback.
+
+  @retval EFI_SUCCESS            Interrupt enabled.
+  @retval EFI_UNSUPPORTED        Configuration not supported.
+  @retval EFI_INVALID_PARAMETER  Bad parameter.
+  @retval EFI_DEVICE_ERROR       Hardware could not be programmed.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+PlicEnableInterrupt (
+  IN  EFI_DT_INTERRUPT_PROTOCOL  *This,
+  IN  EFI_DT_INTERRUPT_COOKIE    Cookie
+  )
+{
+  PLIC_DEVICE  *Plic;
+  PLIC_SOURCE  *Entry;
+
+  if (This == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Plic  = PLIC_DEVICE_FROM_DT_INTERRUPT (This);
+  Entry = PlicSourceFromCookie (Plic, Cookie);
+  if (Entry == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  PlicSourceEnable (Plic, Entry->Source, TRUE);
+  return EFI_SUCCESS;
+}
+
+/**
+  Disable interrupt.
+
+  @param This     Instance pointer for this protocol
+  @param Cookie   As provided by EFI_DT_INTERRUPT_REGISTER callback.
+
+  @retval EFI_SUCCESS            Interrupt disabled.
+  @retval EFI_UNSUPPORTED        Configuration not supported.
+  @retval EFI_INVALID_PARAMETER  Bad parameter.
+  @retval EFI_DEVICE_ERROR       Hardware could not be programmed.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+PlicDisableInterrupt (
+  IN  EFI_DT_INTERRUPT_PROTOCOL  *This,
+  IN  EFI_DT_INTERRUPT_COOKIE    Cookie
+  )
+{
+  PLIC_DEVICE  *Plic;
+  PLIC_SOURCE  *Entry;
+
+  if (This == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Plic  = PLIC_DEVICE_FROM_DT_INTERRUPT (This);
+  Entry = PlicSourceFromCookie (Plic, Cookie);
+  if (Entry == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  PlicSourceEnable (Plic, Entry->Source, FALSE);
+  return EFI_SUCCESS;
+}
+
+/**
+  Get statistics for all registered interrupts.
+
+  @param This                 Instance pointer for this protocol.
+  @param Count                On input, the number of entries in Stats. On output,
+                              the number of registered interrupts.
+  @param Stats                Where to return the statistics.
+  @param UnhandledInterrupts  If not NULL, interrupts claimed for sources without a
+                              registered handler.
+
+  @retval EFI_SUCCESS            Success.
+  @retval EFI_BUFFER_TOO_SMALL   *Count updated with the number of entries required.
+  @retval EFI_INVALID_PARAMETER  Bad parameter.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+PlicGetStats (
+  IN  EFI_DT_INTERRUPT_STATS_PROTOCOL  *This,
+  IN  OUT UINTN                        *Count,
+  OUT EFI_DT_INTERRUPT_STATS           *Stats OPTIONAL,
+  OUT UINT64                           *UnhandledInterrupts OPTIONAL
+  )
+{
+  EFI_TPL                 OldTpl;
+  PLIC_DEVICE             *Plic;
+  PLIC_SOURCE             *Entry;
+  EFI_DT_INTERRUPT_STATS  *Stat;
+  UINT32                  Source;
+  UINTN                   Registered;
+
+  if ((This == NULL) || (Count == NULL) ||
+      ((*Count != 0) && (Stats == NULL)))
+  {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Plic       = PLIC_DEVICE_FROM_INTERRUPT_STATS (This);
+  Registered = 0;
+
+  //
+  // Snapshot with interrupts masked, so that each entry is consistent.
+  //
+  OldTpl = gBS->RaiseTPL (TPL_HIGH_LEVEL);
+  for (Source = 1; Source <= Plic->NumSources; Source++) {
+    Entry = &Plic->Sources[Source];
+    if (Entry->Handler == NULL) {
+      continue;
+    }
+
+    if (Registered < *Count) {
+      Stat                          = &Stats[Registered];
+      Stat->Cookie                  = Entry;
+      Stat->Source                  = Source;
+      Stat->Enabled                 = Entry->Enabled;
+      Stat->Interrupts              = Entry->Interrupts;
+      Stat->SpuriousClaims          = Entry->SpuriousClaims;
+      Stat->HandlerMinNs            = Entry->HandlerMinTicks;
+      Stat->HandlerMaxNs            = Entry->HandlerMaxTicks;
+      Stat->HandlerTotalNs          = Entry->HandlerTotalTicks;
+      Stat->FirstInterruptLatencyNs = Entry->FirstInterruptTicks;
+    }
+
+    Registered++;
+  }
+
+  if (UnhandledInterrupts != NULL) {
+    *UnhandledInterrupts = Plic->SpuriousInterrupts;
+  }
+
+  gBS->RestoreTPL (OldTpl);
+
+  //
+  // Convert outside of TPL_HIGH_LEVEL.
+  //
+  for (Source = 0; Source < MIN (Registered, *Count); Source++) {
+    Stat                          = &Stats[Source];
+    Stat->HandlerMinNs            = GetTimeInNanoSecond (Stat->HandlerMinNs);
+    Stat->HandlerMaxNs            = GetTimeInNanoSecond (Stat->HandlerMaxNs);
+    Stat->HandlerTotalNs          = GetTimeInNanoSecond (Stat->HandlerTotalNs);
+    Stat->FirstInterruptLatencyNs = GetTimeInNanoSecond (Stat->FirstInterruptLatencyNs);
+  }
+
+  if (Registered > *Count) {
+    *Count = Registered;
+    return EFI_BUFFER_TOO_SMALL;
+  }
+
+  *Count = Registered;
+  return EFI_SUCCESS;
+}
+
+/**
+  Reset interrupt statistics, except for the first interrupt latency,
+  which is only measured once per registration.
+
+  @param This            Instance pointer for this protocol.
+
+  @retval EFI_SUCCESS            Success.
+  @retval EFI_INVALID_PARAMETER  Bad parameter.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+PlicResetStats (
+  IN  EFI_DT_INTERRUPT_STATS_PROTOCOL  *This
+  )
+{
+  EFI_TPL      OldTpl;
+  PLIC_DEVICE  *Plic;
+  PLIC_SOURCE  *Entry;
+  UINT32       Source;
+
+  if (This == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Plic = PLIC_DEVICE_FROM_INTERRUPT_STATS (This);
+
+  OldTpl = gBS->RaiseTPL (TPL_HIGH_LEVEL);
+  for (Source = 1; Source <= Plic->NumSources; Source++) {
+    Entry                    = &Plic->Sources[Source];
+    Entry->Interrupts        = 0;
+    Entry->SpuriousClaims    = 0;
+    Entry->HandlerMinTicks   = 0;
+    Entry->HandlerMaxTicks   = 0;
+    Entry->HandlerTotalTicks = 0;
+  }
+
+  Plic->SpuriousInterrupts = 0;
+  gBS->RestoreTPL (OldTpl);
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Find the PLIC context (or APLIC IDC) that delivers supervisor
+  external interrupts to the boot hart.
+
+  Every interrupts-extended entry names a riscv,cpu-intc node and
+  the cause it raises, and its position is the context/IDC index.
+
+  @param  DtIo     EFI_DT_IO_PROTOCOL *.
+  @param  Context  Context/IDC index.
+
+  @retval EFI_SUCCESS    Success.
+  @retval EFI_NOT_FOUND  No context for supervisor mode on the boot hart.
+  @retval Other          Errors.
+
+**/
+STATIC
+EFI_STATUS
+PlicFindContext (
+  IN  EFI_DT_IO_PROTOCOL  *DtIo,
+  OUT UINT32              *Context
+  )
+{
+  EFI_STATUS               Status;
+  RISCV_EFI_BOOT_PROTOCOL  *RiscVBoot;
+  UINTN                    BootHartId;
+  EFI_DT_PROPERTY          Property;
+  EFI_HANDLE               IntcHandle;
+  EFI_DT_IO_PROTOCOL       *Intc;
+  EFI_DT_IO_PROTOCOL       *Cpu;
+  UINT32                   IntcCells;
+  UINT32                   Cause;
+  UINT32                   HartId;
+  UINT32                   Index;
+
+  Status = gBS->LocateProtocol (&gRiscVEfiBootProtocolGuid, NULL, (VOID **)&RiscVBoot);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "%a: LocateProtocol(RiscVEfiBootProtocolGuid): %r\n", __func__, Status));
+    return Status;
+  }
+
+  Status = RiscVBoot->GetBootHartId (RiscVBoot, &BootHartId);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "%a: GetBootHartId: %r\n", __func__, Status));
+    return Status;
+  }
+
+  Status = DtIo->GetProp (DtIo, "interrupts-extended", &Property);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "%a: GetProp(interrupts-extended): %r\n", __func__, Status));
+    return Status;
+  }
+
+  for (Index = 0; Property.Iter < Property.End; Index++) {
+    Status = DtIo->ParseProp (DtIo, &Property, EFI_DT_VALUE_DEVICE, 0, &IntcHandle);
+    if (EFI_ERROR (Status)) {
+      DEBUG ((DEBUG_ERROR, "%a: ParseProp(interrupts-extended): %r\n", __func__, Status));
+      return Status;
+    }
+
+    Status = gBS->HandleProtocol (IntcHandle, &gEfiDtIoProtocolGuid, (VOID **)&Intc);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    Status = Intc->GetU32 (Intc, "#interrupt-cells", 0, &IntcCells);
+    if (EFI_ERROR (Status) || (IntcCells == 0)) {
+      return EFI_DEVICE_ERROR;
+    }
+
+    Status = DtIo->ParseProp (DtIo, &Property, EFI_DT_VALUE_U32, 0, &Cause);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    Property.Iter = ((EFI_DT_CELL *)Property.Iter) + (IntcCells - 1);
+
+    if ((Cause != RISCV_INTC_SUPERVISOR_EXTERNAL) ||
+        (Intc->ParentDevice == NULL))
+    {
+      continue;
+    }
+
+    Status = gBS->HandleProtocol (Intc->ParentDevice, &gEfiDtIoProtocolGuid, (VOID **)&Cpu);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    Status = Cpu->GetU32 (Cpu, "reg", 0, &HartId);
+    if (EFI_ERROR (Status)) {
+      DEBUG ((DEBUG_ERROR, "%a: %a: GetU32(reg): %r\n", __func__, Cpu->Name, Status));
+      return Status;
+    }
+
+    if (HartId == BootHartId) {
+      *Context = Index;
+      return EFI_SUCCESS;
+    }
+  }
+
+  return EFI_NOT_FOUND;
+}
+
+/**
+  Bring the controller to a known state: everything masked, the boot hart
+  context/IDC accepting all priorities.
+
+  @param  Plic    PLIC_DEVICE *.
+
+**/
+STATIC
+VOID
+PlicHwInit (
+  IN  PLIC_DEVICE  *Plic
+  )
+{
+  UINT32  Source;
+
+  for (Source = 1; Source <= Plic->NumSources; Source++) {
+    PlicSourceReset (Plic, Source);
+  }
+
+  if (Plic->Type == PlicTypeAplic) {
+    PlicWrite32 (Plic, APLIC_IDC (Plic->Context) + APLIC_IDC_ITHRESHOLD, 0);
+    PlicWrite32 (Plic, APLIC_IDC (Plic->Context) + APLIC_IDC_IDELIVERY, 1);
+    PlicWrite32 (Plic, APLIC_DOMAINCFG, APLIC_DOMAINCFG_IE);
+  } else {
+    PlicWrite32 (Plic, PLIC_THRESHOLD (Plic->Context), 0);
+  }
+}
+
+/**
+  Mask all interrupts and stop delivery to the boot hart.
+
+  @param  Plic    PLIC_DEVICE *.
+
+**/
+STATIC
+VOID
+PlicHwDeinit (
+  IN  PLIC_DEVICE  *Plic
+  )
+{
+  UINT32  Source;
+
+  for (Source = 1; Source <= Plic->NumSources; Source++) {
+    PlicSourceReset (Plic, Source);
+  }
+
+  if (Plic->Type == PlicTypeAplic) {
+    PlicWrite32 (Plic, APLIC_IDC (Plic->Context) + APLIC_IDC_IDELIVERY, 0);
+  }
+}
+
+/**
+  Check if the device is a supported interrupt controller.
+
+  @param  DtIo    EFI_DT_IO_PROTOCOL *.
+
+  @retval EFI_SUCCESS      Supported.
+  @retval EFI_UNSUPPORTED  Not supported.
+
+**/
+EFI_STATUS
+PlicIsSupported (
+  IN  EFI_DT_IO_PROTOCOL  *DtIo
+  )
+{
+  UINTN            Index;
+  EFI_DT_PROPERTY  Property;
+
+  if (DtIo->DeviceStatus != EFI_DT_STATUS_OKAY) {
+    return EFI_UNSUPPORTED;
+  }
+
+  for (Index = 0; Index < ARRAY_SIZE (mPlicCompatibles); Index++) {
+    if (!EFI_ERROR (DtIo->IsCompatible (DtIo, mPlicCompatibles[Index]))) {
+      return EFI_SUCCESS;
+    }
+  }
+
+  if (!EFI_ERROR (DtIo->IsCompatible (DtIo, "riscv,aplic"))) {
+    //
+    // MSI delivery mode needs an IMSIC driver.
+    //
+    if (!EFI_ERROR (DtIo->GetProp (DtIo, "msi-parent", &Property))) {
+      return EFI_UNSUPPORTED;
+    }
+
+    return EFI_SUCCESS;
+  }
+
+  return EFI_UNSUPPORTED;
+}
+
+/**
+  Initialize the controller and start handling interrupts.
+
+  @param  DtIo     EFI_DT_IO_PROTOCOL *.
+  @param  OutPlic  PLIC_DEVICE **.
+
+  @retval EFI_SUCCESS  Success.
+  @retval Other        Errors.
+
+**/
+EFI_STATUS
+PlicStart (
+  IN  EFI_DT_IO_PROTOCOL  *DtIo,
+  OUT PLIC_DEVICE         **OutPlic
+  )
+{
+  EFI_STATUS            Status;
+  EFI_TPL               OldTpl;
+  EFI_DT_REG            Reg;
+  EFI_PHYSICAL_ADDRESS  Base;
+  PLIC_DEVICE           *Plic;
+  UINT32                Source;
+  UINT32                MaxSources;
+  CONST CHAR8           *NumSourcesProp;
+
+  Plic = AllocateZeroPool (sizeof (PLIC_DEVICE));
+  if (Plic == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Plic->Signature                       = PLIC_DEVICE_SIGNATURE;
+  Plic->DtIo                            = DtIo;
+  Plic->DtInterrupt.RegisterInterrupt   = PlicRegisterInterrupt;
+  Plic->DtInterrupt.UnregisterInterrupt = PlicUnregisterInterrupt;
+  Plic->DtInterrupt.EnableInterrupt     = PlicEnableInterrupt;
+  Plic->DtInterrupt.DisableInterrupt    = PlicDisableInterrupt;
+  Plic->InterruptStats.GetStats         = PlicGetStats;
+  Plic->InterruptStats.ResetStats       = PlicResetStats;
+
+  if (!EFI_ERROR (DtIo->IsCompatible (DtIo, "riscv,aplic"))) {
+    Plic->Type     = PlicTypeAplic;
+    NumSourcesProp = "riscv,num-sources";
+    MaxSources     = APLIC_MAX_SOURCES;
+  } else {
+    Plic->Type     = PlicTypePlic;
+    NumSourcesProp = "riscv,ndev";
+    MaxSources     = PLIC_MAX_SOURCES;
+  }
+
+  Status = DtIo->GetReg (DtIo, 0, &Reg);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "%a: GetReg: %r\n", __func__, Status));
+    goto out;
+  }
+
+  Status = FbpRegToPhysicalAddress (&Reg, &Base);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "%a: couldn't translate range to CPU addresses: %r\n", __func__, Status));
+    goto out;
+  }
+
+  Plic->Base = (UINTN)Base;
+
+  Status = DtIo->GetU32 (DtIo, NumSourcesProp, 0, &Plic->NumSources);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "%a: GetU32(%a): %r\n", __func__, NumSourcesProp, Status));
+    goto out;
+  }
+
+  if ((Plic->NumSources == 0) || (Plic->NumSources > MaxSources)) {
+    DEBUG ((DEBUG_ERROR, "%a: bad %a %u\n", __func__, NumSourcesProp, Plic->NumSources));
+    Status = EFI_DEVICE_ERROR;
+    goto out;
+  }
+
+  Status = DtIo->GetU32 (DtIo, "#interrupt-cells", 0, &Plic->InterruptCells);
+  if (EFI_ERROR (Status) || (Plic->InterruptCells == 0)) {
+    DEBUG ((DEBUG_ERROR, "%a: GetU32(#interrupt-cells): %r\n", __func__, Status));
+    Status = EFI_DEVICE_ERROR;
+    goto out;
+  }
+
+  Status = PlicFindContext (DtIo, &Plic->Context);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "%a: no supervisor context for the boot hart: %r\n", __func__, Status));
+    goto out;
+  }
+
+  //
+  // Source 0 is reserved ("no interrupt"), index by source number.
+  //
+  Plic->Sources = AllocateZeroPool ((Plic->NumSources + 1) * sizeof (PLIC_SOURCE));
+  if (Plic->Sources == NULL) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto out;
+  }
+
+  for (Source = 0; Source <= Plic->NumSources; Source++) {
+    Plic->Sources[Source].Signature = PLIC_SOURCE_SIGNATURE;
+    Plic->Sources[Source].Plic      = Plic;
+    Plic->Sources[Source].Source    = Source;
+  }
+
+  PlicHwInit (Plic);
+
+  OldTpl = gBS->RaiseTPL (TPL_HIGH_LEVEL);
+  if (IsListEmpty (&mPlics)) {
+    Status = mCpu->RegisterInterruptHandler (mCpu, EXCEPT_RISCV_IRQ_EXT_FROM_SMODE, PlicInterruptHandler);
+    if (EFI_ERROR (Status)) {
+      gBS->RestoreTPL (OldTpl);
+      DEBUG ((DEBUG_ERROR, "%a: RegisterInterruptHandler: %r\n", __func__, Status));
+      PlicHwDeinit (Plic);
+      goto out;
+    }
+
+    PlicEnableExternalInterrupt ();
+  }
+
+  InsertTailList (&mPlics, &Plic->Link);
+  gBS->RestoreTPL (OldTpl);
+
+  DEBUG ((
+    DEBUG_INFO,
+    "%a: %a: %u sources, context %u\n",
+    __func__,
+    DtIo->Name,
+    Plic->NumSources,
+    Plic->Context
+    ));
+
+  *OutPlic = Plic;
+
+out:
+  if (EFI_ERROR (Status)) {
+    if (Plic->Sources != NULL) {
+      FreePool (Plic->Sources);
+    }
+
+    FreePool (Plic);
+  }
+
+  return Status;
+}
+
+/**
+  Stop handling interrupts and free the controller.
+
+  @param  Plic    PLIC_DEVICE *.
+
+  @retval EFI_SUCCESS       Success.
+  @retval EFI_ACCESS_DENIED Interrupt handlers are still registered.
+
+**/
+EFI_STATUS
+PlicStop (
+  IN  PLIC_DEVICE  *Plic
+  )
+{
+  EFI_TPL  OldTpl;
+  UINT32   Source;
+
+  for (Source = 1; Source <= Plic->NumSources; Source++) {
+    if (Plic->Sources[Source].Handler != NULL) {
+      return EFI_ACCESS_DENIED;
+    }
+  }
+
+  OldTpl = gBS->RaiseTPL (TPL_HIGH_LEVEL);
+  PlicHwDeinit (Plic);
+  RemoveEntryList (&Plic->Link);
+  if (IsListEmpty (&mPlics)) {
+    PlicDisableExternalInterrupt ();
+    mCpu->RegisterInterruptHandler (mCpu, EXCEPT_RISCV_IRQ_EXT_FROM_SMODE, NULL);
+  }
+
+  gBS->RestoreTPL (OldTpl);
+
+  FreePool (Plic->Sources);
+  FreePool (Plic);
+  return EFI_SUCCESS;
+}
+
+/**
+  Mask all interrupt sources and stop taking supervisor external
+  interrupts, so none are delivered to the OS before it has set up
+  its own handling.
+
+  @param[in]  Event     Event whose notification function is being invoked.
+  @param[in]  Context   Unused.
+
+**/
+STATIC
+VOID
+EFIAPI
+PlicExitBootServices (
+  IN  EFI_EVENT  Event,
+  IN  VOID       *Context
+  )
+{
+  LIST_ENTRY   *Link;
+  PLIC_DEVICE  *Plic;
+
+  if (IsListEmpty (&mPlics)) {
+    return;
+  }
+
+  for (Link = GetFirstNode (&mPlics)
+       ; !IsNull (&mPlics, Link)
+       ; Link = GetNextNode (&mPlics, Link)
+       )
+  {
+    Plic = PLIC_DEVICE_FROM_LINK (Link);
+    PlicHwDeinit (Plic);
+  }
+
+  PlicDisableExternalInterrupt ();
+}
+
+/**
+  The Entry Point for RiscVPlicDxe driver.
+
+  @param[in] ImageHandle    The firmware allocated handle for the EFI image.
+  @param[in] SystemTable    A pointer to the EFI System Table.
+
+  @retval EFI_SUCCESS       The entry point is executed successfully.
+  @retval other             Some error occurs when executing this entry point.
+
+**/
+EFI_STATUS
+EFIAPI
+InitializeRiscVPlicDxe (
+  IN EFI_HANDLE        ImageHandle,
+  IN EFI_SYSTEM_TABLE  *SystemTable
+  )
+{
+  EFI_STATUS  Status;
+
+  Status = gBS->LocateProtocol (&gEfiCpuArchProtocolGuid, NULL, (VOID **)&mCpu);
+  ASSERT_EFI_ERROR (Status);
+
+  GetPerformanceCounterProperties (&mPerfStart, &mPerfEnd);
+  //
+  // TPL_CALLBACK, so this runs after the TPL_NOTIFY ExitBootServices
+  // notifications of device drivers have quiesced their devices.
+  //
+  Status = gBS->CreateEvent (
+                  EVT_SIGNAL_EXIT_BOOT_SERVICES,
+                  TPL_CALLBACK,
+                  PlicExitBootServices,
+                  NULL,
+                  &mExitBootServicesEvent
+                  );
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "%a: CreateEvent(ExitBootServices): %r\n", __func__, Status));
+    return Status;
+  }
+
+  return EfiLibInstallDriverBindingComponentName2 (
+           ImageHandle,
+           SystemTable,
+           &gDriverBinding,
+           ImageHandle,
+           &gComponentName,
+           &gComponentName2
+           );
+}
@@ -0,0 +1,170 @@
+/** @file
+    RISC-V PLIC and APLIC interrupt controller driver.
+
+    Copyright (c) 2024, Intel Corporation. All rights reserved.<BR>
+
+    SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef __RISCV_PLIC_DXE_H__
+#define __RISCV_PLIC_DXE_H__
+
+#include <Uefi.h>
+#include <Library/UefiLib.h>
+#include <Library/BaseLib.h>
+#include <Library/DebugLib.h>
+#include <Library/IoLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/TimerLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/UefiDriverEntryPoint.h>
+#include <Library/FbpUtilsLib.h>
+
+#include <Protocol/Cpu.h>
+#include <Protocol/DtIo.h>
+#include <Protocol/DtInterrupt.h>
+#include <Protocol/DtInterruptStats.h>
+#include <Protocol/RiscVBootProtocol.h>
+
+//
+// EFI_EXCEPTION_TYPE of the supervisor external interrupt (scause 9).
+// Not all MdePkg versions define this.
+//
+#ifndef EXCEPT_RISCV_IRQ_EXT_FROM_SMODE
+#define EXCEPT_RISCV_IRQ_EXT_FROM_SMODE  0x80000009
+#endif
+
+//
+// Cause reported by riscv,cpu-intc for supervisor external interrupts.
+//
+#define RISCV_INTC_SUPERVISOR_EXTERNAL  9
+
+//
+// PLIC (sifive,plic-1.0.0) register layout.
+//
+#define PLIC_PRIORITY(Source)       (0x0 + (Source) * 4)
+#define PLIC_ENABLE(Context)        (0x2000 + (Context) * 0x80)
+#define PLIC_THRESHOLD(Context)     (0x200000 + (Context) * 0x1000)
+#define PLIC_CLAIM(Context)         (0x200004 + (Context) * 0x1000)
+#define PLIC_MAX_SOURCES            1023
+#define PLIC_DEFAULT_PRIORITY       1
+
+//
+// APLIC (riscv,aplic) register layout, direct delivery mode only.
+//
+#define APLIC_DOMAINCFG             0x0
+#define APLIC_DOMAINCFG_IE          BIT8
+#define APLIC_DOMAINCFG_DM          BIT2
+#define APLIC_SOURCECFG(Source)     (0x4 + ((Source) - 1) * 4)
+#define APLIC_SOURCECFG_D           BIT10
+#define APLIC_SM_INACTIVE           0
+#define APLIC_SM_EDGE_RISE          4
+#define APLIC_SM_EDGE_FALL          5
+#define APLIC_SM_LEVEL_HIGH         6
+#define APLIC_SM_LEVEL_LOW          7
+#define APLIC_SETIENUM              0x1edc
+#define APLIC_CLRIENUM              0x1fdc
+#define APLIC_TARGET(Source)        (0x3004 + ((Source) - 1) * 4)
+#define APLIC_TARGET_HART_SHIFT     18
+#define APLIC_IDC(Hart)             (0x4000 + (Hart) * 32)
+#define APLIC_IDC_IDELIVERY         0x0
+#define APLIC_IDC_ITHRESHOLD        0x8
+#define APLIC_IDC_CLAIMI            0x1c
+#define APLIC_IDC_CLAIMI_SHIFT      16
+#define APLIC_MAX_SOURCES           1023
+#define APLIC_DEFAULT_PRIORITY      1
+
+//
+// Linux-style IRQ_TYPE flags used in APLIC interrupt specifiers.
+//
+#define IRQ_TYPE_EDGE_RISING   1
+#define IRQ_TYPE_EDGE_FALLING  2
+#define IRQ_TYPE_LEVEL_HIGH    4
+#define IRQ_TYPE_LEVEL_LOW     8
+
+typedef enum {
+  PlicTypePlic,
+  PlicTypeAplic
+} PLIC_TYPE;
+
+typedef struct _PLIC_DEVICE PLIC_DEVICE;
+
+typedef struct {
+  UINT32                      Signature;
+  PLIC_DEVICE                 *Plic;
+  UINT32                      Source;
+  EFI_DT_INTERRUPT_HANDLER    Handler;
+  VOID                        *CookieContext;
+  BOOLEAN                     Enabled;
+  //
+  // Statistics, in performance counter ticks.
+  //
+  UINT64                      RegisterTick;
+  UINT64                      FirstInterruptTicks;
+  UINT64                      Interrupts;
+  UINT64                      SpuriousClaims;
+  UINT64                      HandlerMinTicks;
+  UINT64                      HandlerMaxTicks;
+  UINT64                      HandlerTotalTicks;
+} PLIC_SOURCE;
+
+#define PLIC_SOURCE_SIGNATURE  SIGNATURE_32 ('p', 'l', 'c', 's')
+
+struct _PLIC_DEVICE {
+  UINT32                             Signature;
+  LIST_ENTRY                         Link;
+  EFI_DT_INTERRUPT_PROTOCOL          DtInterrupt;
+  EFI_DT_INTERRUPT_STATS_PROTOCOL    InterruptStats;
+  EFI_DT_IO_PROTOCOL                 *DtIo;
+  PLIC_TYPE                          Type;
+  UINTN                              Base;
+  UINT32                             InterruptCells;
+  //
+  // PLIC context or APLIC interrupt delivery control (IDC)
+  // index for supervisor mode on the boot hart.
+  //
+  UINT32                             Context;
+  UINT32                             NumSources;
+  UINT64                             SpuriousInterrupts;
+  PLIC_SOURCE                        *Sources;
+};
+
+#define PLIC_DEVICE_SIGNATURE  SIGNATURE_32 ('p', 'l', 'i', 'c')
+#define PLIC_DEVICE_FROM_LINK(a)         CR (a, PLIC_DEVICE, Link, PLIC_DEVICE_SIGNATURE)
+#define PLIC_DEVICE_FROM_DT_INTERRUPT(a)  CR (a, PLIC_DEVICE, DtInterrupt, PLIC_DEVICE_SIGNATURE)
+#define PLIC_DEVICE_FROM_INTERRUPT_STATS(a)  CR (a, PLIC_DEVICE, InterruptStats, PLIC_DEVICE_SIGNATURE)
+
+extern EFI_COMPONENT_NAME_PROTOCOL   gComponentName;
+extern EFI_COMPONENT_NAME2_PROTOCOL  gComponentName2;
+extern EFI_DRIVER_BINDING_PROTOCOL   gDriverBinding;
+
+EFI_STATUS
+PlicIsSupported (
+  IN  EFI_DT_IO_PROTOCOL  *DtIo
+  );
+
+EFI_STATUS
+PlicStart (
+  IN  EFI_DT_IO_PROTOCOL  *DtIo,
+  OUT PLIC_DEVICE         **OutPlic
+  );
+
+EFI_STATUS
+PlicStop (
+  IN  PLIC_DEVICE  *Plic
+  );
+
+VOID
+EFIAPI
+PlicEnableExternalInterrupt (
+  VOID
+  );
+
+VOID
+EFIAPI
+PlicDisableExternalInterrupt (
+  VOID
+  );
+
+#endif /* __RISCV_PLIC_DXE_H__ */
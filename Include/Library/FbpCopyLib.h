@@ -0,0 +1,36 @@
+/** @file
+
+    Copyright (c) 2024, Intel Corporation. All rights reserved.<BR>
+
+    SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef __FBP_COPY_LIB_H__
+#define __FBP_COPY_LIB_H__
+
+#include <Base.h>
+
+//
+// Like CopyMem and ZeroMem, but using the widest load/store units
+// available at runtime (RISC-V V, AArch64 Advanced SIMD), falling back
+// to 64-bit scalar accesses. Meant for bulk copies to and from normal
+// (cacheable) memory, e.g. DMA bounce buffers. Overlapping buffers are
+// handled, but go through CopyMem.
+//
+VOID *
+EFIAPI
+FbpCopyMem (
+  OUT VOID        *Destination,
+  IN  CONST VOID  *Source,
+  IN  UINTN       Length
+  );
+
+VOID *
+EFIAPI
+FbpZeroMem (
+  OUT VOID   *Buffer,
+  IN  UINTN  Length
+  );
+
+#endif /* __FBP_COPY_LIB_H__ */
@@ -28,4 +28,35 @@ FbpInterruptGet (
   OUT EFI_DT_PROPERTY     *Interrupt
   );
 
+//
+// Deferred work, for keeping EFI_DT_INTERRUPT_HANDLER short. Work queued
+// (possibly several times) from an interrupt handler runs once, at
+// TPL_CALLBACK, with Count set to the number of times it was queued.
+//
+typedef struct _FBP_DEFERRED_WORK FBP_DEFERRED_WORK;
+
+typedef
+VOID
+(EFIAPI *FBP_DEFERRED_WORK_FUNCTION)(
+  IN  VOID   *Context,
+  IN  UINTN  Count
+  );
+
+EFI_STATUS
+FbpDeferredWorkCreate (
+  IN  FBP_DEFERRED_WORK_FUNCTION  Function,
+  IN  VOID                        *Context,
+  OUT FBP_DEFERRED_WORK           **Work
+  );
+
+VOID
+FbpDeferredWorkQueue (
+  IN  FBP_DEFERRED_WORK  *Work
+  );
+
+VOID
+FbpDeferredWorkDestroy (
+  IN  FBP_DEFERRED_WORK  *Work
+  );
+
 #endif /* __FBP_INTERRUPT_UTILS_LIB_H__ */
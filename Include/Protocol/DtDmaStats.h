@@ -0,0 +1,110 @@
+/** @file
+    EFI Devicetree DMA Statistics Protocol reports DMA mapping and
+    buffer allocation counters for a device, and is installed by
+    the bus driver alongside EFI_DT_IO_PROTOCOL.
+
+    Copyright (c) 2024, Intel Corporation. All rights reserved.<BR>
+
+    SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef __DT_DMA_STATS_H__
+#define __DT_DMA_STATS_H__
+
+#define EFI_DT_DMA_STATS_PROTOCOL_GUID \
+  { \
+    0x5ce5a2b0, 0x2838, 0x3c35, {0x1e, 0xe3, 0x42, 0x5e, 0x36, 0x50, 0xa4, 0x9d } \
+  }
+
+typedef struct _EFI_DT_DMA_STATS_PROTOCOL  EFI_DT_DMA_STATS_PROTOCOL;
+
+typedef struct {
+  //
+  // Successful Map() and Unmap() calls.
+  //
+  UINT64    MapCalls;
+  UINT64    UnmapCalls;
+  //
+  // Map() calls satisfied with the caller's buffer vs. those that
+  // needed a bounce buffer.
+  //
+  UINT64    ZeroCopyMaps;
+  UINT64    BouncedMaps;
+  //
+  // Bytes copied into bounce buffers on Map() (BusMasterRead), and
+  // out of bounce buffers on Unmap() (BusMasterWrite).
+  //
+  UINT64    BytesBouncedToDevice;
+  UINT64    BytesBouncedFromDevice;
+  //
+  // Time spent in bounce copies, in nanoseconds.
+  //
+  UINT64    BounceCopyNs;
+  //
+  // Mappings not yet unmapped, and the high-water mark.
+  //
+  UINT64    OutstandingMaps;
+  UINT64    PeakOutstandingMaps;
+  //
+  // Successful AllocateBuffer() calls, total pages allocated through
+  // them, and pages not yet released with FreeBuffer().
+  //
+  UINT64    AllocateBufferCalls;
+  UINT64    AllocateBufferPages;
+  UINT64    OutstandingBufferPages;
+  //
+  // Bounced Map() calls that reused cached bounce pages instead
+  // of allocating new ones.
+  //
+  UINT64    BounceCacheHits;
+  //
+  // Successful AllocatePoolBuffer() calls, and buffers not yet
+  // released with FreePoolBuffer().
+  //
+  UINT64    AllocatePoolBufferCalls;
+  UINT64    OutstandingPoolBuffers;
+} EFI_DT_DMA_STATS;
+
+/**
+  Get DMA statistics for the device.
+
+  @param This            Instance pointer for this protocol.
+  @param Stats           Where to return the statistics.
+
+  @retval EFI_SUCCESS            Success.
+  @retval EFI_INVALID_PARAMETER  Bad parameter.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *EFI_DT_DMA_STATS_GET)(
+  IN  EFI_DT_DMA_STATS_PROTOCOL *This,
+  OUT EFI_DT_DMA_STATS          *Stats
+  );
+
+/**
+  Reset DMA statistics for the device. Outstanding mapping, page and
+  pool buffer counts reflect live state and are not reset. The peak is
+  reset to the current number of outstanding mappings.
+
+  @param This            Instance pointer for this protocol.
+
+  @retval EFI_SUCCESS            Success.
+  @retval EFI_INVALID_PARAMETER  Bad parameter.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *EFI_DT_DMA_STATS_RESET)(
+  IN  EFI_DT_DMA_STATS_PROTOCOL *This
+  );
+
+struct _EFI_DT_DMA_STATS_PROTOCOL {
+  EFI_DT_DMA_STATS_GET      GetStats;
+  EFI_DT_DMA_STATS_RESET    ResetStats;
+};
+
+extern EFI_GUID  gEfiDtDmaStatsProtocolGuid;
+
+#endif /* __DT_DMA_STATS_H__ */
@@ -0,0 +1,104 @@
+/** @file
+    EFI Devicetree Interrupt Statistics Protocol reports per-handler
+    interrupt counters, and is installed by interrupt controller drivers
+    alongside EFI_DT_INTERRUPT_PROTOCOL.
+
+    Copyright (c) 2024, Intel Corporation. All rights reserved.<BR>
+
+    SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef __DT_INTERRUPT_STATS_H__
+#define __DT_INTERRUPT_STATS_H__
+
+#include <Protocol/DtInterrupt.h>
+
+#define EFI_DT_INTERRUPT_STATS_PROTOCOL_GUID \
+  { \
+    0x5ce5a2b0, 0x2838, 0x3c35, {0x1e, 0xe3, 0x42, 0x5e, 0x36, 0x50, 0xa5, 0x9e } \
+  }
+
+typedef struct _EFI_DT_INTERRUPT_STATS_PROTOCOL  EFI_DT_INTERRUPT_STATS_PROTOCOL;
+
+typedef struct {
+  //
+  // As returned by EFI_DT_INTERRUPT_REGISTER.
+  //
+  EFI_DT_INTERRUPT_COOKIE    Cookie;
+  //
+  // Controller-specific interrupt number.
+  //
+  UINT64                     Source;
+  BOOLEAN                    Enabled;
+  //
+  // Handler invocations.
+  //
+  UINT64                     Interrupts;
+  //
+  // Interrupts claimed while disabled, which were not
+  // passed to the handler.
+  //
+  UINT64                     SpuriousClaims;
+  //
+  // Time spent in the handler, in nanoseconds. The average is
+  // HandlerTotalNs / Interrupts.
+  //
+  UINT64                     HandlerMinNs;
+  UINT64                     HandlerMaxNs;
+  UINT64                     HandlerTotalNs;
+  //
+  // Time from registration to the first interrupt, in nanoseconds,
+  // or 0 if there hasn't been one yet.
+  //
+  UINT64                     FirstInterruptLatencyNs;
+} EFI_DT_INTERRUPT_STATS;
+
+/**
+  Get statistics for all registered interrupts.
+
+  @param This                 Instance pointer for this protocol.
+  @param Count                On input, the number of entries in Stats. On output,
+                              the number of registered interrupts.
+  @param Stats                Where to return the statistics.
+  @param UnhandledInterrupts  If not NULL, interrupts claimed for sources without a
+                              registered handler.
+
+  @retval EFI_SUCCESS            Success.
+  @retval EFI_BUFFER_TOO_SMALL   *Count updated with the number of entries required.
+  @retval EFI_INVALID_PARAMETER  Bad parameter.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *EFI_DT_INTERRUPT_STATS_GET)(
+  IN  EFI_DT_INTERRUPT_STATS_PROTOCOL *This,
+  IN  OUT UINTN                       *Count,
+  OUT EFI_DT_INTERRUPT_STATS          *Stats OPTIONAL,
+  OUT UINT64                          *UnhandledInterrupts OPTIONAL
+  );
+
+/**
+  Reset interrupt statistics, except for the first interrupt latency,
+  which is only measured once per registration.
+
+  @param This            Instance pointer for this protocol.
+
+  @retval EFI_SUCCESS            Success.
+  @retval EFI_INVALID_PARAMETER  Bad parameter.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *EFI_DT_INTERRUPT_STATS_RESET)(
+  IN  EFI_DT_INTERRUPT_STATS_PROTOCOL *This
+  );
+
+struct _EFI_DT_INTERRUPT_STATS_PROTOCOL {
+  EFI_DT_INTERRUPT_STATS_GET      GetStats;
+  EFI_DT_INTERRUPT_STATS_RESET    ResetStats;
+};
+
+extern EFI_GUID  gEfiDtInterruptStatsProtocolGuid;
+
+#endif /* __DT_INTERRUPT_STATS_H__ */
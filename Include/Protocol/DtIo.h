@@ -822,6 +822,62 @@ EFI_STATUS
   IN  VOID                         *HostAddress
   );
 
+/**
+  Allocates a buffer smaller than a page that is suitable for an
+  EfiDtIoDmaOperationBusMasterCommonBuffer mapping.
+
+  Small buffers are carved out of pages shared with other allocations
+  made under the same DMA constraints. The returned buffer is aligned
+  to at least the smallest power of 2 that is not less than Size (or
+  Alignment, if larger). Requests larger than half a page, or requiring
+  page alignment, are satisfied with whole pages, just like AllocateBuffer().
+
+  @param  This                  A pointer to the EFI_DT_IO_PROTOCOL instance.
+  @param  MemoryType            The type of memory to allocate, EfiBootServicesData or
+                                EfiRuntimeServicesData.
+  @param  Size                  The number of bytes to allocate (> 0).
+  @param  Alignment             Required alignment (power of 2 <= EFI_PAGE_SIZE, or 0).
+  @param  ExtraConstraints      Additional optional DMA constraints.
+  @param  HostAddress           A pointer to store the base system memory address of the
+                                allocated buffer.
+
+  @retval EFI_SUCCESS           The requested buffer was allocated.
+  @retval EFI_INVALID_PARAMETER One or more parameters are invalid.
+  @retval EFI_OUT_OF_RESOURCES  The buffer could not be allocated.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *EFI_DT_IO_PROTOCOL_ALLOCATE_POOL_BUFFER)(
+  IN  EFI_DT_IO_PROTOCOL           *This,
+  IN  EFI_MEMORY_TYPE              MemoryType,
+  IN  UINTN                        Size,
+  IN  UINTN                        Alignment,
+  IN  EFI_DT_IO_PROTOCOL_DMA_EXTRA *ExtraConstraints OPTIONAL,
+  OUT VOID                         **HostAddress
+  );
+
+/**
+  Frees memory that was allocated with AllocatePoolBuffer().
+
+  @param  This                  A pointer to the EFI_DT_IO_PROTOCOL instance.
+  @param  Size                  The number of bytes passed to AllocatePoolBuffer().
+  @param  HostAddress           The base system memory address of the allocated buffer.
+
+  @retval EFI_SUCCESS           The requested buffer was freed.
+  @retval EFI_INVALID_PARAMETER One or more parameters are invalid.
+  @retval EFI_NOT_FOUND         The buffer specified by HostAddress and Size
+                                was not allocated with AllocatePoolBuffer().
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *EFI_DT_IO_PROTOCOL_FREE_POOL_BUFFER)(
+  IN  EFI_DT_IO_PROTOCOL           *This,
+  IN  UINTN                        Size,
+  IN  VOID                         *HostAddress
+  );
+
 /**
   Sets device driver callbacks to be used by the bus driver.
 
@@ -879,53 +935,55 @@ struct _EFI_DT_IO_PROTOCOL {
   // it mostly useful (EFI_COMPONENT_NAME_PROTOCOL) is missing
   // CONST qualifier in ComponentNameGetControllerName arg.
   //
-  CHAR16                                 *ComponentName;
+  CHAR16                                   *ComponentName;
   CONST CHAR8                            *Name;
   CONST CHAR8                            *DeviceType;
-  EFI_DT_STATUS                          DeviceStatus;
-  UINT8                                  AddressCells;
-  UINT8                                  SizeCells;
-  UINT8                                  ChildAddressCells;
-  UINT8                                  ChildSizeCells;
-  BOOLEAN                                IsDmaCoherent;
-  EFI_HANDLE                             ParentDevice;
+  EFI_DT_STATUS                            DeviceStatus;
+  UINT8                                    AddressCells;
+  UINT8                                    SizeCells;
+  UINT8                                    ChildAddressCells;
+  UINT8                                    ChildSizeCells;
+  BOOLEAN                                  IsDmaCoherent;
+  EFI_HANDLE                               ParentDevice;
   //
   // Core.
   //
-  EFI_DT_IO_PROTOCOL_LOOKUP              Lookup;
-  EFI_DT_IO_PROTOCOL_GET_PROP            GetProp;
-  EFI_DT_IO_PROTOCOL_SCAN_CHILDREN       ScanChildren;
-  EFI_DT_IO_PROTOCOL_REMOVE_CHILD        RemoveChild;
-  EFI_DT_IO_PROTOCOL_SET_CALLBACKS       SetCallbacks;
+  EFI_DT_IO_PROTOCOL_LOOKUP                Lookup;
+  EFI_DT_IO_PROTOCOL_GET_PROP              GetProp;
+  EFI_DT_IO_PROTOCOL_SCAN_CHILDREN         ScanChildren;
+  EFI_DT_IO_PROTOCOL_REMOVE_CHILD          RemoveChild;
+  EFI_DT_IO_PROTOCOL_SET_CALLBACKS         SetCallbacks;
   //
   // Convenience calls to use with or instead of GetProp.
   //
-  EFI_DT_IO_PROTOCOL_PARSE_PROP          ParseProp;
-  EFI_DT_IO_PROTOCOL_GET_STRING_INDEX    GetStringIndex;
-  EFI_DT_IO_PROTOCOL_GET_U32             GetU32;
-  EFI_DT_IO_PROTOCOL_GET_U64             GetU64;
-  EFI_DT_IO_PROTOCOL_GET_U128            GetU128;
-  EFI_DT_IO_PROTOCOL_GET_REG             GetReg;
-  EFI_DT_IO_PROTOCOL_GET_REG_BY_NAME     GetRegByName;
-  EFI_DT_IO_PROTOCOL_GET_RANGE           GetRange;
-  EFI_DT_IO_PROTOCOL_GET_STRING          GetString;
-  EFI_DT_IO_PROTOCOL_GET_DEVICE          GetDevice;
-  EFI_DT_IO_PROTOCOL_IS_COMPATIBLE       IsCompatible;
+  EFI_DT_IO_PROTOCOL_PARSE_PROP            ParseProp;
+  EFI_DT_IO_PROTOCOL_GET_STRING_INDEX      GetStringIndex;
+  EFI_DT_IO_PROTOCOL_GET_U32               GetU32;
+  EFI_DT_IO_PROTOCOL_GET_U64               GetU64;
+  EFI_DT_IO_PROTOCOL_GET_U128              GetU128;
+  EFI_DT_IO_PROTOCOL_GET_REG               GetReg;
+  EFI_DT_IO_PROTOCOL_GET_REG_BY_NAME       GetRegByName;
+  EFI_DT_IO_PROTOCOL_GET_RANGE             GetRange;
+  EFI_DT_IO_PROTOCOL_GET_STRING            GetString;
+  EFI_DT_IO_PROTOCOL_GET_DEVICE            GetDevice;
+  EFI_DT_IO_PROTOCOL_IS_COMPATIBLE         IsCompatible;
   //
   // Device register access.
   //
-  EFI_DT_IO_PROTOCOL_POLL_REG            PollReg;
-  EFI_DT_IO_PROTOCOL_IO_REG              ReadReg;
-  EFI_DT_IO_PROTOCOL_IO_REG              WriteReg;
-  EFI_DT_IO_PROTOCOL_COPY_REG            CopyReg;
-  EFI_DT_IO_PROTOCOL_SET_REG_TYPE        SetRegType;
+  EFI_DT_IO_PROTOCOL_POLL_REG              PollReg;
+  EFI_DT_IO_PROTOCOL_IO_REG                ReadReg;
+  EFI_DT_IO_PROTOCOL_IO_REG                WriteReg;
+  EFI_DT_IO_PROTOCOL_COPY_REG              CopyReg;
+  EFI_DT_IO_PROTOCOL_SET_REG_TYPE          SetRegType;
   //
   // DMA operations.
   //
-  EFI_DT_IO_PROTOCOL_MAP                 Map;
-  EFI_DT_IO_PROTOCOL_UNMAP               Unmap;
-  EFI_DT_IO_PROTOCOL_ALLOCATE_BUFFER     AllocateBuffer;
-  EFI_DT_IO_PROTOCOL_FREE_BUFFER         FreeBuffer;
+  EFI_DT_IO_PROTOCOL_MAP                   Map;
+  EFI_DT_IO_PROTOCOL_UNMAP                 Unmap;
+  EFI_DT_IO_PROTOCOL_ALLOCATE_BUFFER       AllocateBuffer;
+  EFI_DT_IO_PROTOCOL_FREE_BUFFER           FreeBuffer;
+  EFI_DT_IO_PROTOCOL_ALLOCATE_POOL_BUFFER  AllocatePoolBuffer;
+  EFI_DT_IO_PROTOCOL_FREE_POOL_BUFFER      FreePoolBuffer;
 };
 
 extern EFI_GUID  gEfiDtIoProtocolGuid;
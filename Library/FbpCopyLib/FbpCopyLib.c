@@ -0,0 +1,303 @@
+/** @file
+
+    Copyright (c) 2024, Intel Corporation. All rights reserved.<BR>
+
+    SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/FbpCopyLib.h>
+#include "FbpCopyLibInternal.h"
+
+#if defined (MDE_CPU_RISCV64) || defined (MDE_CPU_AARCH64)
+  #define HAVE_VECTOR_KERNELS
+#endif
+
+STATIC BOOLEAN  mHaveVector;
+
+#ifdef HAVE_VECTOR_KERNELS
+
+/**
+  Copies using the vector kernel.
+
+  On RISC-V, neither the exception entry code nor the kernels preserve
+  the V registers, vtype and vl, so a kernel interrupted by another
+  user of FbpCopyLib (e.g. from an event notification) would be
+  corrupted. The kernel is thus run with interrupts disabled, in
+  chunks of FBP_COPY_VECTOR_CHUNK bytes. On AArch64 the exception
+  entry code saves and restores the SIMD registers.
+
+  @param[out] Destination    Destination buffer.
+  @param[in]  Source         Source buffer.
+  @param[in]  Length         Bytes to copy.
+
+**/
+STATIC
+VOID
+InternalCopyVectorChunked (
+  OUT UINT8        *Destination,
+  IN  CONST UINT8  *Source,
+  IN  UINTN        Length
+  )
+{
+ #ifdef MDE_CPU_RISCV64
+  BOOLEAN  InterruptState;
+  UINTN    Chunk;
+
+  while (Length != 0) {
+    Chunk          = MIN (Length, FBP_COPY_VECTOR_CHUNK);
+    InterruptState = SaveAndDisableInterrupts ();
+    InternalCopyVector (Destination, Source, Chunk);
+    SetInterruptState (InterruptState);
+    Destination += Chunk;
+    Source      += Chunk;
+    Length      -= Chunk;
+  }
+
+ #else
+  InternalCopyVector (Destination, Source, Length);
+ #endif /* MDE_CPU_RISCV64 */
+}
+
+/**
+  Zeroes using the vector kernel. See InternalCopyVectorChunked.
+
+  @param[out] Buffer         Buffer to zero.
+  @param[in]  Length         Bytes to zero.
+
+**/
+STATIC
+VOID
+InternalZeroVectorChunked (
+  OUT UINT8  *Buffer,
+  IN  UINTN  Length
+  )
+{
+ #ifdef MDE_CPU_RISCV64
+  BOOLEAN  InterruptState;
+  UINTN    Chunk;
+
+  while (Length != 0) {
+    Chunk          = MIN (Length, FBP_COPY_VECTOR_CHUNK);
+    InterruptState = SaveAndDisableInterrupts ();
+    InternalZeroVector (Buffer, Chunk);
+    SetInterruptState (InterruptState);
+    Buffer += Chunk;
+    Length -= Chunk;
+  }
+
+ #else
+  InternalZeroVector (Buffer, Length);
+ #endif /* MDE_CPU_RISCV64 */
+}
+
+#endif /* HAVE_VECTOR_KERNELS */
+
+/**
+  Copies with 64-bit accesses where Destination and Source share
+  the same 8-byte alignment, and byte accesses otherwise.
+
+  @param[out] Destination    Destination buffer.
+  @param[in]  Source         Source buffer.
+  @param[in]  Length         Bytes to copy.
+
+**/
+STATIC
+VOID
+InternalCopyScalar (
+  OUT UINT8        *Destination,
+  IN  CONST UINT8  *Source,
+  IN  UINTN        Length
+  )
+{
+  UINT64        *Destination64;
+  CONST UINT64  *Source64;
+
+  if ((((UINTN)Destination ^ (UINTN)Source) & (sizeof (UINT64) - 1)) == 0) {
+    while ((((UINTN)Destination & (sizeof (UINT64) - 1)) != 0) && (Length != 0)) {
+      *(Destination++) = *(Source++);
+      Length--;
+    }
+
+    Destination64 = (UINT64 *)Destination;
+    Source64      = (CONST UINT64 *)Source;
+    while (Length >= 4 * sizeof (UINT64)) {
+      Destination64[0] = Source64[0];
+      Destination64[1] = Source64[1];
+      Destination64[2] = Source64[2];
+      Destination64[3] = Source64[3];
+      Destination64   += 4;
+      Source64        += 4;
+      Length          -= 4 * sizeof (UINT64);
+    }
+
+    while (Length >= sizeof (UINT64)) {
+      *(Destination64++) = *(Source64++);
+      Length            -= sizeof (UINT64);
+    }
+
+    Destination = (UINT8 *)Destination64;
+    Source      = (CONST UINT8 *)Source64;
+  }
+
+  while (Length-- != 0) {
+    *(Destination++) = *(Source++);
+  }
+}
+
+/**
+  Zeroes with 64-bit accesses after aligning Buffer.
+
+  @param[out] Buffer         Buffer to zero.
+  @param[in]  Length         Bytes to zero.
+
+**/
+STATIC
+VOID
+InternalZeroScalar (
+  OUT UINT8  *Buffer,
+  IN  UINTN  Length
+  )
+{
+  UINT64  *Buffer64;
+
+  while ((((UINTN)Buffer & (sizeof (UINT64) - 1)) != 0) && (Length != 0)) {
+    *(Buffer++) = 0;
+    Length--;
+  }
+
+  Buffer64 = (UINT64 *)Buffer;
+  while (Length >= 4 * sizeof (UINT64)) {
+    Buffer64[0] = 0;
+    Buffer64[1] = 0;
+    Buffer64[2] = 0;
+    Buffer64[3] = 0;
+    Buffer64   += 4;
+    Length     -= 4 * sizeof (UINT64);
+  }
+
+  while (Length >= sizeof (UINT64)) {
+    *(Buffer64++) = 0;
+    Length       -= sizeof (UINT64);
+  }
+
+  Buffer = (UINT8 *)Buffer64;
+  while (Length-- != 0) {
+    *(Buffer++) = 0;
+  }
+}
+
+/**
+  Copies Length bytes from Source to Destination, using vector
+  loads/stores when the CPU supports them.
+
+  @param[out] Destination    Destination buffer.
+  @param[in]  Source         Source buffer.
+  @param[in]  Length         Bytes to copy.
+
+  @retval Destination.
+
+**/
+VOID *
+EFIAPI
+FbpCopyMem (
+  OUT VOID        *Destination,
+  IN  CONST VOID  *Source,
+  IN  UINTN       Length
+  )
+{
+  UINTN  Dest;
+  UINTN  Src;
+
+  if ((Length == 0) || (Destination == Source)) {
+    return Destination;
+  }
+
+  ASSERT ((Length - 1) <= (MAX_ADDRESS - (UINTN)Destination));
+  ASSERT ((Length - 1) <= (MAX_ADDRESS - (UINTN)Source));
+
+  Dest = (UINTN)Destination;
+  Src  = (UINTN)Source;
+  if (((Dest - Src) < Length) || ((Src - Dest) < Length)) {
+    //
+    // Overlap. Leave direction handling to BaseMemoryLib.
+    //
+    return CopyMem (Destination, Source, Length);
+  }
+
+ #ifdef HAVE_VECTOR_KERNELS
+  if ((Length >= FBP_COPY_VECTOR_MIN) && mHaveVector) {
+    InternalCopyVectorChunked (Destination, Source, Length);
+    return Destination;
+  }
+
+ #endif /* HAVE_VECTOR_KERNELS */
+
+  InternalCopyScalar (Destination, Source, Length);
+  return Destination;
+}
+
+/**
+  Zeroes Length bytes of Buffer, using vector stores when the CPU
+  supports them.
+
+  @param[out] Buffer         Buffer to zero.
+  @param[in]  Length         Bytes to zero.
+
+  @retval Buffer.
+
+**/
+VOID *
+EFIAPI
+FbpZeroMem (
+  OUT VOID   *Buffer,
+  IN  UINTN  Length
+  )
+{
+  if (Length == 0) {
+    return Buffer;
+  }
+
+  ASSERT (Buffer != NULL);
+  ASSERT ((Length - 1) <= (MAX_ADDRESS - (UINTN)Buffer));
+
+ #ifdef HAVE_VECTOR_KERNELS
+  if ((Length >= FBP_COPY_VECTOR_MIN) && mHaveVector) {
+    InternalZeroVectorChunked (Buffer, Length);
+    return Buffer;
+  }
+
+ #endif /* HAVE_VECTOR_KERNELS */
+
+  InternalZeroScalar (Buffer, Length);
+  return Buffer;
+}
+
+/**
+  Library constructor. Picks the copy kernels for this CPU.
+
+  @retval RETURN_SUCCESS     Always.
+
+**/
+RETURN_STATUS
+EFIAPI
+FbpCopyLibConstructor (
+  VOID
+  )
+{
+ #ifdef HAVE_VECTOR_KERNELS
+  mHaveVector = InternalVectorSupported ();
+ #endif /* HAVE_VECTOR_KERNELS */
+
+  DEBUG ((
+    DEBUG_VERBOSE,
+    "%a: using %a kernels\n",
+    __func__,
+    mHaveVector ? "vector" : "scalar"
+    ));
+
+  return RETURN_SUCCESS;
+}
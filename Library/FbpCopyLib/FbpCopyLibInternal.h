@@ -0,0 +1,50 @@
+/** @file
+
+    Copyright (c) 2024, Intel Corporation. All rights reserved.<BR>
+
+    SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef __FBP_COPY_LIB_INTERNAL_H__
+#define __FBP_COPY_LIB_INTERNAL_H__
+
+#include <Base.h>
+
+//
+// Copies below this size are not worth the vector setup.
+//
+#define FBP_COPY_VECTOR_MIN  256
+
+//
+// On RISC-V, the vector kernels run with interrupts disabled, one
+// chunk of this size at a time, to bound interrupt latency.
+//
+#define FBP_COPY_VECTOR_CHUNK  SIZE_8KB
+
+//
+// Implemented per-architecture in assembly. The vector routines
+// are only called with non-zero Length and non-overlapping buffers.
+//
+BOOLEAN
+EFIAPI
+InternalVectorSupported (
+  VOID
+  );
+
+VOID
+EFIAPI
+InternalCopyVector (
+  OUT VOID        *Destination,
+  IN  CONST VOID  *Source,
+  IN  UINTN       Length
+  );
+
+VOID
+EFIAPI
+InternalZeroVector (
+  OUT VOID   *Buffer,
+  IN  UINTN  Length
+  );
+
+#endif /* __FBP_COPY_LIB_INTERNAL_H__ */
@@ -0,0 +1,216 @@
+/** @file
+    Deferred work ("bottom halves") for EFI_DT_INTERRUPT_HANDLER.
+
+    Interrupt handlers run with interrupts masked and should only
+    acknowledge the device and queue work. Queued work items are run
+    at TPL_CALLBACK from a single event. An item queued several times
+    before it gets to run is only run once, with the number of times
+    it was queued.
+
+    Copyright (c) 2024, Intel Corporation. All rights reserved.<BR>
+
+    SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/DebugLib.h>
+#include <Library/FbpInterruptUtilsLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+
+struct _FBP_DEFERRED_WORK {
+  UINT32                        Signature;
+  LIST_ENTRY                    Link;
+  FBP_DEFERRED_WORK_FUNCTION    Function;
+  VOID                          *Context;
+  //
+  // Times queued since the last run, 0 when not on mDeferredPending.
+  //
+  UINTN                         Pending;
+};
+
+#define FBP_DEFERRED_WORK_SIGNATURE  SIGNATURE_32 ('f', 'd', 'w', 'k')
+#define FBP_DEFERRED_WORK_FROM_LINK(a)  CR (a, FBP_DEFERRED_WORK, Link, FBP_DEFERRED_WORK_SIGNATURE)
+
+//
+// Queued work. Only accessed at TPL_HIGH_LEVEL, as it
+// is modified from interrupt handlers.
+//
+STATIC LIST_ENTRY  mDeferredPending = INITIALIZE_LIST_HEAD_VARIABLE (mDeferredPending);
+STATIC EFI_EVENT   mDeferredEvent;
+STATIC UINTN       mDeferredWorkCount;
+
+/**
+  Run all queued work.
+
+  @param  Event                 mDeferredEvent.
+  @param  Context               Unused.
+
+**/
+STATIC
+VOID
+EFIAPI
+DeferredWorkDispatch (
+  IN  EFI_EVENT  Event,
+  IN  VOID       *Context
+  )
+{
+  EFI_TPL                     OldTpl;
+  FBP_DEFERRED_WORK           *Work;
+  FBP_DEFERRED_WORK_FUNCTION  Function;
+  VOID                        *WorkContext;
+  UINTN                       Count;
+
+  for ( ; ;) {
+    OldTpl = gBS->RaiseTPL (TPL_HIGH_LEVEL);
+    if (IsListEmpty (&mDeferredPending)) {
+      gBS->RestoreTPL (OldTpl);
+      break;
+    }
+
+    Work = FBP_DEFERRED_WORK_FROM_LINK (GetFirstNode (&mDeferredPending));
+    RemoveEntryList (&Work->Link);
+    Function      = Work->Function;
+    WorkContext   = Work->Context;
+    Count         = Work->Pending;
+    Work->Pending = 0;
+    gBS->RestoreTPL (OldTpl);
+
+    //
+    // Work may be requeued (or destroyed) by Function.
+    //
+    Function (WorkContext, Count);
+  }
+}
+
+/**
+  Create a deferred work item. Must not be called from an
+  interrupt handler.
+
+  @param  Function              Function to run at TPL_CALLBACK.
+  @param  Context               Context passed to Function.
+  @param  Work                  Created work item.
+
+  @retval EFI_SUCCESS           Success.
+  @retval EFI_INVALID_PARAMETER Function or Work is NULL.
+  @retval EFI_OUT_OF_RESOURCES  Out of memory.
+  @retval Other                 Errors from CreateEvent.
+
+**/
+EFI_STATUS
+FbpDeferredWorkCreate (
+  IN  FBP_DEFERRED_WORK_FUNCTION  Function,
+  IN  VOID                        *Context,
+  OUT FBP_DEFERRED_WORK           **Work
+  )
+{
+  EFI_STATUS         Status;
+  FBP_DEFERRED_WORK  *NewWork;
+
+  if ((Function == NULL) || (Work == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (mDeferredEvent == NULL) {
+    Status = gBS->CreateEvent (
+                    EVT_NOTIFY_SIGNAL,
+                    TPL_CALLBACK,
+                    DeferredWorkDispatch,
+                    NULL,
+                    &mDeferredEvent
+                    );
+    if (EFI_ERROR (Status)) {
+      DEBUG ((DEBUG_ERROR, "%a: CreateEvent: %r\n", __func__, Status));
+      return Status;
+    }
+  }
+
+  NewWork = AllocateZeroPool (sizeof (FBP_DEFERRED_WORK));
+  if (NewWork == NULL) {
+    if (mDeferredWorkCount == 0) {
+      gBS->CloseEvent (mDeferredEvent);
+      mDeferredEvent = NULL;
+    }
+
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  NewWork->Signature = FBP_DEFERRED_WORK_SIGNATURE;
+  NewWork->Function  = Function;
+  NewWork->Context   = Context;
+  InitializeListHead (&NewWork->Link);
+
+  mDeferredWorkCount++;
+  *Work = NewWork;
+  return EFI_SUCCESS;
+}
+
+/**
+  Queue a deferred work item to run at TPL_CALLBACK. Safe to call
+  from an interrupt handler.
+
+  @param  Work                  Work item.
+
+**/
+VOID
+FbpDeferredWorkQueue (
+  IN  FBP_DEFERRED_WORK  *Work
+  )
+{
+  EFI_TPL  OldTpl;
+  BOOLEAN  Signal;
+
+  ASSERT (Work->Signature == FBP_DEFERRED_WORK_SIGNATURE);
+
+  OldTpl = gBS->RaiseTPL (TPL_HIGH_LEVEL);
+  Signal = IsListEmpty (&mDeferredPending);
+  if (Work->Pending++ == 0) {
+    InsertTailList (&mDeferredPending, &Work->Link);
+  }
+
+  gBS->RestoreTPL (OldTpl);
+
+  //
+  // The event stays signalled until it is dispatched, so only the
+  // first item queued needs to signal it.
+  //
+  if (Signal) {
+    gBS->SignalEvent (mDeferredEvent);
+  }
+}
+
+/**
+  Destroy a deferred work item, cancelling it if queued. Must
+  not be called from an interrupt handler.
+
+  @param  Work                  Work item.
+
+**/
+VOID
+FbpDeferredWorkDestroy (
+  IN  FBP_DEFERRED_WORK  *Work
+  )
+{
+  EFI_TPL  OldTpl;
+
+  ASSERT (Work->Signature == FBP_DEFERRED_WORK_SIGNATURE);
+
+  OldTpl = gBS->RaiseTPL (TPL_HIGH_LEVEL);
+  if (Work->Pending != 0) {
+    RemoveEntryList (&Work->Link);
+    Work->Pending = 0;
+  }
+
+  gBS->RestoreTPL (OldTpl);
+
+  Work->Signature = 0;
+  FreePool (Work);
+
+  ASSERT (mDeferredWorkCount != 0);
+  if (--mDeferredWorkCount == 0) {
+    gBS->CloseEvent (mDeferredEvent);
+    mDeferredEvent = NULL;
+  }
+}
@@ -6,7 +6,10 @@
 
 **/
 
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
 #include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
 #include <Library/FbpUtilsLib.h>
 #include <Library/FbpInterruptUtilsLib.h>
 #include <Library/UefiBootServicesTableLib.h>
@@ -28,25 +31,177 @@ IsInterruptController (
   return FALSE;
 }
 
+//
+// A decoded interrupt-map. Rows are keyed on the masked child unit address
+// and masked child interrupt specifier, and chained into power-of-two
+// hash buckets. Duplicate keys keep the first row, matching a linear
+// walk of the table.
+//
+typedef struct {
+  EFI_DT_BUS_ADDRESS    UnitAddress;
+  UINT32                Hash;
+  //
+  // Row index + 1 of the next row in the bucket, 0 terminates.
+  //
+  UINTN                 Next;
+  EFI_HANDLE            ParentHandle;
+  EFI_DT_IO_PROTOCOL    *Parent;
+  UINT32                ParentInterruptCells;
+  CONST EFI_DT_CELL     *ParentSpecifier;
+} INTERRUPT_MAP_ROW;
+
+typedef struct {
+  UINT32                Signature;
+  LIST_ENTRY            Link;
+  EFI_DT_IO_PROTOCOL    *Nexus;
+  //
+  // Identifies the interrupt-map property, to notice when Nexus was
+  // removed and the EFI_DT_IO_PROTOCOL memory reused.
+  //
+  CONST VOID            *MapBegin;
+  CONST VOID            *MapEnd;
+  UINT32                AddressCells;
+  UINT32                InterruptCells;
+  EFI_DT_BUS_ADDRESS    AddressMask;
+  //
+  // InterruptCells worth of specifier mask. ShortMask is set if the
+  // interrupt-map-mask is too short, in which case nothing matches.
+  //
+  EFI_DT_CELL           *SpecifierMask;
+  BOOLEAN               ShortMask;
+  //
+  // A row that could not be decoded stops the walk. Lookups that miss
+  // return this status, like a linear walk would after reaching the
+  // bad row. EFI_SUCCESS when the entire map was decoded.
+  //
+  EFI_STATUS            TruncatedStatus;
+  UINTN                 RowCount;
+  UINTN                 BucketMask;
+  UINTN                 *Buckets;
+  //
+  // RowCount * InterruptCells, masked.
+  //
+  EFI_DT_CELL           *Specifiers;
+  INTERRUPT_MAP_ROW     *Rows;
+} INTERRUPT_MAP;
+
+#define INTERRUPT_MAP_SIGNATURE  SIGNATURE_32 ('i', 'm', 'a', 'p')
+#define INTERRUPT_MAP_FROM_LINK(a)  CR (a, INTERRUPT_MAP, Link, INTERRUPT_MAP_SIGNATURE)
+
+STATIC LIST_ENTRY  mInterruptMaps = INITIALIZE_LIST_HEAD_VARIABLE (mInterruptMaps);
+
+/**
+  FNV-1a over a masked unit address and interrupt specifier.
+
+  @param  UnitAddress           Masked unit address.
+  @param  Specifier             Interrupt specifier.
+  @param  SpecifierMask         Mask to apply to Specifier, or NULL if
+                                Specifier is already masked.
+  @param  Cells                 Number of cells in Specifier.
+
+  @return Hash value.
+**/
+STATIC
+UINT32
+InterruptMapHash (
+  IN  EFI_DT_BUS_ADDRESS  UnitAddress,
+  IN  CONST EFI_DT_CELL   *Specifier,
+  IN  CONST EFI_DT_CELL   *SpecifierMask OPTIONAL,
+  IN  UINTN               Cells
+  )
+{
+  UINT32  Hash;
+  UINTN   Index;
+  UINT32  Cell;
+
+  Hash = 0x811C9DC5;
+  for (Index = 0; Index < sizeof (EFI_DT_BUS_ADDRESS) / sizeof (UINT32); Index++) {
+    Hash          = (Hash ^ (UINT32)UnitAddress) * 0x01000193;
+    UnitAddress >>= 32;
+  }
+
+  for (Index = 0; Index < Cells; Index++) {
+    Cell = Specifier[Index];
+    if (SpecifierMask != NULL) {
+      Cell &= SpecifierMask[Index];
+    }
+
+    Hash = (Hash ^ Cell) * 0x01000193;
+  }
+
+  return Hash;
+}
+
+/**
+  Free an INTERRUPT_MAP.
+
+  @param  Map                   INTERRUPT_MAP *.
+
+**/
+STATIC
+VOID
+InterruptMapFree (
+  IN  INTERRUPT_MAP  *Map
+  )
+{
+  if (Map->SpecifierMask != NULL) {
+    FreePool (Map->SpecifierMask);
+  }
+
+  if (Map->Buckets != NULL) {
+    FreePool (Map->Buckets);
+  }
+
+  if (Map->Specifiers != NULL) {
+    FreePool (Map->Specifiers);
+  }
+
+  if (Map->Rows != NULL) {
+    FreePool (Map->Rows);
+  }
+
+  FreePool (Map);
+}
+
+/**
+  Decode the interrupt-map of Nexus into an INTERRUPT_MAP.
+
+  @param  Child                 Device whose interrupt is being translated,
+                                used to parse unit addresses.
+  @param  Nexus                 Interrupt nexus.
+  @param  InterruptCells        Nexus #interrupt-cells.
+  @param  OutMap                INTERRUPT_MAP **.
+  @param  Cacheable             FALSE if decoding stopped for a reason that
+                                might not persist (e.g. a device lookup).
+
+  @retval EFI_SUCCESS           Success. (*OutMap)->TruncatedStatus may be
+                                an error.
+  @retval Other                 Errors.
+**/
 STATIC
 EFI_STATUS
-TranslateWithInterruptNexus (
-  IN  EFI_DT_IO_PROTOCOL   *Child,
-  IN  EFI_DT_IO_PROTOCOL   *Nexus,
-  IN  UINT32               *InterruptCells,
-  IN  OUT EFI_DT_PROPERTY  *Interrupt,
-  OUT EFI_HANDLE           *InterruptParentHandle,
-  OUT EFI_DT_IO_PROTOCOL   **InterruptParentIo
+InterruptMapBuild (
+  IN  EFI_DT_IO_PROTOCOL  *Child,
+  IN  EFI_DT_IO_PROTOCOL  *Nexus,
+  IN  UINT32              InterruptCells,
+  OUT INTERRUPT_MAP       **OutMap,
+  OUT BOOLEAN             *Cacheable
   )
 {
   EFI_STATUS          Status;
   EFI_DT_PROPERTY     InterruptMap;
   EFI_DT_PROPERTY     InterruptMapMask;
-  EFI_DT_BUS_ADDRESS  MaskedChildUnitAddress;
+  INTERRUPT_MAP       *Map;
+  UINTN               MaxRows;
+  UINTN               Index;
+  UINTN               BucketCount;
+  INTERRUPT_MAP_ROW   *Row;
+  EFI_DT_CELL         *Specifier;
   EFI_HANDLE          ParentHandle;
   EFI_DT_IO_PROTOCOL  *Parent;
   UINT32              ParentInterruptCells;
-  BOOLEAN             BadMatch;
+
+  *Cacheable = TRUE;
 
   Status = Nexus->GetProp (Nexus, "interrupt-map", &InterruptMap);
   if (EFI_ERROR (Status)) {
@@ -56,65 +211,107 @@ TranslateWithInterruptNexus (
 
   Status = Nexus->GetProp (Nexus, "interrupt-map-mask", &InterruptMapMask);
   if (EFI_ERROR (Status)) {
-    DEBUG ((DEBUG_ERROR, "%a: GetProp(interrupt-map): %r\n", __func__, Status));
+    DEBUG ((DEBUG_ERROR, "%a: GetProp(interrupt-map-mask): %r\n", __func__, Status));
     return Status;
   }
 
-  if (Child->AddressCells != 0) {
-    EFI_DT_REG  Reg;
+  Map = AllocateZeroPool (sizeof (INTERRUPT_MAP));
+  if (Map == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
 
-    Status = Child->GetReg (Child, 0, &Reg);
-    if (EFI_ERROR (Status)) {
-      DEBUG ((DEBUG_ERROR, "%a: GetReg: %r\n", __func__, Status));
-      return Status;
-    }
+  Map->Signature      = INTERRUPT_MAP_SIGNATURE;
+  Map->Nexus          = Nexus;
+  Map->MapBegin       = InterruptMap.Begin;
+  Map->MapEnd         = InterruptMap.End;
+  Map->AddressCells   = Child->AddressCells;
+  Map->InterruptCells = InterruptCells;
+  Map->AddressMask    = 0;
 
-    Status = Child->ParseProp (Child, &InterruptMapMask, EFI_DT_VALUE_BUS_ADDRESS, 0, &MaskedChildUnitAddress);
+  if (Child->AddressCells != 0) {
+    Status = Child->ParseProp (Child, &InterruptMapMask, EFI_DT_VALUE_BUS_ADDRESS, 0, &Map->AddressMask);
     if (EFI_ERROR (Status)) {
       DEBUG ((DEBUG_ERROR, "%a: ParseProp(MaskedChildUnitAddress): %r\n", __func__, Status));
-      return Status;
+      goto Error;
     }
+  }
+
+  Map->SpecifierMask = AllocatePool (MAX (InterruptCells, 1) * sizeof (EFI_DT_CELL));
+  if (Map->SpecifierMask == NULL) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto Error;
+  }
+
+  if (InterruptMapMask.Iter == InterruptMapMask.End) {
+    SetMem32 (Map->SpecifierMask, InterruptCells * sizeof (EFI_DT_CELL), MAX_UINT32);
+  } else if ((InterruptMapMask.End - InterruptMapMask.Iter) / sizeof (EFI_DT_CELL) < InterruptCells) {
+    //
+    // Nothing can match a short mask, but still walk the rows to report
+    // any malformed ones.
+    //
+    ZeroMem (Map->SpecifierMask, InterruptCells * sizeof (EFI_DT_CELL));
+    Map->ShortMask = TRUE;
+  } else {
+    CopyMem (Map->SpecifierMask, InterruptMapMask.Iter, InterruptCells * sizeof (EFI_DT_CELL));
+  }
+
+  //
+  // Every complete row has at least the child unit address, child specifier
+  // and the parent phandle.
+  //
+  MaxRows = (InterruptMap.End - InterruptMap.Iter) /
+            (sizeof (EFI_DT_CELL) * (Child->AddressCells + InterruptCells + 1));
 
-    MaskedChildUnitAddress &= Reg.BusBase;
+  BucketCount = 1;
+  while (BucketCount < MaxRows) {
+    BucketCount <<= 1;
+  }
+
+  Map->BucketMask = BucketCount - 1;
+  Map->Buckets    = AllocateZeroPool (BucketCount * sizeof (UINTN));
+  Map->Rows       = AllocateZeroPool (MAX (MaxRows, 1) * sizeof (INTERRUPT_MAP_ROW));
+  Map->Specifiers = AllocateZeroPool (MAX (MaxRows * InterruptCells, 1) * sizeof (EFI_DT_CELL));
+  if ((Map->Buckets == NULL) || (Map->Rows == NULL) || (Map->Specifiers == NULL)) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto Error;
   }
 
   while (InterruptMap.Iter < InterruptMap.End) {
     //
     // interrupt-map is a table, but each row is not the same size, as each entry can have
     // a potentially different interrupt-parent and the parent unit address and interrupt
-    // specifiers are in the domain of the interrupt parent. Thus we need to parse
-    // every row in the table even if we know they don't match.
+    // specifiers are in the domain of the interrupt parent. Thus every row must be parsed
+    // in order.
     //
+    Row       = &Map->Rows[Map->RowCount];
+    Specifier = &Map->Specifiers[Map->RowCount * InterruptCells];
 
-    BadMatch = FALSE;
     if (Child->AddressCells != 0) {
-      EFI_DT_BUS_ADDRESS  ChildUnitAddress;
-
-      Status = Child->ParseProp (Child, &InterruptMap, EFI_DT_VALUE_BUS_ADDRESS, 0, &ChildUnitAddress);
+      Status = Child->ParseProp (Child, &InterruptMap, EFI_DT_VALUE_BUS_ADDRESS, 0, &Row->UnitAddress);
       if (EFI_ERROR (Status)) {
         DEBUG ((DEBUG_ERROR, "%a: ParseProp(MaskedChildUnitAddress): %r\n", __func__, Status));
         //
         // Malfomed table...
         //
-        Status = EFI_DEVICE_ERROR;
-        return Status;
+        Map->TruncatedStatus = EFI_DEVICE_ERROR;
+        break;
       }
 
-      if (ChildUnitAddress != MaskedChildUnitAddress) {
-        BadMatch = TRUE;
-      }
+      Row->UnitAddress &= Map->AddressMask;
     }
 
-    if (!BadMatch) {
-      BadMatch = !FbpPropertyCompare (Interrupt, &InterruptMap, *InterruptCells, &InterruptMapMask);
+    if ((InterruptMap.End - InterruptMap.Iter) / sizeof (EFI_DT_CELL) < InterruptCells) {
+      DEBUG ((DEBUG_ERROR, "%a: malformed row smaller than InterruptCells %lu\n", __func__, InterruptCells));
+      Map->TruncatedStatus = EFI_DEVICE_ERROR;
+      break;
     }
 
-    InterruptMap.Iter = ((EFI_DT_CELL *)InterruptMap.Iter) + *InterruptCells;
-    if (InterruptMap.Iter > InterruptMap.End) {
-      DEBUG ((DEBUG_ERROR, "%a: malformed row smaller than InterruptCells %lu\n", __func__, *InterruptCells));
-      return EFI_DEVICE_ERROR;
+    for (Index = 0; Index < InterruptCells; Index++) {
+      Specifier[Index] = ((CONST EFI_DT_CELL *)InterruptMap.Iter)[Index] & Map->SpecifierMask[Index];
     }
 
+    InterruptMap.Iter = ((EFI_DT_CELL *)InterruptMap.Iter) + InterruptCells;
+
     Status = Nexus->ParseProp (Nexus, &InterruptMap, EFI_DT_VALUE_DEVICE, 0, &ParentHandle);
     if (EFI_ERROR (Status)) {
       //
@@ -124,26 +321,30 @@ TranslateWithInterruptNexus (
       DEBUG ((DEBUG_ERROR, "%a: ParseProp (ParentHandle): %r\n", __func__, Status));
       //
       // Malfomed table... or issues with device lookup (missing drivers for intermediate nodes).
+      // The latter may be resolved later, so don't keep the result around.
       //
-      Status = EFI_DEVICE_ERROR;
-      return Status;
+      Map->TruncatedStatus = EFI_DEVICE_ERROR;
+      *Cacheable           = FALSE;
+      break;
     }
 
     Status = gBS->HandleProtocol (ParentHandle, &gEfiDtIoProtocolGuid, (VOID **)&Parent);
     ASSERT_EFI_ERROR (Status);
     if (EFI_ERROR (Status)) {
-      DEBUG ((DEBUG_ERROR, "%a: HandleProtocol (Parent): %r\n", Status));
+      DEBUG ((DEBUG_ERROR, "%a: HandleProtocol (Parent): %r\n", __func__, Status));
       //
       // Okay, this one shouldn't happen (hence assert).
       //
-      Status = EFI_DEVICE_ERROR;
-      return Status;
+      Map->TruncatedStatus = EFI_DEVICE_ERROR;
+      *Cacheable           = FALSE;
+      break;
     }
 
     Status = Parent->GetU32 (Parent, "#interrupt-cells", 0, &ParentInterruptCells);
     if (EFI_ERROR (Status)) {
       DEBUG ((DEBUG_ERROR, "%a: GetU32(#interrupt-cells): %r\n", __func__, Status));
-      return Status;
+      Map->TruncatedStatus = Status;
+      break;
     }
 
     //
@@ -157,7 +358,8 @@ TranslateWithInterruptNexus (
         __func__,
         Parent->ChildAddressCells
         ));
-      return EFI_DEVICE_ERROR;
+      Map->TruncatedStatus = EFI_DEVICE_ERROR;
+      break;
     }
 
     if ((InterruptMap.End - InterruptMap.Iter) / (sizeof (EFI_DT_CELL)) < ParentInterruptCells) {
@@ -167,101 +369,674 @@ TranslateWithInterruptNexus (
         __func__,
         ParentInterruptCells
         ));
-      return EFI_DEVICE_ERROR;
+      Map->TruncatedStatus = EFI_DEVICE_ERROR;
+      break;
     }
 
-    if (!BadMatch) {
-      *Interrupt             = InterruptMap;
-      *InterruptParentHandle = ParentHandle;
-      *InterruptParentIo     = Parent;
-      *InterruptCells        = ParentInterruptCells;
-      return EFI_SUCCESS;
+    ASSERT (Map->RowCount < MaxRows);
+    Row->ParentHandle         = ParentHandle;
+    Row->Parent               = Parent;
+    Row->ParentInterruptCells = ParentInterruptCells;
+    Row->ParentSpecifier      = InterruptMap.Iter;
+    Row->Hash                 = InterruptMapHash (Row->UnitAddress, Specifier, NULL, InterruptCells);
+
+    //
+    // Append to the bucket chain, so the first of any duplicate rows wins.
+    //
+    if (Map->Buckets[Row->Hash & Map->BucketMask] == 0) {
+      Map->Buckets[Row->Hash & Map->BucketMask] = Map->RowCount + 1;
+    } else {
+      Index = Map->Buckets[Row->Hash & Map->BucketMask] - 1;
+      while (Map->Rows[Index].Next != 0) {
+        Index = Map->Rows[Index].Next - 1;
+      }
+
+      Map->Rows[Index].Next = Map->RowCount + 1;
     }
 
+    Map->RowCount++;
     InterruptMap.Iter = ((EFI_DT_CELL *)InterruptMap.Iter) + ParentInterruptCells;
   }
 
-  return EFI_NOT_FOUND;
+  *OutMap = Map;
+  return EFI_SUCCESS;
+
+Error:
+  InterruptMapFree (Map);
+  return Status;
 }
 
 /**
-  Looks up an interrupt for a Devicetree node associated with the
-  EFI_DT_IO_PROTOCOL instance, returning the matching controller
-  handle  and interrupt information necessary for handler registration.
+  Find a row in an INTERRUPT_MAP.
 
-  @param  This                  A pointer to the EFI_DT_IO_PROTOCOL instance.
-  @param  Index                 The index of the interrupt requested.
-  @param  InterruptParent       EFI_HANDLE *.
-  @param  Interrupt             EFI_DT_PROPERTY to pass to *DtInterrupt.
+  @param  Map                   INTERRUPT_MAP *.
+  @param  UnitAddress           Masked child unit address.
+  @param  Interrupt             Child interrupt specifier.
 
-  @return EFI_SUCCESS           *DtInterrupt and *Interrupt populated.
+  @return Matching INTERRUPT_MAP_ROW or NULL.
 **/
+STATIC
+INTERRUPT_MAP_ROW *
+InterruptMapFind (
+  IN  INTERRUPT_MAP       *Map,
+  IN  EFI_DT_BUS_ADDRESS  UnitAddress,
+  IN  EFI_DT_PROPERTY     *Interrupt
+  )
+{
+  CONST EFI_DT_CELL  *Specifier;
+  UINT32             Hash;
+  UINTN              Next;
+  UINTN              Index;
+  INTERRUPT_MAP_ROW  *Row;
+
+  if (Map->ShortMask ||
+      ((Interrupt->End - Interrupt->Iter) / sizeof (EFI_DT_CELL) < Map->InterruptCells))
+  {
+    return NULL;
+  }
+
+  Specifier = Interrupt->Iter;
+  Hash      = InterruptMapHash (UnitAddress, Specifier, Map->SpecifierMask, Map->InterruptCells);
+
+  for (Next = Map->Buckets[Hash & Map->BucketMask]; Next != 0; Next = Row->Next) {
+    Row = &Map->Rows[Next - 1];
+    if ((Row->Hash != Hash) || (Row->UnitAddress != UnitAddress)) {
+      continue;
+    }
+
+    for (Index = 0; Index < Map->InterruptCells; Index++) {
+      if ((Specifier[Index] & Map->SpecifierMask[Index]) !=
+          Map->Specifiers[(Next - 1) * Map->InterruptCells + Index])
+      {
+        break;
+      }
+    }
+
+    if (Index == Map->InterruptCells) {
+      return Row;
+    }
+  }
+
+  return NULL;
+}
+
+/**
+  Return the cached INTERRUPT_MAP for Nexus, decoding interrupt-map if
+  necessary. A cached map is dropped if Nexus or any interrupt parent
+  it references have gone away.
+
+  @param  Child                 Device whose interrupt is being translated.
+  @param  Nexus                 Interrupt nexus.
+  @param  InterruptCells        Nexus #interrupt-cells.
+  @param  OutMap                INTERRUPT_MAP **.
+  @param  Cached                FALSE if the caller must free *OutMap.
+
+  @retval EFI_SUCCESS           Success.
+  @retval Other                 Errors.
+**/
+STATIC
 EFI_STATUS
-FbpInterruptGet (
-  IN  EFI_DT_IO_PROTOCOL  *This,
-  IN  UINTN               Index,
-  OUT EFI_HANDLE          *InterruptParent,
-  OUT EFI_DT_PROPERTY     *Interrupt
+InterruptMapGet (
+  IN  EFI_DT_IO_PROTOCOL  *Child,
+  IN  EFI_DT_IO_PROTOCOL  *Nexus,
+  IN  UINT32              InterruptCells,
+  OUT INTERRUPT_MAP       **OutMap,
+  OUT BOOLEAN             *Cached
   )
 {
-  EFI_STATUS          Status;
-  EFI_HANDLE          ParentHandle;
-  EFI_DT_IO_PROTOCOL  *Parent;
-  EFI_DT_IO_PROTOCOL  *Child;
-  EFI_DT_IO_PROTOCOL  *Nexus;
-  EFI_DT_PROPERTY     Interrupts;
-  UINT32              InterruptCells;
+  EFI_STATUS       Status;
+  EFI_TPL          OldTpl;
+  LIST_ENTRY       *Link;
+  INTERRUPT_MAP    *Map;
+  INTERRUPT_MAP    *Stale;
+  EFI_DT_PROPERTY  InterruptMap;
+  UINTN            Index;
+  VOID             *Parent;
 
-  Child  = This;
-  Status = Child->GetProp (Child, "interrupts", &Interrupts);
+  Status = Nexus->GetProp (Nexus, "interrupt-map", &InterruptMap);
   if (EFI_ERROR (Status)) {
-    DEBUG ((DEBUG_ERROR, "%a: GetProp(interrupts): %r\n", __func__, Status));
+    DEBUG ((DEBUG_ERROR, "%a: GetProp(interrupt-map): %r\n", __func__, Status));
     return Status;
   }
 
-  Status = Child->GetDevice (Child, "interrupt-parent", 0, &ParentHandle);
-  if (EFI_ERROR (Status)) {
-    ParentHandle = Child->ParentDevice;
+  Map    = NULL;
+  Stale  = NULL;
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  for (Link = GetFirstNode (&mInterruptMaps)
+       ; !IsNull (&mInterruptMaps, Link)
+       ; Link = GetNextNode (&mInterruptMaps, Link)
+       )
+  {
+    Map = INTERRUPT_MAP_FROM_LINK (Link);
+    if ((Map->Nexus == Nexus) &&
+        (Map->AddressCells == Child->AddressCells) &&
+        (Map->InterruptCells == InterruptCells))
+    {
+      break;
+    }
+
+    Map = NULL;
   }
 
-  if (ParentHandle == NULL) {
-    DEBUG ((DEBUG_ERROR, "%a: no interrupt parent\n", __func__));
-    return EFI_NOT_FOUND;
+  if ((Map != NULL) && (Map->MapBegin != InterruptMap.Begin)) {
+    Stale = Map;
   }
 
-  Status = gBS->HandleProtocol (ParentHandle, &gEfiDtIoProtocolGuid, (VOID **)&Parent);
+  if ((Map != NULL) && (Stale == NULL)) {
+    for (Index = 0; Index < Map->RowCount; Index++) {
+      if ((Index != 0) && (Map->Rows[Index].ParentHandle == Map->Rows[Index - 1].ParentHandle)) {
+        continue;
+      }
+
+      Status = gBS->HandleProtocol (Map->Rows[Index].ParentHandle, &gEfiDtIoProtocolGuid, &Parent);
+      if (EFI_ERROR (Status) || (Parent != Map->Rows[Index].Parent)) {
+        Stale = Map;
+        break;
+      }
+    }
+  }
+
+  if (Stale != NULL) {
+    RemoveEntryList (&Stale->Link);
+    Map = NULL;
+  }
+
+  gBS->RestoreTPL (OldTpl);
+
+  if (Stale != NULL) {
+    InterruptMapFree (Stale);
+  }
+
+  if (Map != NULL) {
+    *OutMap = Map;
+    *Cached = TRUE;
+    return EFI_SUCCESS;
+  }
+
+  Status = InterruptMapBuild (Child, Nexus, InterruptCells, &Map, Cached);
   if (EFI_ERROR (Status)) {
-    DEBUG ((DEBUG_ERROR, "%a: HandleProtocol(EfiDtIoProtocolGuid): %r\n", __func__, Status));
     return Status;
   }
 
-  Status = Parent->GetU32 (Parent, "#interrupt-cells", 0, &InterruptCells);
+  if (*Cached) {
+    OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+    InsertTailList (&mInterruptMaps, &Map->Link);
+    gBS->RestoreTPL (OldTpl);
+  }
+
+  *OutMap = Map;
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+TranslateWithInterruptNexus (
+  IN  EFI_DT_IO_PROTOCOL   *Child,
+  IN  EFI_DT_IO_PROTOCOL   *Nexus,
+  IN  UINT32               *InterruptCells,
+  IN  OUT EFI_DT_PROPERTY  *Interrupt,
+  OUT EFI_HANDLE           *InterruptParentHandle,
+  OUT EFI_DT_IO_PROTOCOL   **InterruptParentIo,
+  OUT BOOLEAN              *Cacheable
+  )
+{
+  EFI_STATUS          Status;
+  INTERRUPT_MAP       *Map;
+  INTERRUPT_MAP_ROW   *Row;
+  BOOLEAN             Cached;
+  EFI_DT_BUS_ADDRESS  MaskedChildUnitAddress;
+
+  *Cacheable             = TRUE;
+  MaskedChildUnitAddress = 0;
+  if (Child->AddressCells != 0) {
+    EFI_DT_REG  Reg;
+
+    Status = Child->GetReg (Child, 0, &Reg);
+    if (EFI_ERROR (Status)) {
+      DEBUG ((DEBUG_ERROR, "%a: GetReg: %r\n", __func__, Status));
+      return Status;
+    }
+
+    MaskedChildUnitAddress = Reg.BusBase;
+  }
+
+  Status = InterruptMapGet (Child, Nexus, *InterruptCells, &Map, &Cached);
   if (EFI_ERROR (Status)) {
-    DEBUG ((DEBUG_ERROR, "%a: GetU32(#interrupt-cells): %r\n", __func__, Status));
+    if (Status == EFI_OUT_OF_RESOURCES) {
+      *Cacheable = FALSE;
+    }
+
     return Status;
   }
 
-  if ((Interrupts.End - Interrupts.Iter) / (sizeof (EFI_DT_CELL) * InterruptCells) <= Index) {
-    DEBUG ((DEBUG_ERROR, "%a: Index %u is out of bounds\n", __func__, Index));
-    return EFI_NOT_FOUND;
+  MaskedChildUnitAddress &= Map->AddressMask;
+
+  Row = InterruptMapFind (Map, MaskedChildUnitAddress, Interrupt);
+  if (Row != NULL) {
+    Interrupt->Begin       = Map->MapBegin;
+    Interrupt->Iter        = Row->ParentSpecifier;
+    Interrupt->End         = Map->MapEnd;
+    *InterruptParentHandle = Row->ParentHandle;
+    *InterruptParentIo     = Row->Parent;
+    *InterruptCells        = Row->ParentInterruptCells;
+    Status                 = EFI_SUCCESS;
+  } else if (EFI_ERROR (Map->TruncatedStatus)) {
+    Status = Map->TruncatedStatus;
+  } else {
+    Status = EFI_NOT_FOUND;
+  }
+
+  if (!Cached) {
+    *Cacheable = FALSE;
+    InterruptMapFree (Map);
   }
 
-  Interrupts.Iter = ((EFI_DT_CELL *)Interrupts.Iter) + InterruptCells * Index;
-  Nexus           = Parent;
+  return Status;
+}
+
+//
+// Fully resolved interrupts of a device, i.e. after following interrupt-parent
+// and any interrupt nexus translation, in "interrupts" or "interrupts-extended"
+// order.
+//
+typedef struct {
+  EFI_STATUS            Status;
+  EFI_HANDLE            ParentHandle;
+  EFI_DT_IO_PROTOCOL    *Parent;
+  EFI_DT_PROPERTY       Interrupt;
+} RESOLVED_INTERRUPT;
+
+typedef struct {
+  UINT32                Signature;
+  LIST_ENTRY            Link;
+  EFI_DT_IO_PROTOCOL    *Device;
+  //
+  // Identifies the interrupts or interrupts-extended property, to notice
+  // when Device was removed and the EFI_DT_IO_PROTOCOL memory reused.
+  //
+  CONST CHAR8           *PropName;
+  CONST VOID            *PropBegin;
+  UINTN                 Count;
+  RESOLVED_INTERRUPT    *Interrupts;
+} DEVICE_INTERRUPTS;
+
+#define DEVICE_INTERRUPTS_SIGNATURE  SIGNATURE_32 ('d', 'i', 'n', 't')
+#define DEVICE_INTERRUPTS_FROM_LINK(a)  CR (a, DEVICE_INTERRUPTS, Link, DEVICE_INTERRUPTS_SIGNATURE)
+
+STATIC LIST_ENTRY  mDeviceInterrupts = INITIALIZE_LIST_HEAD_VARIABLE (mDeviceInterrupts);
+
+/**
+  Resolve an interrupt specifier to the interrupt controller that handles it,
+  going through any interrupt nexus nodes.
+
+  @param  Child                 Device the interrupt belongs to.
+  @param  ParentHandle          Interrupt parent of Child.
+  @param  Interrupt             Interrupt specifier in the domain of ParentHandle.
+  @param  Resolved              Resolved interrupt.
+  @param  Cacheable             FALSE if the result might change on retry.
+
+**/
+STATIC
+VOID
+ResolveInterrupt (
+  IN  EFI_DT_IO_PROTOCOL  *Child,
+  IN  EFI_HANDLE          ParentHandle,
+  IN  EFI_DT_PROPERTY     *Interrupt,
+  OUT RESOLVED_INTERRUPT  *Resolved,
+  OUT BOOLEAN             *Cacheable
+  )
+{
+  EFI_STATUS          Status;
+  EFI_DT_IO_PROTOCOL  *Parent;
+  EFI_DT_IO_PROTOCOL  *Nexus;
+  UINT32              InterruptCells;
+  EFI_DT_PROPERTY     Interrupts;
+
+  *Cacheable = TRUE;
+  Interrupts = *Interrupt;
 
+  Status = gBS->HandleProtocol (ParentHandle, &gEfiDtIoProtocolGuid, (VOID **)&Parent);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "%a: HandleProtocol(EfiDtIoProtocolGuid): %r\n", __func__, Status));
+    *Cacheable       = FALSE;
+    Resolved->Status = Status;
+    return;
+  }
+
+  Status = Parent->GetU32 (Parent, "#interrupt-cells", 0, &InterruptCells);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "%a: GetU32(#interrupt-cells): %r\n", __func__, Status));
+    Resolved->Status = Status;
+    return;
+  }
+
+  Nexus = Parent;
   while (!IsInterruptController (Parent)) {
-    Status = TranslateWithInterruptNexus (Child, Nexus, &InterruptCells, &Interrupts, &ParentHandle, &Parent);
+    Status = TranslateWithInterruptNexus (Child, Nexus, &InterruptCells, &Interrupts, &ParentHandle, &Parent, Cacheable);
     if (EFI_ERROR (Status)) {
       DEBUG ((DEBUG_ERROR, "%a: TranslateWithInterruptNexus: %r\n", __func__, Status));
-      return Status;
+      Resolved->Status = Status;
+      return;
     }
 
     Child = Nexus;
     Nexus = Parent;
   }
 
-  *InterruptParent = ParentHandle;
-  *Interrupt       = Interrupts;
+  Resolved->Status       = EFI_SUCCESS;
+  Resolved->ParentHandle = ParentHandle;
+  Resolved->Parent       = Parent;
+  Resolved->Interrupt    = Interrupts;
+}
+
+/**
+  Resolve all interrupts of a device.
+
+  @param  This                  Device.
+  @param  OutDevice             DEVICE_INTERRUPTS **.
+  @param  Cacheable             FALSE if the result might change on retry.
+
+  @retval EFI_SUCCESS           Success. Individual interrupts may have
+                                failed to resolve.
+  @retval Other                 Errors.
+**/
+STATIC
+EFI_STATUS
+DeviceInterruptsBuild (
+  IN  EFI_DT_IO_PROTOCOL  *This,
+  OUT DEVICE_INTERRUPTS   **OutDevice,
+  OUT BOOLEAN             *Cacheable
+  )
+{
+  EFI_STATUS          Status;
+  EFI_DT_PROPERTY     Interrupts;
+  CONST CHAR8         *PropName;
+  EFI_HANDLE          ParentHandle;
+  EFI_DT_IO_PROTOCOL  *Parent;
+  UINT32              InterruptCells;
+  UINTN               MaxCount;
+  DEVICE_INTERRUPTS   *Device;
+  RESOLVED_INTERRUPT  *Resolved;
+  BOOLEAN             ResolvedCacheable;
+
+  *Cacheable   = TRUE;
+  ParentHandle = NULL;
+  PropName     = "interrupts-extended";
+  Status       = This->GetProp (This, PropName, &Interrupts);
+  if (EFI_ERROR (Status)) {
+    PropName = "interrupts";
+    Status   = This->GetProp (This, PropName, &Interrupts);
+    if (EFI_ERROR (Status)) {
+      DEBUG ((DEBUG_ERROR, "%a: GetProp(interrupts): %r\n", __func__, Status));
+      return Status;
+    }
+
+    Status = This->GetDevice (This, "interrupt-parent", 0, &ParentHandle);
+    if (EFI_ERROR (Status)) {
+      ParentHandle = This->ParentDevice;
+    }
+
+    if (ParentHandle == NULL) {
+      DEBUG ((DEBUG_ERROR, "%a: no interrupt parent\n", __func__));
+      return EFI_NOT_FOUND;
+    }
+
+    Status = gBS->HandleProtocol (ParentHandle, &gEfiDtIoProtocolGuid, (VOID **)&Parent);
+    if (EFI_ERROR (Status)) {
+      DEBUG ((DEBUG_ERROR, "%a: HandleProtocol(EfiDtIoProtocolGuid): %r\n", __func__, Status));
+      *Cacheable = FALSE;
+      return Status;
+    }
+
+    Status = Parent->GetU32 (Parent, "#interrupt-cells", 0, &InterruptCells);
+    if (EFI_ERROR (Status)) {
+      DEBUG ((DEBUG_ERROR, "%a: GetU32(#interrupt-cells): %r\n", __func__, Status));
+      return Status;
+    }
+
+    MaxCount = 0;
+    if (InterruptCells != 0) {
+      MaxCount = (Interrupts.End - Interrupts.Iter) / (sizeof (EFI_DT_CELL) * InterruptCells);
+    }
+  } else {
+    //
+    // Every entry has at least the parent phandle.
+    //
+    MaxCount = (Interrupts.End - Interrupts.Iter) / sizeof (EFI_DT_CELL);
+  }
+
+  Device = AllocateZeroPool (sizeof (DEVICE_INTERRUPTS) + MaxCount * sizeof (RESOLVED_INTERRUPT));
+  if (Device == NULL) {
+    *Cacheable = FALSE;
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Device->Signature  = DEVICE_INTERRUPTS_SIGNATURE;
+  Device->Device     = This;
+  Device->PropName   = PropName;
+  Device->PropBegin  = Interrupts.Begin;
+  Device->Interrupts = (RESOLVED_INTERRUPT *)(Device + 1);
+
+  while (Device->Count < MaxCount) {
+    Resolved = &Device->Interrupts[Device->Count];
 
+    if (ParentHandle == NULL) {
+      //
+      // interrupts-extended: each entry names its own parent.
+      //
+      Status = This->ParseProp (This, &Interrupts, EFI_DT_VALUE_DEVICE, 0, &Resolved->ParentHandle);
+      if (EFI_ERROR (Status)) {
+        if (Interrupts.Iter < Interrupts.End) {
+          DEBUG ((DEBUG_ERROR, "%a: ParseProp(interrupts-extended): %r\n", __func__, Status));
+          //
+          // Can't size the remaining entries. Record the failure against
+          // the next entry, and don't keep the result around in case the
+          // device lookup works later.
+          //
+          Resolved->Status = EFI_DEVICE_ERROR;
+          Device->Count++;
+          *Cacheable = FALSE;
+        }
+
+        break;
+      }
+
+      Status = gBS->HandleProtocol (Resolved->ParentHandle, &gEfiDtIoProtocolGuid, (VOID **)&Parent);
+      if (!EFI_ERROR (Status)) {
+        Status = Parent->GetU32 (Parent, "#interrupt-cells", 0, &InterruptCells);
+      }
+
+      if (EFI_ERROR (Status) ||
+          ((Interrupts.End - Interrupts.Iter) / sizeof (EFI_DT_CELL) < InterruptCells))
+      {
+        DEBUG ((DEBUG_ERROR, "%a: malformed interrupts-extended entry %u\n", __func__, Device->Count));
+        Resolved->Status = EFI_DEVICE_ERROR;
+        Device->Count++;
+        break;
+      }
+
+      ResolveInterrupt (This, Resolved->ParentHandle, &Interrupts, Resolved, &ResolvedCacheable);
+    } else {
+      ResolveInterrupt (This, ParentHandle, &Interrupts, Resolved, &ResolvedCacheable);
+    }
+
+    if (!ResolvedCacheable) {
+      *Cacheable = FALSE;
+    }
+
+    Interrupts.Iter = ((EFI_DT_CELL *)Interrupts.Iter) + InterruptCells;
+    Device->Count++;
+  }
+
+  *OutDevice = Device;
   return EFI_SUCCESS;
 }
+
+/**
+  Return the cached DEVICE_INTERRUPTS for a device, resolving its interrupts
+  if necessary. A cached entry is dropped if the device was removed.
+
+  @param  This                  Device.
+  @param  OutDevice             DEVICE_INTERRUPTS **.
+  @param  Cached                FALSE if the caller must free *OutDevice.
+
+  @retval EFI_SUCCESS           Success.
+  @retval Other                 Errors.
+**/
+STATIC
+EFI_STATUS
+DeviceInterruptsGet (
+  IN  EFI_DT_IO_PROTOCOL  *This,
+  OUT DEVICE_INTERRUPTS   **OutDevice,
+  OUT BOOLEAN             *Cached
+  )
+{
+  EFI_STATUS         Status;
+  EFI_TPL            OldTpl;
+  LIST_ENTRY         *Link;
+  DEVICE_INTERRUPTS  *Device;
+  DEVICE_INTERRUPTS  *Stale;
+  EFI_DT_PROPERTY    Property;
+
+  Stale  = NULL;
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  for (Link = GetFirstNode (&mDeviceInterrupts)
+       ; !IsNull (&mDeviceInterrupts, Link)
+       ; Link = GetNextNode (&mDeviceInterrupts, Link)
+       )
+  {
+    Device = DEVICE_INTERRUPTS_FROM_LINK (Link);
+    if (Device->Device == This) {
+      Status = This->GetProp (This, Device->PropName, &Property);
+      if (EFI_ERROR (Status) || (Property.Begin != Device->PropBegin)) {
+        RemoveEntryList (&Device->Link);
+        Stale = Device;
+        break;
+      }
+
+      gBS->RestoreTPL (OldTpl);
+      *OutDevice = Device;
+      *Cached    = TRUE;
+      return EFI_SUCCESS;
+    }
+  }
+
+  gBS->RestoreTPL (OldTpl);
+
+  if (Stale != NULL) {
+    FreePool (Stale);
+  }
+
+  Status = DeviceInterruptsBuild (This, &Device, Cached);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  if (*Cached) {
+    OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+    InsertTailList (&mDeviceInterrupts, &Device->Link);
+    gBS->RestoreTPL (OldTpl);
+  }
+
+  *OutDevice = Device;
+  return EFI_SUCCESS;
+}
+
+/**
+  Drop a cached DEVICE_INTERRUPTS.
+
+  @param  Device                DEVICE_INTERRUPTS *.
+
+**/
+STATIC
+VOID
+DeviceInterruptsDrop (
+  IN  DEVICE_INTERRUPTS  *Device
+  )
+{
+  EFI_TPL  OldTpl;
+
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  RemoveEntryList (&Device->Link);
+  gBS->RestoreTPL (OldTpl);
+  FreePool (Device);
+}
+
+/**
+  Looks up an interrupt for a Devicetree node associated with the
+  EFI_DT_IO_PROTOCOL instance, returning the matching controller
+  handle  and interrupt information necessary for handler registration.
+
+  The interrupts of a device are resolved on first use and cached. The
+  cache is refreshed if the interrupt controller has since been removed.
+
+  @param  This                  A pointer to the EFI_DT_IO_PROTOCOL instance.
+  @param  Index                 The index of the interrupt requested.
+  @param  InterruptParent       EFI_HANDLE *.
+  @param  Interrupt             EFI_DT_PROPERTY to pass to *DtInterrupt.
+
+  @return EFI_SUCCESS           *DtInterrupt and *Interrupt populated.
+**/
+EFI_STATUS
+FbpInterruptGet (
+  IN  EFI_DT_IO_PROTOCOL  *This,
+  IN  UINTN               Index,
+  OUT EFI_HANDLE          *InterruptParent,
+  OUT EFI_DT_PROPERTY     *Interrupt
+  )
+{
+  EFI_STATUS          Status;
+  DEVICE_INTERRUPTS   *Device;
+  RESOLVED_INTERRUPT  *Resolved;
+  BOOLEAN             Cached;
+  BOOLEAN             Retried;
+  VOID                *Parent;
+
+  Retried = FALSE;
+
+Retry:
+  Status = DeviceInterruptsGet (This, &Device, &Cached);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  if (Index >= Device->Count) {
+    DEBUG ((DEBUG_ERROR, "%a: Index %u is out of bounds\n", __func__, Index));
+    Status = EFI_NOT_FOUND;
+    goto Exit;
+  }
+
+  Resolved = &Device->Interrupts[Index];
+  Status   = Resolved->Status;
+  if (EFI_ERROR (Status)) {
+    goto Exit;
+  }
+
+  if (Cached) {
+    //
+    // The interrupt controller may have been removed (and maybe
+    // re-added) since.
+    //
+    Status = gBS->HandleProtocol (Resolved->ParentHandle, &gEfiDtIoProtocolGuid, &Parent);
+    if (EFI_ERROR (Status) || (Parent != Resolved->Parent)) {
+      DeviceInterruptsDrop (Device);
+      if (Retried) {
+        return EFI_NOT_FOUND;
+      }
+
+      Retried = TRUE;
+      goto Retry;
+    }
+  }
+
+  *InterruptParent = Resolved->ParentHandle;
+  *Interrupt       = Resolved->Interrupt;
+  Status           = EFI_SUCCESS;
+
+Exit:
+  if (!Cached) {
+    FreePool (Device);
+  }
+
+  return Status;
+}